@@ -0,0 +1,231 @@
+//Batch decoder for long ground-station recordings. Every file is cut into overlapping chunks and each chunk runs
+//through a bank of AFSKDemodulator variants (mark/space weighting, correlator length, DPLL sample phase), one
+//(chunk, variant) task at a time on a work-stealing thread pool. The union of the good frames is printed in
+//time order, with copies of the same frame found by several variants or in two overlapping chunks merged.
+#include "demod.h"
+#include "monitor.h"
+#include "wav.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <math.h>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+static const double CHUNK_SECONDS = 60;
+//longer than the biggest frame (AFSK_RX_MAX_FRAME bytes with worst case stuffing) plus DPLL acquisition, so
+//every frame lies whole inside at least one chunk
+static const double OVERLAP_SECONDS = 4;
+//decodes of the same bytes whose ends are this close are one transmission
+static const int DUPLICATE_BITS = 16;
+
+struct Variant {
+    uint16_t markGain; //256 = flat; the transmitter's PREEMPHASIS_RATIO twist is undone by 1/ratio^2 = 455
+    uint8_t windowPercent; //correlator length relative to one bit: shorter is a wider filter (capped at AFSK_RX_MAX_WINDOW)
+    int32_t samplePhase;
+};
+
+static std::vector<Variant> variantBank() {
+    static const uint16_t gains[] = {256, 455, 1024};
+    static const uint8_t windows[] = {100, 75, 125};
+    static const int32_t phases[] = {0, -0x20000000, 0x20000000}; //centre and +-1/8 bit
+    std::vector<Variant> bank;
+    for(uint16_t gain : gains) {
+        for(uint8_t window : windows) {
+            for(int32_t phase : phases) {
+                bank.push_back({gain, window, phase});
+            }
+        }
+    }
+    return bank;
+}
+
+struct Recording {
+    const char* path;
+    std::vector<int16_t> samples;
+    uint32_t rate;
+};
+
+struct Task {
+    int recording;
+    size_t start;
+    int variant;
+};
+
+struct Decode {
+    int recording;
+    size_t end; //sample index of the closing flag
+    uint64_t variants; //bit per bank entry that found it, so the bank holds at most 64
+    std::vector<uint8_t> frame;
+};
+
+//One deque per worker: the owner takes from the back, idle workers steal from the front
+class WorkQueue
+{
+public:
+    void push(const Task& task) {
+        std::lock_guard<std::mutex> guard(lock);
+        tasks.push_back(task);
+    }
+    bool pop(Task& task) {
+        std::lock_guard<std::mutex> guard(lock);
+        if(tasks.empty()) return false;
+        task = tasks.back();
+        tasks.pop_back();
+        return true;
+    }
+    bool steal(Task& task) {
+        std::lock_guard<std::mutex> guard(lock);
+        if(tasks.empty()) return false;
+        task = tasks.front();
+        tasks.pop_front();
+        return true;
+    }
+private:
+    std::mutex lock;
+    std::deque<Task> tasks;
+};
+
+static std::vector<Recording> recordings;
+static std::vector<Variant> bank;
+
+static void runTask(const Task& task, std::vector<Decode>& found) {
+    const Recording& recording = recordings[task.recording];
+    const Variant& variant = bank[task.variant];
+    AFSKDemodConfig config = AFSK_DEMOD_DEFAULTS;
+    config.sampleRate = recording.rate;
+    config.window = (recording.rate * variant.windowPercent + AFSK_RX_BIT_RATE * 50) / (AFSK_RX_BIT_RATE * 100);
+    config.markGain = variant.markGain;
+    config.samplePhase = variant.samplePhase;
+    AFSKDemodulator demod(config);
+    const size_t chunk = (size_t) ((CHUNK_SECONDS + OVERLAP_SECONDS) * recording.rate);
+    const size_t end = std::min(recording.samples.size(), task.start + chunk);
+    for(size_t i = task.start; i < end; i++) {
+        if(demod.process(recording.samples[i])) {
+            found.push_back({task.recording, i, 1ull << task.variant, std::vector<uint8_t>(demod.frame(), demod.frame() + demod.frameLength())});
+        }
+    }
+}
+
+static void worker(std::vector<WorkQueue>& queues, int self, std::vector<Decode>& found) {
+    Task task;
+    for(;;) {
+        bool got = queues[self].pop(task);
+        for(size_t i = 1; !got && i < queues.size(); i++) {
+            got = queues[(self + i) % queues.size()].steal(task);
+        }
+        if(!got) {
+            return; //every task is queued up front, so an empty pool means the work is done
+        }
+        runTask(task, found);
+    }
+}
+
+//Sorts by content then time and folds copies of a frame that end within DUPLICATE_BITS of each other
+static std::vector<Decode> merge(std::vector<Decode>& decodes) {
+    std::sort(decodes.begin(), decodes.end(), [](const Decode& a, const Decode& b) {
+        if(a.recording != b.recording) return a.recording < b.recording;
+        if(a.frame != b.frame) return a.frame < b.frame;
+        return a.end < b.end;
+    });
+    std::vector<Decode> unique;
+    for(Decode& decode : decodes) {
+        if(!unique.empty()) {
+            Decode& last = unique.back();
+            const size_t tolerance = (size_t) recordings[decode.recording].rate * DUPLICATE_BITS / AFSK_RX_BIT_RATE;
+            if(last.recording == decode.recording && last.frame == decode.frame && decode.end - last.end <= tolerance) {
+                last.variants |= decode.variants;
+                continue;
+            }
+        }
+        unique.push_back(std::move(decode));
+    }
+    std::sort(unique.begin(), unique.end(), [](const Decode& a, const Decode& b) {
+        return a.recording != b.recording ? a.recording < b.recording : a.end < b.end;
+    });
+    return unique;
+}
+
+static void usage() {
+    fprintf(stderr, "usage: aprs_batch [-j threads] [-v] <recording.wav>...\n"
+                    "  -j  worker threads, default one per core\n"
+                    "  -v  also report how many frames each demodulator variant found\n");
+}
+
+int main(int argc, char** argv) {
+    int threads = std::thread::hardware_concurrency();
+    bool verbose = false;
+    int arg = 1;
+    for(; arg < argc && argv[arg][0] == '-'; arg++) {
+        if(strcmp(argv[arg], "-j") == 0 && arg + 1 < argc) {
+            threads = atoi(argv[++arg]);
+        } else if(strcmp(argv[arg], "-v") == 0) {
+            verbose = true;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if(arg >= argc || threads < 1) {
+        usage();
+        return 2;
+    }
+    double seconds = 0;
+    for(; arg < argc; arg++) {
+        Recording recording;
+        recording.path = argv[arg];
+        if(!wav_read(recording.path, recording.samples, recording.rate)) {
+            fprintf(stderr, "aprs_batch: could not read %s\n", recording.path);
+            return 1;
+        }
+        seconds += (double) recording.samples.size() / recording.rate;
+        recordings.push_back(std::move(recording));
+    }
+    bank = variantBank();
+
+    std::vector<WorkQueue> queues(threads);
+    int next = 0;
+    for(size_t r = 0; r < recordings.size(); r++) {
+        const size_t step = (size_t) (CHUNK_SECONDS * recordings[r].rate);
+        for(size_t start = 0; start < recordings[r].samples.size(); start += step) {
+            for(size_t v = 0; v < bank.size(); v++) {
+                queues[next++ % threads].push({(int) r, start, (int) v});
+            }
+        }
+    }
+
+    const std::chrono::steady_clock::time_point began = std::chrono::steady_clock::now();
+    std::vector<std::vector<Decode>> found(threads);
+    std::vector<std::thread> pool;
+    for(int i = 0; i < threads; i++) {
+        pool.emplace_back(worker, std::ref(queues), i, std::ref(found[i]));
+    }
+    std::vector<Decode> decodes;
+    for(int i = 0; i < threads; i++) {
+        pool[i].join();
+        decodes.insert(decodes.end(), std::make_move_iterator(found[i].begin()), std::make_move_iterator(found[i].end()));
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - began).count();
+
+    const std::vector<Decode> frames = merge(decodes);
+    for(const Decode& decode : frames) {
+        const double at = (double) decode.end / recordings[decode.recording].rate;
+        printf("%s %02d:%02d:%05.2f ", recordings[decode.recording].path, (int) at / 3600, (int) at / 60 % 60, fmod(at, 60));
+        monitor_print(stdout, decode.frame.data(), decode.frame.size());
+    }
+    if(verbose) {
+        for(size_t v = 0; v < bank.size(); v++) {
+            int count = 0;
+            for(const Decode& decode : frames) count += (decode.variants >> v) & 1;
+            fprintf(stderr, "variant gain %4u window %3u%% phase %+.3f bit: %d frames\n", bank[v].markGain,
+                    bank[v].windowPercent, bank[v].samplePhase / 4294967296.0, count);
+        }
+    }
+    fprintf(stderr, "%u frames from %.0f s of audio in %.2f s on %d threads (%.0fx real time)\n",
+            (unsigned) frames.size(), seconds, elapsed, threads, seconds / elapsed);
+    return 0;
+}
@@ -0,0 +1,351 @@
+//Host benchmarks for the modem hot paths: whole-frame encoding, APRS::loadByte, radioISR, the block producer,
+//FX.25 wrapping and the receive demodulator.
+//Numbers are host nanoseconds, useful for tracking regressions between commits rather than as Teensy timings.
+#include "afsk.h"
+#include "aprs.h"
+#include "aprs_parse.h"
+#include "telemetry.h"
+#include "profile.h"
+#include "golden/golden_vectors.h"
+#include "dra818_sim.h"
+#include <string>
+#include <vector>
+#include <chrono>
+
+void radioISR();
+
+typedef std::chrono::steady_clock benchClock;
+
+static double elapsedNs(benchClock::time_point start) {
+    return std::chrono::duration<double, std::nano>(benchClock::now() - start).count();
+}
+
+static void report(const char* name, double value, const char* unit) {
+    printf("%-28s %12.1f %s\n", name, value, unit);
+}
+
+class APRSBench
+{
+public:
+    APRSBench(APRS* a) : aprs(a) {}
+
+    //Encodes the frame the modulator benchmarks play, leaving it in aprs->packet_buffer
+    void encodeFrame() {
+        aprs->sendPacketNoGPS(String("Do not go gentle into that good night, old age should burn and rave at close of day"));
+        afsk_cancel();
+    }
+
+    //Same encoder reset the send* entry points perform before loading a frame
+    void beginFrame() {
+        aprs->beginPacket();
+    }
+
+    double framesPerSecond(int frames) {
+        benchClock::time_point start = benchClock::now();
+        for(int i = 0; i < frames; i++) {
+            aprs->sendPacketGPS(16, 12, 30, 37.4275f, -122.1697f, 1234.5f, 90, 12.0f, "ABCDEFGHIJKLMNOPQRSTUVWXYZ");
+            afsk_cancel();
+        }
+        return frames / (elapsedNs(start) * 1e-9);
+    }
+
+    //The integer form the float one now converts to: no floating point or printf left on the frame build
+    double integerFramesPerSecond(int frames) {
+        benchClock::time_point start = benchClock::now();
+        for(int i = 0; i < frames; i++) {
+            aprs->sendPacketGPSFixed(16, 12, 30, 374275000, -1221697000, 1234, 90, 12, "ABCDEFGHIJKLMNOPQRSTUVWXYZ");
+            afsk_cancel();
+        }
+        return frames / (elapsedNs(start) * 1e-9);
+    }
+
+    //Compressed position with base-91 telemetry in the comment, no String or printf on the way
+    double telemetryFramesPerSecond(int frames) {
+        static const SSID station = {"KM6HBK", 11};
+        Telemetry telemetry(aprs, station);
+        telemetry.setDefinitionInterval(0);
+        int32_t values[APRS_TELEMETRY_CHANNELS] = {199, 0, 255, 73, 123};
+        benchClock::time_point start = benchClock::now();
+        for(int i = 0; i < frames; i++) {
+            values[0] = i & 0xFF;
+            telemetry.setChannels(values, APRS_TELEMETRY_CHANNELS, i);
+            aprs->sendPacketCompressedFixed(16, 12, 30, 374275000, -1221697000, 1234, 90, 12, telemetry.comment("ABCDEFGHIJKLMNOPQRSTUVWXYZ"));
+            afsk_cancel();
+        }
+        return frames / (elapsedNs(start) * 1e-9);
+    }
+
+    double nsPerLoadByte(int frames) {
+        const int bytesPerFrame = 200;
+        benchClock::time_point start = benchClock::now();
+        for(int f = 0; f < frames; f++) {
+            beginFrame();
+            for(int i = 0; i < bytesPerFrame; i++) {
+                aprs->loadByte('A' + (i % 58)); //printable payload with a realistic stuffing rate
+            }
+        }
+        return elapsedNs(start) / ((double) frames * bytesPerFrame);
+    }
+
+    double nsPerISRSample(int frames) {
+        encodeFrame();
+        const int samplesPerFrame = aprs->getPacketSize() * SAMPLES_PER_BIT;
+        benchClock::time_point start = benchClock::now();
+        for(int f = 0; f < frames; f++) {
+            afsk_modulate_packet(aprs->packet_buffer, aprs->getPacketSize(), 0);
+            for(int i = 0; i < samplesPerFrame; i++) {
+                radioISR();
+            }
+        }
+        const double ns = elapsedNs(start) / ((double) frames * samplesPerFrame);
+        afsk_cancel();
+        return ns;
+    }
+
+    //The block producer on its own, as the BLOCK/DMA pipelines run it
+    double nsPerBlockSample(int frames) {
+        static uint16_t block[AFSK_BLOCK_SAMPLES];
+        encodeFrame();
+        long samples = 0;
+        benchClock::time_point start = benchClock::now();
+        for(int f = 0; f < frames; f++) {
+            afsk_modulate_packet(aprs->packet_buffer, aprs->getPacketSize(), 0);
+            afsk_cancel();
+            int produced;
+            do {
+                produced = afsk_fill_block(block, AFSK_BLOCK_SAMPLES);
+                samples += produced;
+            } while(produced == AFSK_BLOCK_SAMPLES);
+        }
+        return elapsedNs(start) / samples;
+    }
+
+    //Receive demodulator over the DAC output of the benchmark frame, converted to signed PCM
+    double nsPerDemodSample(int frames) {
+        static uint16_t block[AFSK_BLOCK_SAMPLES];
+        static int16_t pcm[BUFFER_SIZE_MAX * 8 * SAMPLES_PER_BIT];
+        encodeFrame();
+        afsk_modulate_packet(aprs->packet_buffer, aprs->getPacketSize(), 0);
+        afsk_cancel();
+        int count = 0, produced;
+        do {
+            produced = afsk_fill_block(block, AFSK_BLOCK_SAMPLES);
+            for(int i = 0; i < produced; i++) {
+                pcm[count++] = (block[i] - AFSK_IDLE_LEVEL) << (16 - SINE_WAVE_RESOLUTION);
+            }
+        } while(produced == AFSK_BLOCK_SAMPLES);
+        AFSKDemodConfig config = AFSK_DEMOD_DEFAULTS;
+        config.sampleRate = SAMPLE_RATE;
+        AFSKDemodulator demod(config);
+        for(int i = 0; i < count; i++) {
+            demod.process(pcm[i]); //lock the DPLL first, the frame only starts with N_HDLC_FLAGS flags
+        }
+        const uint32_t warmup = demod.frames();
+        benchClock::time_point start = benchClock::now();
+        for(int f = 0; f < frames; f++) {
+            for(int i = 0; i < count; i++) {
+                demod.process(pcm[i]);
+            }
+        }
+        const double ns = elapsedNs(start) / ((double) frames * count);
+        if(demod.frames() - warmup != (uint32_t) frames) {
+            fprintf(stderr, "demodulator decoded %u of %d frames\n", (unsigned) (demod.frames() - warmup), frames);
+        }
+        return ns;
+    }
+
+    //Channel time of a position + telemetry + status burst, from key-up to unkey, on the simulated clock
+    double burstAirtimeMs() {
+        const uint32_t start = micros();
+        aprs->sendPacketGPS(16, 12, 30, 37.4275f, -122.1697f, 1234.5f, 90, 12.0f, "balloon 1");
+        aprs->sendPacketNoGPS(String("T#005,199,000,255,073,123,01101001"));
+        aprs->sendPacketNoGPS(String(">Float altitude reached"));
+        host_run_timers();
+        return (micros() - start) / 1000.0;
+    }
+
+private:
+    APRS* aprs;
+};
+
+class CountingHandler : public APRSHandler
+{
+public:
+    CountingHandler() : total(0) {}
+    void position(const AX25Frame& frame, const APRSPosition& position) { total += position.latitude; }
+    void status(const AX25Frame& frame, const APRSStatus& status) { total += status.text.length; }
+    void telemetry(const AX25Frame& frame, const APRSTelemetry& telemetry) { total += telemetry.analog[0]; }
+    void message(const AX25Frame& frame, const APRSMessage& message) { total += message.text.length; }
+    int64_t total;
+};
+
+//AX25Frame::parse + aprs_dispatch over a mix of position, status, telemetry and message frames
+static double parsedFramesPerSecond(int rounds) {
+    static const char* infos[] = {
+        "/161230z3725.65N/12210.18WO090/012/A=004050balloon 1",
+        "=/5L!!<*e7>7P[",
+        ">Float altitude reached",
+        "T#005,199,000,255,073,123,01101001",
+        ":KM6HBK-11:PARM.Battery,Temp{12"
+    };
+    static const SSID path[] = {{"APRS", 0}, {"KM6HBK", 11}, {"WIDE2", 1}};
+    static const AX25Header header = ax25_header(path);
+    uint8_t frames[5][AFSK_RX_MAX_FRAME];
+    int lengths[5];
+    for(int i = 0; i < 5; i++) {
+        memcpy(frames[i], header.address, header.addressLength);
+        frames[i][header.addressLength] = AX25_CONTROL_UI;
+        frames[i][header.addressLength + 1] = AX25_PID_NO_LAYER3;
+        memcpy(frames[i] + header.addressLength + 2, infos[i], strlen(infos[i]));
+        lengths[i] = header.addressLength + 2 + strlen(infos[i]);
+    }
+    CountingHandler handler;
+    benchClock::time_point start = benchClock::now();
+    for(int r = 0; r < rounds; r++) {
+        for(int i = 0; i < 5; i++) {
+            AX25Frame frame;
+            if(frame.parse(frames[i], lengths[i])) {
+                aprs_dispatch(frame, handler);
+            }
+        }
+    }
+    const double perSecond = rounds * 5 / (elapsedNs(start) * 1e-9);
+    if(handler.total == 0) printf("(nothing parsed)\n"); //keeps the work observable
+    return perSecond;
+}
+
+//Encodes the golden vector corpus (every path shape and stuffing pattern the conformance suite checks) through
+//the cached-header path, as frames/s, and the encoded line rate in Mbit/s
+static double corpusFramesPerSecond(DRA818V* radio, int rounds, double* mbitPerSecond) {
+    const int count = sizeof(GOLDEN_VECTORS) / sizeof(GOLDEN_VECTORS[0]);
+    std::vector<std::vector<std::string>> calls(count);
+    std::vector<std::vector<SSID>> paths(count);
+    std::vector<std::string> infos;
+    for(int v = 0; v < count; v++) {
+        std::string path = GOLDEN_VECTORS[v].path;
+        for(size_t start = 0; start <= path.size();) {
+            size_t comma = path.find(',', start);
+            if(comma == std::string::npos) comma = path.size();
+            const std::string entry = path.substr(start, comma - start);
+            calls[v].push_back(entry.substr(0, entry.find('-')));
+            paths[v].push_back({0, (uint8_t) atoi(entry.c_str() + entry.find('-') + 1)});
+            start = comma + 1;
+        }
+        for(size_t i = 0; i < calls[v].size(); i++) paths[v][i].address = calls[v][i].c_str();
+        infos.push_back(std::string(GOLDEN_VECTORS[v].info, GOLDEN_VECTORS[v].infoLength));
+    }
+    std::vector<APRS> encoders;
+    encoders.reserve(count);
+    for(int v = 0; v < count; v++) encoders.emplace_back(radio, paths[v].data(), paths[v].size());
+    long bits = 0;
+    benchClock::time_point start = benchClock::now();
+    for(int r = 0; r < rounds; r++) {
+        for(int v = 0; v < count; v++) {
+            encoders[v].sendPacketNoGPS((char*) infos[v].c_str());
+            bits += encoders[v].getPacketSize();
+            afsk_cancel();
+        }
+    }
+    const double seconds = elapsedNs(start) * 1e-9;
+    *mbitPerSecond = bits / seconds * 1e-6;
+    return rounds * count / seconds;
+}
+
+//Mean channel switch on the simulated module, from tune() to tuned(), in simulated ms; the blocking
+//configSettings() this replaced spent 1500 ms in delay() alone
+static double retuneLatencyMs(int switches) {
+    static const DRA818Channel plan[] = {
+        {144390000, 144390000, "0000", "0000", true},
+        {145825000, 145825000, "0000", "0000", true}
+    };
+    DRA818Sim sim;
+    host_set_serial_peer(&sim);
+    DRA818V radio(PTT_PIN, AUDIO_PIN, MIC_PIN, DRATX, DRARX);
+    radio.setChannels(plan, 2);
+    radio.init();
+    while(radio.poll() == DRA818_BUSY) delay(1);
+    uint32_t total = 0;
+    for(int i = 0; i < switches; i++) {
+        const uint8_t channel = (i + 1) & 1;
+        const uint32_t start = millis();
+        radio.tune(channel);
+        while(!radio.tuned(channel)) {
+            radio.poll();
+            delay(1);
+        }
+        total += millis() - start;
+    }
+    host_set_serial_peer(0);
+    return (double) total / switches;
+}
+
+//Cost of rendering one DMOSETGROUP, which the channel plan pays once per channel instead of per retune
+static double nsPerGroupCommand(int commands) {
+    char command[DRA818_COMMAND_MAX];
+    int length = 0;
+    benchClock::time_point start = benchClock::now();
+    for(int i = 0; i < commands; i++) {
+        length += dra818_group_command(command, true, 144390000 + (i & 7) * 12500, 144390000, "0000", 1, "0000");
+    }
+    const double ns = elapsedNs(start) / commands;
+    if(length == 0) printf("(nothing rendered)\n");
+    return ns;
+}
+
+//Wrapping the largest frame the biggest 64 check byte code holds, RS(255,191): the most parity work per frame
+static double nsPerFX25Frame(int frames) {
+    static uint8_t bits[BUFFER_SIZE_MAX];
+    const int frameBits = 191 * 8 - 3;
+    int total = 0;
+    benchClock::time_point start = benchClock::now();
+    for(int f = 0; f < frames; f++) {
+        for(int i = 0; i < 191; i++) bits[i] = 'A' + (i + f) % 58;
+        total += fx25_wrap(bits, frameBits, sizeof(bits), FX25_CHECK_64);
+    }
+    const double ns = elapsedNs(start) / frames;
+    if(total <= 0) printf("(nothing wrapped)\n");
+    return ns;
+}
+
+static void discardDAC(uint8_t pin, int value) {
+    (void) pin;
+    (void) value;
+}
+
+int main(int argc, char** argv) {
+    const int scale = argc > 1 ? atoi(argv[1]) : 1; //multiply iteration counts for steadier numbers
+    SSID ssids[] = {
+        {(char*) "APRS", 0},
+        {(char*) "KM6HBK", 11},
+        {(char*) "WIDE2", 1}
+    };
+    host_set_serial_echo(false);
+    host_set_analog_write_hook(discardDAC);
+    DRA818V radio(PTT_PIN, AUDIO_PIN, MIC_PIN, DRATX, DRARX);
+    APRS aprs(&radio, ssids, sizeof(ssids) / sizeof(ssids[0]));
+    APRSBench bench(&aprs);
+    profile_begin();
+
+    report("sendPacketGPS frames", bench.framesPerSecond(20000 * scale), "frames/s");
+    report("sendPacketGPS integer frames", bench.integerFramesPerSecond(20000 * scale), "frames/s");
+    double mbit = 0;
+    report("golden corpus frames", corpusFramesPerSecond(&radio, 5000 * scale, &mbit), "frames/s");
+    report("golden corpus encoded", mbit, "Mbit/s");
+    report("compressed + telemetry", bench.telemetryFramesPerSecond(20000 * scale), "frames/s");
+    const double nsPerByte = bench.nsPerLoadByte(2000 * scale);
+    report("APRS::loadByte", nsPerByte, "ns/byte");
+    report("APRS::loadByte per bit", nsPerByte / 8, "ns/bit");
+    report("radioISR", bench.nsPerISRSample(200 * scale), "ns/sample");
+    report("afsk_fill_block", bench.nsPerBlockSample(200 * scale), "ns/sample");
+    report("AFSKDemodulator::process", bench.nsPerDemodSample(200 * scale), "ns/sample");
+    report("fx25_wrap RS(255,191)", nsPerFX25Frame(20000 * scale), "ns/frame");
+    report("parse + aprs_dispatch", parsedFramesPerSecond(200000 * scale), "frames/s");
+    report("3-frame burst airtime", bench.burstAirtimeMs(), "ms");
+    report("DRA818 retune (simulated)", retuneLatencyMs(20), "ms");
+    report("dra818_group_command", nsPerGroupCommand(200000 * scale), "ns/command");
+#if APRS_PROFILE
+    host_set_serial_echo(true);
+    profile_dump(Serial); //built with DEFS=-DAPRS_PROFILE=1: per probe stats of everything above
+#endif
+    return 0;
+}
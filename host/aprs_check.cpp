@@ -0,0 +1,1502 @@
+//Host self-checks for the library: run with `make check`.
+#include "afsk.h"
+#include "aprs.h"
+#include "crc16.h"
+#include "hdlc.h"
+#include "aprs_parse.h"
+#include "digipeater.h"
+#include "telemetry.h"
+#include "scheduler.h"
+#include "profile.h"
+#include "dra818_sim.h"
+#include <algorithm>
+#include <math.h>
+#include <map>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if(!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while(0)
+
+static uint16_t crcBitSerial(uint16_t crc, const uint8_t* data, size_t length) {
+    for(size_t i = 0; i < length; i++) {
+        uint8_t byte = data[i];
+        for(int j = 0; j < 8; j++) {
+            crc = crc16_update_bit(crc, byte & 1);
+            byte >>= 1;
+        }
+    }
+    return crc;
+}
+
+static void checkCRC() {
+    const uint8_t check[] = "123456789";
+    CHECK((uint16_t) ~crc16_update(CRC16_INIT, check, 9) == 0x906E); //CRC-16/X.25 catalogue check value
+    for(int i = 0; i < 256; i++) {
+        const uint8_t byte = i;
+        CHECK(crc16_update_byte(0x0000, byte) == crcBitSerial(0x0000, &byte, 1));
+        CHECK(crc16_update_byte(0xFFFF, byte) == crcBitSerial(0xFFFF, &byte, 1));
+    }
+    uint8_t data[300];
+    uint32_t seed = 1;
+    for(int trial = 0; trial < 200; trial++) {
+        const size_t length = trial % sizeof(data);
+        for(size_t i = 0; i < length; i++) {
+            seed = seed * 1103515245 + 12345;
+            data[i] = seed >> 16;
+        }
+        CHECK(crc16_update(CRC16_INIT, data, length) == crcBitSerial(CRC16_INIT, data, length));
+    }
+}
+
+//Bit-at-a-time HDLC reference: flags raw, data bytes LSB first with a zero after five ones, FCS complemented
+class ReferenceHDLC
+{
+public:
+    ReferenceHDLC() : size(0), ones(0), crc(CRC16_INIT) { memset(bytes, 0, sizeof(bytes)); }
+    void bit(int b) {
+        if(b) bytes[size / 8] |= 0x80 >> (size % 8);
+        size++;
+    }
+    void flag() {
+        for(int i = 0; i < 8; i++) bit((HDLC_FLAG >> i) & 1);
+        ones = 0;
+    }
+    void byte(uint8_t value, bool fcs = true) {
+        if(fcs) crc = crcBitSerial(crc, &value, 1);
+        for(int i = 0; i < 8; i++) {
+            const int b = (value >> i) & 1;
+            bit(b);
+            ones = b ? ones + 1 : 0;
+            if(ones == BIT_STUFF_THRESHOLD) {
+                bit(0);
+                ones = 0;
+            }
+        }
+    }
+    void footer() {
+        const uint16_t fcs = ~crc;
+        byte(fcs & 0xFF, false);
+        byte(fcs >> 8, false);
+        flag();
+    }
+    uint8_t bytes[1024];
+    int size;
+private:
+    int ones;
+    uint16_t crc;
+};
+
+static void checkStuffing() {
+    static uint8_t out[1024];
+    uint32_t seed = 7;
+    for(int trial = 0; trial < 500; trial++) {
+        ReferenceHDLC reference;
+        HDLCEncoder encoder;
+        memset(out, 0xA5, sizeof(out)); //stale contents must not leak into the stream
+        encoder.begin(out, sizeof(out));
+        const int flags = 1 + trial % 3;
+        for(int i = 0; i < flags; i++) {
+            reference.flag();
+            encoder.loadFlag();
+        }
+        const int length = trial % 300;
+        for(int i = 0; i < length; i++) {
+            seed = seed * 1103515245 + 12345;
+            //every third frame is biased towards 0xFF runs to force heavy stuffing
+            const uint8_t byte = (trial % 3 == 0) ? ((seed >> 16) | 0xF7) : (seed >> 16);
+            reference.byte(byte);
+            encoder.loadByte(byte);
+        }
+        reference.footer();
+        encoder.loadFCS();
+        encoder.loadFlag();
+        const int bits = encoder.finish();
+        CHECK(bits == reference.size);
+        CHECK(memcmp(out, reference.bytes, (bits + 7) / 8) == 0);
+    }
+}
+
+//Frequency of a steady tone from its upward mid-scale crossings, each interpolated between samples
+static double measureTone(const uint16_t* samples, int count, uint32_t rate) {
+    const double mid = AFSK_IDLE_LEVEL - 0.5;
+    double first = -1, last = -1;
+    int cycles = -1;
+    for(int i = 1; i < count; i++) {
+        if(samples[i - 1] < mid && samples[i] >= mid) {
+            last = i - 1 + (mid - samples[i - 1]) / (samples[i] - samples[i - 1]);
+            if(first < 0) first = last;
+            cycles++;
+        }
+    }
+    return cycles * (double) rate / (last - first);
+}
+
+template <class M>
+static double toneError(uint8_t firstByte, int freq) {
+    static uint8_t bits[BUFFER_SIZE_MAX];
+    static uint16_t samples[BUFFER_SIZE_MAX * 8 * M::SAMPLES_PER_BIT];
+    memset(bits, 0xFF, sizeof(bits)); //all ones: NRZI keeps the tone selected by the first bit
+    bits[0] = firstByte;
+    M modem;
+    modem.reset();
+    modem.load(bits, sizeof(bits) * 8);
+    int count = 0;
+    while(modem.next(&samples[count])) {
+        count++;
+    }
+    const int skip = 8 * M::SAMPLES_PER_BIT; //skip the first byte
+    return measureTone(samples + skip, count - skip, M::SAMPLE_RATE) - freq;
+}
+
+static void checkToneFrequency() {
+    const double markError = toneError<AFSK1200>(0xFF, MARK_FREQ);
+    const double spaceError = toneError<AFSK1200>(0x7F, SPACE_FREQ);
+    printf("tone error: mark %+.4f Hz, space %+.4f Hz\n", markError, spaceError);
+    CHECK(fabs(markError) < 0.01);
+    CHECK(fabs(spaceError) < 0.01);
+    CHECK(fabs(toneError<AFSK300>(0xFF, HF_MARK_FREQ)) < 0.01);
+    CHECK(fabs(toneError<AFSK300>(0x7F, HF_SPACE_FREQ)) < 0.01);
+}
+
+//G3RUH round trip: slice the shaped output at each bit centre, descramble and NRZI decode it again
+static void checkG3RUH() {
+    static uint8_t bits[BUFFER_SIZE_MAX];
+    static uint16_t samples[(BUFFER_SIZE_MAX * 8 + 2) * G3RUH9600::SAMPLES_PER_BIT];
+    srand(9600);
+    for(size_t i = 0; i < sizeof(bits); i++) {
+        bits[i] = rand();
+    }
+    G3RUH9600 modem;
+    modem.reset();
+    modem.load(bits, sizeof(bits) * 8);
+    int count = 0;
+    while(modem.next(&samples[count])) {
+        count++;
+    }
+    CHECK(count == (int) sizeof(bits) * 8 * (int) G3RUH9600::SAMPLES_PER_BIT);
+    uint32_t descrambler = 0;
+    int previous = 1;
+    int errors = 0;
+    //the shaping window delays the output by one bit: bit k is centred in bit period k + 1
+    for(int k = 0; k + 1 < (int) sizeof(bits) * 8; k++) {
+        const int line = samples[(k + 1) * G3RUH9600::SAMPLES_PER_BIT + G3RUH9600::SAMPLES_PER_BIT / 2] >= AFSK_IDLE_LEVEL;
+        const int nrzi = (line ^ (descrambler >> 11) ^ (descrambler >> 16)) & 1;
+        descrambler = (descrambler << 1) | line;
+        const int bit = nrzi == previous;
+        previous = nrzi;
+        errors += bit != ((bits[k >> 3] >> (7 - (k & 7))) & 1);
+    }
+    CHECK(errors == 0);
+}
+
+static constexpr SSID checkPath[] = {
+    {"APRS", 0},
+    {"KM6HBK", 11},
+    {"WIDE2", 1}
+};
+static constexpr AX25Header checkHeader = ax25_header(checkPath); //built by the compiler
+static_assert(checkHeader.addressLength == 3 * AX25_ADDRESS_LENGTH, "constexpr header has the wrong address field");
+
+//Encodes a frame through APRS and returns its queued bitstream
+static const TxFrame* sendAndPeek(APRS& aprs, const char* info) {
+    afsk_cancel();
+    aprs.sendPacketNoGPS((char*) info);
+    return txQueue.front();
+}
+
+//The cached header (runtime and compile time) must produce the same frame as encoding it from scratch
+static void checkHeaderCache() {
+    DRA818V radio(PTT_PIN, AUDIO_PIN, MIC_PIN, DRATX, DRARX);
+    SSID path[] = {
+        {(char*) "APRS", 0},
+        {(char*) "KM6HBK", 11},
+        {(char*) "WIDE2", 1}
+    };
+    APRS runtime(&radio, path, 3);
+    APRS prebuilt(&radio, &checkHeader);
+    const char* infos[] = {"", ">x", "!\xff\xff\xff\xfe", "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"};
+    for(const char* info : infos) {
+        ReferenceHDLC reference;
+        for(int i = 0; i < N_HDLC_FLAGS; i++) reference.flag();
+        for(int i = 0; i < 3; i++) {
+            int j = 0;
+            for(; checkPath[i].address[j]; j++) reference.byte(checkPath[i].address[j] << 1);
+            for(; j < AX25_CALLSIGN_LENGTH; j++) reference.byte(' ' << 1);
+            reference.byte(('0' + checkPath[i].ssid_designator) << 1 | (i == 2));
+        }
+        reference.byte(AX25_CONTROL_UI);
+        reference.byte(AX25_PID_NO_LAYER3);
+        for(const char* c = info; *c; c++) reference.byte(*c);
+        reference.footer();
+
+        const TxFrame* frame = sendAndPeek(runtime, info);
+        CHECK(frame && frame->size == reference.size && memcmp(frame->bits, reference.bytes, (reference.size + 7) / 8) == 0);
+        frame = sendAndPeek(prebuilt, info);
+        CHECK(frame && frame->size == reference.size && memcmp(frame->bits, reference.bytes, (reference.size + 7) / 8) == 0);
+    }
+
+    //a per-packet destination (Mic-E) keeps the opening flags the header was built with
+    static constexpr AX25Header moreFlags = ax25_header(checkPath, 3, N_HDLC_FLAGS + 2);
+    APRS flagged(&radio, &moreFlags);
+    afsk_cancel();
+    CHECK(prebuilt.sendPacketMicE(334273333, -1121290000, 61, 251, 20, MICE_RETURNING, "hi"));
+    const TxFrame plain = *txQueue.front();
+    afsk_cancel();
+    CHECK(flagged.sendPacketMicE(334273333, -1121290000, 61, 251, 20, MICE_RETURNING, "hi"));
+    const TxFrame* frame = txQueue.front();
+    CHECK(frame && frame->size == plain.size + 16 && frame->bits[0] == HDLC_FLAG && frame->bits[1] == HDLC_FLAG);
+    CHECK(frame && memcmp(frame->bits + 2, plain.bits, (plain.size + 7) / 8) == 0);
+    afsk_cancel();
+}
+
+//The pin the selected Sink drives with analogWrite. Each sample is one write and idle() parks it with one more;
+//the PCM sink writes to its stream instead, and parks with nothing.
+#if AFSK_SINK == AFSK_SINK_PWM
+static const uint8_t SINK_PIN = PWM_PIN;
+#else
+static const uint8_t SINK_PIN = MIC_PIN;
+#endif
+static const long SINK_PARK_WRITES = AFSK_SINK == AFSK_SINK_PCM ? 0 : 1;
+
+static long sinkSamples = 0;
+
+static void countSink(uint8_t pin, int value) {
+    (void) value;
+    if(pin == SINK_PIN) sinkSamples++;
+}
+
+static std::vector<int> pwmWrites;
+
+static void recordPWM(uint8_t pin, int value) {
+    if(pin == PWM_PIN) pwmWrites.push_back(value);
+}
+
+//The PCM stream sink writes exactly the modulator's samples as 16-bit little-endian PCM; the PWM sink cuts them
+//down to its own resolution and parks at half duty
+static void checkSinks() {
+    typedef PCMStreamSink<SINE_WAVE_RESOLUTION> PCMSink;
+    static const uint8_t bits[] = {0x7E, 0x12, 0xA5, 0xFF, 0x00, 0x7E};
+    FILE* saved = PCMSink::stream;
+    PCMSink::stream = tmpfile();
+    Modem modem;
+    modem.reset();
+    modem.load(bits, sizeof(bits) * 8);
+    CHECK(sink_play<PCMSink>(modem) == sizeof(bits) * 8 * SAMPLES_PER_BIT);
+    PCMSink::idle();
+    rewind(PCMSink::stream);
+    modem.reset();
+    modem.load(bits, sizeof(bits) * 8);
+    uint16_t sample;
+    int mismatches = 0;
+    while(modem.next(&sample)) {
+        const int lo = fgetc(PCMSink::stream);
+        const int hi = fgetc(PCMSink::stream);
+        if((int16_t) (lo | (hi << 8)) != (sample - AFSK_IDLE_LEVEL) << (16 - SINE_WAVE_RESOLUTION)) mismatches++;
+    }
+    CHECK(mismatches == 0);
+    CHECK(fgetc(PCMSink::stream) == EOF);
+    fclose(PCMSink::stream);
+    PCMSink::stream = saved;
+
+    typedef PWMSink<PWM_PIN, SINE_WAVE_RESOLUTION, 8, 187500> PWM;
+    host_set_analog_write_hook(recordPWM);
+    PWM::begin();
+    PWM::write(0);
+    PWM::write((1 << SINE_WAVE_RESOLUTION) - 1);
+    PWM::write(AFSK_IDLE_LEVEL);
+    PWM::idle();
+    CHECK(pwmWrites == std::vector<int>({0, 255, 128, 128}));
+    host_set_analog_write_hook(0);
+}
+
+//Frames sent in a burst share one key-up: TXDELAY flags once, then every frame back to back
+static void checkTransmitQueue() {
+    SSID ssids[] = {
+        {(char*) "APRS", 0},
+        {(char*) "KM6HBK", 11}
+    };
+    DRA818V radio(PTT_PIN, AUDIO_PIN, MIC_PIN, DRATX, DRARX);
+    APRS aprs(&radio, ssids, 2);
+    host_set_analog_write_hook(countSink);
+    sinkSamples = 0;
+#if AFSK_SINK == AFSK_SINK_PCM
+    FILE* const stream = Sink::stream;
+    Sink::stream = tmpfile();
+#endif
+    long bits = TXDELAY_FLAGS * 8;
+    for(int i = 0; i < TX_QUEUE_SLOTS; i++) {
+        CHECK(aprs.sendPacketNoGPS(String(">status")));
+        bits += aprs.getPacketSize();
+    }
+    CHECK(!aprs.sendPacketNoGPS(String(">no free slot")));
+    CHECK(txQueue.queued() == TX_QUEUE_SLOTS);
+    host_run_timers();
+    CHECK(txQueue.queued() == 0);
+    long expected = bits * SAMPLES_PER_BIT;
+#if AFSK_PIPELINE == AFSK_PIPELINE_BLOCK
+    //whatever the DMA pipeline would read past the final block is idle, not a stale block replayed
+    const uint16_t* blocks = afsk_sample_blocks();
+    const long finalBlock = expected / AFSK_BLOCK_SAMPLES % 2;
+    const long packetEnd = finalBlock * AFSK_BLOCK_SAMPLES + expected % AFSK_BLOCK_SAMPLES;
+    for(long i = 0; i < 2 * AFSK_BLOCK_SAMPLES; i++) {
+        const bool packet = i >= finalBlock * AFSK_BLOCK_SAMPLES && i < packetEnd;
+        CHECK(packet || blocks[i] == AFSK_IDLE_LEVEL);
+    }
+    expected = (expected / AFSK_BLOCK_SAMPLES + 1) * AFSK_BLOCK_SAMPLES; //the last block is played out in full
+#endif
+#if AFSK_SINK == AFSK_SINK_PCM
+    sinkSamples = ftell(Sink::stream) / 2;
+    fclose(Sink::stream);
+    Sink::stream = stream;
+#endif
+    CHECK(sinkSamples == expected + SINK_PARK_WRITES); //the output is parked at mid-scale after unkey
+    host_set_analog_write_hook(0);
+}
+
+//Renders frames through a modulator, TXDELAY style flags first and a few after, as signed 16-bit PCM
+template <class M>
+static std::vector<int16_t> renderFrames(const std::vector<TxFrame>& frames) {
+    static const uint8_t flag = HDLC_FLAG;
+    std::vector<int16_t> pcm;
+    M modem;
+    uint16_t sample;
+    modem.reset();
+    for(size_t f = 0; f < frames.size() + 2; f++) {
+        const bool isFrame = f >= 1 && f <= frames.size();
+        for(int i = 0; i < (isFrame ? 1 : 10); i++) {
+            if(isFrame) {
+                modem.load(frames[f - 1].bits, frames[f - 1].size);
+            } else {
+                modem.load(&flag, 8);
+            }
+            while(modem.next(&sample)) {
+                pcm.push_back((sample - AFSK_IDLE_LEVEL) << (15 - SINE_WAVE_RESOLUTION)); //half scale
+            }
+        }
+    }
+    return pcm;
+}
+
+//Whether a received frame (address to FCS) re-encodes to the sent bitstream
+static bool sameFrame(const uint8_t* frame, int length, const TxFrame& sent) {
+    ReferenceHDLC reference;
+    for(int j = 0; j < N_HDLC_FLAGS; j++) reference.flag();
+    for(int j = 0; j < length; j++) reference.byte(frame[j]);
+    reference.footer();
+    return sent.size == reference.size && memcmp(sent.bits, reference.bytes, (sent.size + 7) / 8) == 0;
+}
+
+//Decodes pcm and checks every frame comes back, by re-encoding what was received and comparing bitstreams
+static void checkDecode(const std::vector<int16_t>& pcm, uint32_t rate, const std::vector<TxFrame>& frames) {
+    AFSKDemodConfig config = AFSK_DEMOD_DEFAULTS;
+    config.sampleRate = rate;
+    AFSKDemodulator demod(config);
+    size_t matched = 0;
+    for(size_t i = 0; i < pcm.size(); i++) {
+        if(!demod.process(pcm[i])) {
+            continue;
+        }
+        CHECK(sameFrame(demod.frame(), demod.frameLength(), frames[matched < frames.size() ? matched : 0]));
+        matched++;
+    }
+    CHECK(matched == frames.size());
+    CHECK(demod.fcsErrors() == 0);
+}
+
+static std::vector<int16_t> rxSamples;
+static size_t rxPosition = 0;
+
+//What the AUDIO_PIN interrupt hears, at its own sample rate whatever AFSK_SAMPLE_RATE is
+typedef AFSKModulator<1200, AFSK_RX_SAMPLE_RATE, MARK_FREQ, SPACE_FREQ, SINE_WAVE_RESOLUTION, 75> RxAFSK1200;
+
+static int playADC(uint8_t pin) {
+    (void) pin;
+    const int16_t sample = rxPosition < rxSamples.size() ? rxSamples[rxPosition++] : 0;
+    return (sample >> (16 - AFSK_RX_ADC_RESOLUTION)) + (1 << (AFSK_RX_ADC_RESOLUTION - 1));
+}
+
+//Plays the rest of rxSamples through the ADC interrupt the moment afsk_receive() masks interrupts
+static void receiveInWindow() {
+    host_set_interrupt_hook(0);
+    while(rxPosition < rxSamples.size() && host_timer_step()) {}
+}
+
+//The demodulator against the library's own modulator: clean, with noise, at a higher sample rate and
+//through the AUDIO_PIN sampling interrupt
+static void checkDemodulator() {
+    DRA818V radio(PTT_PIN, AUDIO_PIN, MIC_PIN, DRATX, DRARX);
+    APRS aprs(&radio, &checkHeader);
+    std::vector<TxFrame> frames;
+    std::string info = ">";
+    for(int i = 0; i < 8; i++) {
+        const TxFrame* sent = sendAndPeek(aprs, info.c_str());
+        CHECK(sent);
+        if(sent) frames.push_back(*sent);
+        afsk_cancel();
+        info += std::string(i * 6, '~' - i) + "\x7f\x7e";
+    }
+    const std::vector<int16_t> pcm = renderFrames<AFSK1200>(frames);
+    checkDecode(pcm, AFSK1200::SAMPLE_RATE, frames);
+    checkDecode(renderFrames<AFSKModulator<1200, 38400, MARK_FREQ, SPACE_FREQ, SINE_WAVE_RESOLUTION, 75> >(frames), 38400, frames);
+
+    std::vector<int16_t> noisy = pcm;
+    uint32_t seed = 3;
+    for(size_t i = 0; i < noisy.size(); i++) {
+        int noise = 0;
+        for(int j = 0; j < 4; j++) {
+            seed = seed * 1103515245 + 12345;
+            noise += (int) ((seed >> 16) & 0xFFF) - 2048; //roughly gaussian, about 10 dB below the signal
+        }
+        noisy[i] += noise;
+    }
+    checkDecode(noisy, AFSK1200::SAMPLE_RATE, frames);
+
+    rxSamples = renderFrames<RxAFSK1200>(frames);
+    rxPosition = 0;
+    host_set_analog_read_hook(playADC);
+    afsk_rx_begin();
+    int received = 0;
+    uint8_t frame[AFSK_RX_MAX_FRAME];
+    while(rxPosition < rxSamples.size() && host_timer_step()) {
+        received += afsk_receive(frame, sizeof(frame)) > 0;
+    }
+    afsk_rx_stop();
+    received += afsk_receive(frame, sizeof(frame)) > 0;
+    CHECK(received == (int) frames.size());
+
+    //a frame that completes while afsk_receive() hands out the one before it
+    rxSamples = renderFrames<RxAFSK1200>(std::vector<TxFrame>(frames.begin(), frames.begin() + 1));
+    const size_t firstEnd = rxSamples.size();
+    const std::vector<int16_t> second = renderFrames<RxAFSK1200>(std::vector<TxFrame>(frames.begin() + 1, frames.begin() + 2));
+    rxSamples.insert(rxSamples.end(), second.begin(), second.end());
+    rxPosition = 0;
+    afsk_rx_begin();
+    while(rxPosition < firstEnd && host_timer_step()) {}
+    host_set_interrupt_hook(receiveInWindow);
+    int length = afsk_receive(frame, sizeof(frame));
+    CHECK(rxPosition == rxSamples.size() && sameFrame(frame, length, frames[0]));
+    length = afsk_receive(frame, sizeof(frame));
+    CHECK(sameFrame(frame, length, frames[1]));
+    afsk_rx_stop();
+    host_set_interrupt_hook(0);
+    host_set_analog_read_hook(0);
+}
+
+//Reed-Solomon decoder for the FX.25 codes, independent of the library's tables: GF(256) multiplication by
+//shift and add, syndromes, Berlekamp-Massey, Chien search and Forney (first consecutive root 1). code holds a
+//shortened codeword, first transmitted byte first. Returns the number of bytes corrected, -1 if it can't.
+static uint8_t gfMul(uint8_t a, uint8_t b) {
+    uint8_t product = 0;
+    while(b) {
+        if(b & 1) product ^= a;
+        b >>= 1;
+        a = (a << 1) ^ ((a & 0x80) ? (GF256_POLY & 0xFF) : 0);
+    }
+    return product;
+}
+
+static uint8_t gfPow(uint8_t a, int power) {
+    power %= 255;
+    if(power < 0) power += 255;
+    uint8_t result = 1;
+    while(power--) result = gfMul(result, a);
+    return result;
+}
+
+static uint8_t gfInverse(uint8_t a) {
+    return gfPow(a, 254);
+}
+
+//p(x) at x, p[i] multiplying x^i
+static uint8_t polyEval(const std::vector<uint8_t>& p, uint8_t x) {
+    uint8_t value = 0;
+    for(size_t i = p.size(); i-- > 0;) value = gfMul(value, x) ^ p[i];
+    return value;
+}
+
+static int rsDecode(std::vector<uint8_t>& code, int checkBytes) {
+    const int n = code.size();
+    std::vector<uint8_t> syndromes(checkBytes);
+    bool clean = true;
+    for(int j = 0; j < checkBytes; j++) {
+        uint8_t value = 0;
+        for(int i = 0; i < n; i++) value = gfMul(value, gfPow(2, j + 1)) ^ code[i];
+        syndromes[j] = value;
+        clean &= value == 0;
+    }
+    if(clean) return 0;
+
+    std::vector<uint8_t> locator(1, 1), previous(1, 1);
+    int errors = 0, shift = 1;
+    uint8_t lastDiscrepancy = 1;
+    for(int k = 0; k < checkBytes; k++) {
+        uint8_t discrepancy = syndromes[k];
+        for(int i = 1; i <= errors && i < (int) locator.size(); i++) discrepancy ^= gfMul(locator[i], syndromes[k - i]);
+        if(discrepancy == 0) {
+            shift++;
+            continue;
+        }
+        std::vector<uint8_t> updated = locator;
+        const uint8_t scale = gfMul(discrepancy, gfInverse(lastDiscrepancy));
+        if(updated.size() < previous.size() + shift) updated.resize(previous.size() + shift, 0);
+        for(size_t i = 0; i < previous.size(); i++) updated[i + shift] ^= gfMul(scale, previous[i]);
+        if(2 * errors <= k) {
+            previous = locator;
+            errors = k + 1 - errors;
+            lastDiscrepancy = discrepancy;
+            shift = 1;
+        } else {
+            shift++;
+        }
+        locator = updated;
+    }
+    if(2 * errors > checkBytes) return -1;
+
+    //evaluator: syndromes times locator, mod x^checkBytes; derivative: the odd terms of the locator
+    std::vector<uint8_t> evaluator(checkBytes, 0);
+    for(int i = 0; i < checkBytes; i++) {
+        for(int j = 0; j <= i && j < (int) locator.size(); j++) evaluator[i] ^= gfMul(locator[j], syndromes[i - j]);
+    }
+    std::vector<uint8_t> derivative(locator.size() > 1 ? locator.size() - 1 : 1, 0);
+    for(size_t i = 1; i < locator.size(); i += 2) derivative[i - 1] = locator[i];
+
+    int found = 0;
+    for(int i = 0; i < n; i++) {
+        const uint8_t inverse = gfPow(2, -(n - 1 - i)); //X^-1 for the byte multiplying x^(n-1-i)
+        if(polyEval(locator, inverse) != 0) continue;
+        const uint8_t denominator = polyEval(derivative, inverse);
+        if(denominator == 0) return -1;
+        code[i] ^= gfMul(polyEval(evaluator, inverse), gfInverse(denominator));
+        found++;
+    }
+    return found == errors ? found : -1;
+}
+
+static int bitAt(const uint8_t* bits, int i) {
+    return (bits[i / 8] >> (7 - i % 8)) & 1;
+}
+
+static uint8_t reverseByte(uint8_t byte) {
+    uint8_t reversed = 0;
+    for(int i = 0; i < 8; i++) reversed |= ((byte >> i) & 1) << (7 - i);
+    return reversed;
+}
+
+//The codeblock of a queued FX.25 frame as transmitted bytes, and its tag
+static std::vector<uint8_t> fx25Codeblock(const TxFrame* frame, uint64_t* tag) {
+    *tag = 0;
+    for(int i = 0; i < FX25_TAG_BYTES; i++) *tag |= (uint64_t) reverseByte(frame->bits[i]) << (8 * i);
+    std::vector<uint8_t> block;
+    for(int i = FX25_TAG_BYTES; i < frame->size / 8; i++) block.push_back(reverseByte(frame->bits[i]));
+    return block;
+}
+
+//FX.25 frames: the tag names the smallest code, the AX.25 bitstream is unchanged inside, the codeword decodes
+//with up to checkBytes / 2 bad bytes anywhere and never to the original with one more, plain AX.25 receivers
+//still get the frame, and a frame too long for any block is sent as plain AX.25
+static void checkFX25() {
+    DRA818V radio(PTT_PIN, AUDIO_PIN, MIC_PIN, DRATX, DRARX);
+    APRS aprs(&radio, &checkHeader);
+    const FX25Check checks[] = {FX25_CHECK_16, FX25_CHECK_32, FX25_CHECK_64};
+    uint32_t seed = 7;
+    std::vector<TxFrame> sent;
+    for(int trial = 0; trial < 60; trial++) {
+        const FX25Check check = checks[trial % 3];
+        std::string info = ">";
+        for(int i = 0; i < trial * 3; i++) {
+            seed = seed * 1103515245 + 12345;
+            info += (char) (' ' + (seed >> 16) % 95);
+        }
+        aprs.setFX25(FX25_OFF);
+        const TxFrame* plainFrame = sendAndPeek(aprs, info.c_str());
+        CHECK(plainFrame);
+        if(!plainFrame) continue;
+        const TxFrame plain = *plainFrame;
+        aprs.setFX25(check);
+        const TxFrame* frame = sendAndPeek(aprs, info.c_str());
+        CHECK(frame);
+        if(!frame) continue;
+        const FX25Code* code = fx25_code((plain.size + 7) / 8, check);
+        if(!code) {
+            CHECK(frame->size == plain.size && memcmp(frame->bits, plain.bits, (plain.size + 7) / 8) == 0);
+            continue;
+        }
+        if(trial < 6) sent.push_back(*frame);
+        uint64_t tag;
+        const std::vector<uint8_t> original = fx25Codeblock(frame, &tag);
+        CHECK(tag == code->tag && (int) original.size() == code->dataBytes + code->checkBytes);
+        int changed = 0;
+        for(int i = 0; i < plain.size; i++) changed += bitAt(frame->bits + FX25_TAG_BYTES, i) != bitAt(plain.bits, i);
+        CHECK(changed == 0);
+        std::vector<uint8_t> block = original;
+        CHECK(rsDecode(block, check) == 0);
+
+        for(int errors = 1; errors <= check / 2 + 1; errors++) {
+            block = original;
+            std::vector<int> positions;
+            while((int) positions.size() < errors) {
+                seed = seed * 1103515245 + 12345;
+                const int position = (seed >> 16) % block.size();
+                if(std::find(positions.begin(), positions.end(), position) == positions.end()) positions.push_back(position);
+            }
+            for(int position : positions) {
+                seed = seed * 1103515245 + 12345;
+                block[position] ^= 1 + (seed >> 16) % 255;
+            }
+            const int corrected = rsDecode(block, check);
+            if(errors <= check / 2) {
+                CHECK(corrected == errors && block == original);
+            } else {
+                CHECK(block != original);
+            }
+        }
+    }
+    afsk_cancel();
+    aprs.setFX25(FX25_OFF);
+
+    //plain receivers still find every frame between its flags
+    AFSKDemodConfig config = AFSK_DEMOD_DEFAULTS;
+    config.sampleRate = AFSK1200::SAMPLE_RATE;
+    AFSKDemodulator demod(config);
+    const std::vector<int16_t> pcm = renderFrames<AFSK1200>(sent);
+    int received = 0;
+    for(size_t i = 0; i < pcm.size(); i++) {
+        received += demod.process(pcm[i]);
+    }
+    CHECK(!sent.empty() && received == (int) sent.size());
+}
+
+//Counts what the dispatcher hands out and keeps the last payload of each kind
+class CheckHandler : public APRSHandler
+{
+public:
+    CheckHandler() : positions(0), statuses(0), telemetries(0), messages(0), others(0) {}
+    void position(const AX25Frame& frame, const APRSPosition& p) { positions++; lastPosition = p; }
+    void status(const AX25Frame& frame, const APRSStatus& s) { statuses++; lastStatus = s; }
+    void telemetry(const AX25Frame& frame, const APRSTelemetry& t) { telemetries++; lastTelemetry = t; }
+    void message(const AX25Frame& frame, const APRSMessage& m) { messages++; lastMessage = m; }
+    void other(const AX25Frame& frame) { others++; }
+    int positions, statuses, telemetries, messages, others;
+    APRSPosition lastPosition;
+    APRSStatus lastStatus;
+    APRSTelemetry lastTelemetry;
+    APRSMessage lastMessage;
+};
+
+static bool spanIs(AX25Span span, const char* text) {
+    return span.length == strlen(text) && memcmp(span.data, text, span.length) == 0;
+}
+
+//checkHeader's address field, UI control, PID and info, as the demodulator hands frames over
+static int buildFrame(uint8_t* frame, const char* info) {
+    memcpy(frame, checkHeader.address, checkHeader.addressLength);
+    int length = checkHeader.addressLength;
+    frame[length++] = AX25_CONTROL_UI;
+    frame[length++] = AX25_PID_NO_LAYER3;
+    memcpy(frame + length, info, strlen(info));
+    return length + strlen(info);
+}
+
+static APRSDataType dispatchInfo(const char* info, CheckHandler& handler) {
+    uint8_t frame[AFSK_RX_MAX_FRAME];
+    AX25Frame view;
+    CHECK(view.parse(frame, buildFrame(frame, info)));
+    return aprs_dispatch(view, handler);
+}
+
+static void checkParser() {
+    uint8_t frame[AFSK_RX_MAX_FRAME];
+    const int length = buildFrame(frame, ">hi");
+    AX25Frame view;
+    CHECK(view.parse(frame, length));
+    CHECK(view.destination().matches(checkPath[0]));
+    CHECK(view.source().matches(checkPath[1]));
+    CHECK(!view.source().matches(checkPath[0]));
+    CHECK(view.digipeaters() == 1 && view.digipeater(0).matches(checkPath[2]));
+    CHECK(!view.digipeater(0).repeated() && view.digipeater(0).last());
+    CHECK(view.control() == AX25_CONTROL_UI && view.pid() == AX25_PID_NO_LAYER3);
+    CHECK(spanIs(view.info(), ">hi"));
+    char storage[AX25_CALLSIGN_LENGTH + 1];
+    const SSID source = view.source().toSSID(storage);
+    CHECK(strcmp(source.address, "KM6HBK") == 0 && source.ssid_designator == 11);
+    frame[2 * AX25_ADDRESS_LENGTH + AX25_CALLSIGN_LENGTH] |= 0x80;
+    CHECK(view.digipeater(0).repeated() && view.digipeater(0).matches(checkPath[2]));
+    CHECK(!view.parse(frame, 2 * AX25_ADDRESS_LENGTH + 1)); //address field never ends
+    CHECK(!view.parse(frame, checkHeader.addressLength + 1)); //no PID
+    frame[checkHeader.addressLength] = 0x00; //I frame
+    CHECK(!view.parse(frame, length));
+
+    CheckHandler handler;
+    CHECK(dispatchInfo("/161230z3725.65N/12210.18WO090/012/A=004050one", handler) == APRS_TYPE_POSITION);
+    CHECK(handler.lastPosition.latitude == 374275000 && handler.lastPosition.longitude == -1221696667);
+    CHECK(handler.lastPosition.symbolTable == '/' && handler.lastPosition.symbol == 'O');
+    CHECK(!handler.lastPosition.compressed && !handler.lastPosition.messaging);
+    CHECK(spanIs(handler.lastPosition.timestamp, "161230z"));
+    CHECK(spanIs(handler.lastPosition.comment, "090/012/A=004050one"));
+    CHECK(dispatchInfo("=/5L!!<*e7>7P[", handler) == APRS_TYPE_POSITION); //APRS 1.0.1 chapter 9 example
+    CHECK(abs(handler.lastPosition.latitude - 495000000) < 1000 && abs(handler.lastPosition.longitude + 727500000) < 1000);
+    CHECK(handler.lastPosition.compressed && handler.lastPosition.messaging && handler.lastPosition.symbol == '>');
+    CHECK(dispatchInfo("!4903.5xN/07201.75W-", handler) == APRS_TYPE_OTHER); //malformed minutes
+    CHECK(dispatchInfo("!49  .  N/072  .  W-", handler) == APRS_TYPE_POSITION); //ambiguous to the degree
+    CHECK(handler.lastPosition.latitude == 490000000 && handler.lastPosition.longitude == -720000000);
+
+    CHECK(dispatchInfo(">Float altitude reached", handler) == APRS_TYPE_STATUS);
+    CHECK(spanIs(handler.lastStatus.text, "Float altitude reached"));
+    CHECK(dispatchInfo("T#005,199,000,255,073,123,01101001", handler) == APRS_TYPE_TELEMETRY);
+    CHECK(handler.lastTelemetry.sequence == 5 && handler.lastTelemetry.analog[0] == 199000 && handler.lastTelemetry.analog[4] == 123000);
+    CHECK(handler.lastTelemetry.digital == 0x69 && handler.lastTelemetry.comment.length == 0);
+    CHECK(dispatchInfo("T#1,-1.5,2.25,0,0,0,11111111 balloon", handler) == APRS_TYPE_TELEMETRY);
+    CHECK(handler.lastTelemetry.analog[0] == -1500 && handler.lastTelemetry.analog[1] == 2250 && handler.lastTelemetry.digital == 0xFF);
+    CHECK(spanIs(handler.lastTelemetry.comment, " balloon"));
+    CHECK(dispatchInfo("T#1,2,3", handler) == APRS_TYPE_OTHER);
+    CHECK(dispatchInfo(":KM6HBK-11:hello{42", handler) == APRS_TYPE_MESSAGE);
+    CHECK(spanIs(handler.lastMessage.addressee, "KM6HBK-11") && spanIs(handler.lastMessage.text, "hello") && spanIs(handler.lastMessage.id, "42"));
+    CHECK(dispatchInfo(":BLN1     :no number", handler) == APRS_TYPE_MESSAGE);
+    CHECK(spanIs(handler.lastMessage.addressee, "BLN1") && handler.lastMessage.id.length == 0);
+    CHECK(dispatchInfo("", handler) == APRS_TYPE_OTHER);
+    CHECK(handler.positions == 3 && handler.statuses == 1 && handler.telemetries == 2 && handler.messages == 2 && handler.others == 3);
+}
+
+//Undoes the HDLC encoding of a queued frame: finds the first frame between flags, removes stuffed zeros and
+//checks the FCS. Returns the frame length without the FCS, -1 if there is no valid frame.
+static int unstuff(const TxFrame* sent, uint8_t* out) {
+    uint8_t pattern = 0, current = 0;
+    int ones = 0, bits = 0, length = 0;
+    bool inFrame = false;
+    for(int i = 0; i < sent->size; i++) {
+        const int bit = (sent->bits[i / 8] >> (7 - i % 8)) & 1;
+        pattern = (pattern >> 1) | (bit << 7);
+        if(pattern == HDLC_FLAG) {
+            if(inFrame && length >= AFSK_RX_MIN_FRAME && bits == 7) {
+                const uint16_t fcs = out[length - 2] | (out[length - 1] << 8);
+                return (uint16_t) ~crc16_update(CRC16_INIT, out, length - 2) == fcs ? length - 2 : -1;
+            }
+            inFrame = true;
+            length = bits = ones = 0;
+            continue;
+        }
+        if(!bit && ones == BIT_STUFF_THRESHOLD) {
+            ones = 0;
+            continue;
+        }
+        ones = bit ? ones + 1 : 0;
+        current = (current >> 1) | (bit << 7);
+        if(inFrame && ++bits == 8) {
+            out[length++] = current;
+            bits = 0;
+        }
+    }
+    return -1;
+}
+
+static std::string addressString(AX25Address address) {
+    char callsign[AX25_CALLSIGN_LENGTH + 1];
+    address.callsign(callsign);
+    std::string out = callsign;
+    if(address.ssid()) out += "-" + std::to_string(address.ssid());
+    return out;
+}
+
+//SOURCE>DEST,PATH with repeated entries starred
+static std::string pathString(const uint8_t* frame, int length) {
+    AX25Frame view;
+    if(!view.parse(frame, length)) return "(invalid)";
+    std::string out = addressString(view.source()) + ">" + addressString(view.destination());
+    for(int i = 0; i < view.digipeaters(); i++) {
+        out += "," + addressString(view.digipeater(i)) + (view.digipeater(i).repeated() ? "*" : "");
+    }
+    return out;
+}
+
+//Builds N0CALL>APRS,<path>:>test where path entries ending in '*' get the H bit
+static int pathFrame(uint8_t* frame, const std::vector<SSID>& path, const std::vector<bool>& repeated) {
+    std::vector<SSID> all = {{"APRS", 0}, {"N0CALL", 0}};
+    all.insert(all.end(), path.begin(), path.end());
+    const AX25Header header = ax25_header(all.data(), all.size());
+    memcpy(frame, header.address, header.addressLength);
+    for(size_t i = 0; i < repeated.size(); i++) {
+        if(repeated[i]) frame[(i + 3) * AX25_ADDRESS_LENGTH - 1] |= 0x80;
+    }
+    int length = header.addressLength;
+    frame[length++] = AX25_CONTROL_UI;
+    frame[length++] = AX25_PID_NO_LAYER3;
+    memcpy(frame + length, ">test", 5);
+    return length + 5;
+}
+
+//What the digipeater transmits for a path, or "" if it stays quiet
+static std::string digipeat(Digipeater& digi, const std::vector<SSID>& path, const std::vector<bool>& repeated = {}, uint32_t now = 0) {
+    uint8_t frame[AFSK_RX_MAX_FRAME];
+    const int length = pathFrame(frame, path, repeated);
+    if(!digi.handle(frame, length, now)) {
+        return "";
+    }
+    uint8_t out[AFSK_RX_MAX_FRAME];
+    const int outLength = unstuff(txQueue.front(), out);
+    afsk_cancel();
+    AX25Frame view;
+    CHECK(view.parse(out, outLength) && view.info().length == 5 && memcmp(view.info().data, ">test", 5) == 0);
+    return pathString(out, outLength);
+}
+
+static void checkDigipeater() {
+    DRA818V radio(PTT_PIN, AUDIO_PIN, MIC_PIN, DRATX, DRARX);
+    APRS aprs(&radio, &checkHeader);
+    const SSID myCall = {"KM6HBK", 10};
+    const SSID aliases[] = {{"RELAY", 0}};
+    Digipeater digi(&aprs, myCall);
+    digi.setAliases(aliases, 1);
+    uint32_t now = 1000;
+    //a fresh time for every case keeps the identical test frames from counting as duplicates
+    CHECK(digipeat(digi, {{"WIDE2", 2}}, {}, now += 60000) == "N0CALL>APRS,KM6HBK-10*,WIDE2-1");
+    CHECK(digipeat(digi, {{"WIDE1", 1}, {"WIDE2", 1}}, {}, now += 60000) == "N0CALL>APRS,KM6HBK-10*,WIDE1*,WIDE2-1");
+    CHECK(digipeat(digi, {{"K6OTH", 0}, {"WIDE2", 1}}, {true}, now += 60000) == "N0CALL>APRS,K6OTH*,KM6HBK-10*,WIDE2*");
+    CHECK(digipeat(digi, {{"KM6HBK", 10}, {"WIDE2", 1}}, {}, now += 60000) == "N0CALL>APRS,KM6HBK-10*,WIDE2-1");
+    CHECK(digipeat(digi, {{"RELAY", 0}}, {}, now += 60000) == "N0CALL>APRS,KM6HBK-10*");
+    CHECK(digipeat(digi, {{"WIDE3", 3}}, {}, now += 60000) == ""); //more hops than allowed
+    CHECK(digipeat(digi, {{"WIDE2", 3}}, {}, now += 60000) == ""); //N > n
+    CHECK(digipeat(digi, {{"WIDE2", 0}}, {}, now += 60000) == "");
+    CHECK(digipeat(digi, {{"WIDE2", 1}}, {true}, now += 60000) == ""); //already used
+    CHECK(digipeat(digi, {{"K6OTH", 0}}, {}, now += 60000) == "");
+    CHECK(digipeat(digi, {}, {}, now += 60000) == "");
+    std::vector<SSID> full(7, SSID{"K6OTH", 1});
+    full.push_back({"WIDE2", 2});
+    CHECK(digipeat(digi, full, std::vector<bool>(7, true), now += 60000) ==
+          "N0CALL>APRS,K6OTH-1*,K6OTH-1*,K6OTH-1*,K6OTH-1*,K6OTH-1*,K6OTH-1*,K6OTH-1*,WIDE2-1"); //no room to insert
+
+    //a copy heard again inside the window is dropped, also via another path, and repeated once it expires
+    now += 60000;
+    CHECK(digipeat(digi, {{"WIDE2", 2}}, {}, now) != "");
+    CHECK(digipeat(digi, {{"WIDE1", 1}}, {}, now + 1000) == "");
+    CHECK(digipeat(digi, {{"WIDE2", 2}}, {}, now + DIGI_DEDUPE_WINDOW_MS - 1) == "");
+    CHECK(digi.duplicates() == 2);
+    CHECK(digipeat(digi, {{"WIDE2", 2}}, {}, now + DIGI_DEDUPE_WINDOW_MS) != "");
+
+    //the cache under load: every live digest is found, none survives the window
+    DedupeCache cache;
+    for(uint32_t i = 0; i < DIGI_DEDUPE_SLOTS / 2; i++) {
+        cache.insert(i * 2654435761u | 1, 5000 + i, 30000);
+    }
+    bool allFound = true;
+    for(uint32_t i = 0; i < DIGI_DEDUPE_SLOTS / 2; i++) {
+        allFound = allFound && cache.contains(i * 2654435761u | 1, 20000, 30000);
+    }
+    CHECK(allFound);
+    CHECK(!cache.contains(12345, 20000, 30000));
+    CHECK(!cache.contains(1, 5000 + 30000, 30000));
+}
+
+//Integer base-91 encoder against the spec example, the parser, and the uncompressed report it replaces
+static void checkCompressed() {
+    char out[APRS_COMPRESSED_LENGTH + 1] = {};
+    aprs_compress_position(out, 495000000, -727500000, '/', '>', 88, 36); //APRS 1.0.1 chapter 9: 49 30'N 72 45'W
+    CHECK(strcmp(out, "/5L!!<*e7>7P[") == 0);
+    aprs_compress_position(out, 900000000, -1800000000, '/', 'O', 0, 0);
+    CHECK(memcmp(out, "/!!!!!!!!O!!", 12) == 0);
+    aprs_compress_position(out, 0, 0, '/', 'O', 359, 2000); //north again, fastest code
+    CHECK(out[10] == '!' && out[11] == '!' + 89);
+    aprs_compress_position(out, 0, 0, '/', 'O', 180, 1);
+    CHECK(out[10] == '!' + 45 && out[11] == '!' + 9); //1.08^9 - 1 = 1.0 knot
+    char altitude[APRS_ALTITUDE_LENGTH + 1] = {};
+    aprs_format_altitude(altitude, 1234);
+    CHECK(strcmp(altitude, "/A=004049") == 0);
+    aprs_format_altitude(altitude, -10);
+    CHECK(strcmp(altitude, "/A=-00033") == 0);
+
+    //parser round trip: within one base-91 step (1/380926 and 1/190463 degree)
+    CheckHandler handler;
+    int32_t worst = 0;
+    for(int32_t lat = -899999999; lat < 900000000; lat += 12345677) {
+        for(int32_t lon = -1799999999; lon < 1800000000; lon += 98765431) {
+            char info[1 + APRS_COMPRESSED_LENGTH + 1] = {'!'};
+            aprs_compress_position(info + 1, lat, lon, '/', 'O', 0, 0);
+            CHECK(dispatchInfo(info, handler) == APRS_TYPE_POSITION);
+            worst = std::max(worst, std::max(abs(handler.lastPosition.latitude - lat), abs(handler.lastPosition.longitude - lon) / 2));
+        }
+    }
+    CHECK(worst <= 27);
+
+    DRA818V radio(PTT_PIN, AUDIO_PIN, MIC_PIN, DRATX, DRARX);
+    APRS aprs(&radio, &checkHeader);
+    afsk_cancel();
+    CHECK(aprs.sendPacketGPS(16, 12, 30, 37.42750f, -122.16967f, 1234.0f, 90, 12.0f, "one"));
+    const int uncompressedBits = txQueue.front()->size;
+    afsk_cancel();
+    CHECK(aprs.sendPacketCompressedFixed(16, 12, 30, 374275000, -1221696700, 1234, 90, 12, "one"));
+    uint8_t frame[AFSK_RX_MAX_FRAME];
+    const int length = unstuff(txQueue.front(), frame);
+    CHECK(txQueue.front()->size <= uncompressedBits - 12 * 8);
+    afsk_cancel();
+    AX25Frame view;
+    CHECK(view.parse(frame, length) && aprs_dispatch(view, handler) == APRS_TYPE_POSITION);
+    CHECK(handler.lastPosition.compressed && spanIs(handler.lastPosition.timestamp, "161230z"));
+    CHECK(abs(handler.lastPosition.latitude - 374275000) <= 27 && abs(handler.lastPosition.longitude + 1221696700) <= 53);
+    CHECK(spanIs(handler.lastPosition.comment, "/A=004049one"));
+    CHECK(aprs.sendPacketCompressed(16, 12, 30, 37.42750f, -122.16967f, 1234.0f, 90, 12.0f, "one"));
+    CHECK(unstuff(txQueue.front(), frame) == length);
+    afsk_cancel();
+    CHECK(aprs.sendPacketCompressed(16, 12, 30, 37.4275, -122.16967, 1234.0, 90, 12.0, "one")); //double literals
+    CHECK(unstuff(txQueue.front(), frame) == length);
+    afsk_cancel();
+}
+
+//The information field of the frame at the front of the queue
+static std::string queuedInfo() {
+    uint8_t frame[AFSK_RX_MAX_FRAME];
+    AX25Frame view;
+    const TxFrame* sent = txQueue.front();
+    if(!sent || !view.parse(frame, unstuff(sent, frame))) return "";
+    return std::string((const char*) view.info().data, view.info().length);
+}
+
+template <class F>
+static std::string formatted(F format) {
+    APRSPayload payload;
+    format(payload);
+    return std::string((const char*) payload.data(), payload.length());
+}
+
+//"DDMM.mmN" from hundredths of a minute rounded in double precision, as a reference for the integer formatter
+static std::string referenceAngle(int32_t angle, int width, char positive, char negative) {
+    const long long hundredths = llround(fabs((double) angle) * 6 / 10000);
+    char text[48];
+    snprintf(text, sizeof(text), "%0*lld%02lld.%02lld%c", width, hundredths / 6000, hundredths % 6000 / 100,
+             hundredths % 100, angle < 0 ? negative : positive);
+    return text;
+}
+
+//Integer formatters against printf references, minutes that round up to a whole degree, the payload's fixed
+//capacity, and sendPacketGPS built on them with the float and String forms giving the same frame
+static void checkPayload() {
+    CHECK(formatted([](APRSPayload& p) { aprs_put_timestamp(p, 7, 0, 59); }) == "070059z");
+    CHECK(formatted([](APRSPayload& p) { aprs_put_course_speed(p, 5, 123); }) == "005/123");
+    CHECK(formatted([](APRSPayload& p) { aprs_put_position(p, 374275000, -1221697000, '/', 'O'); }) == "3725.65N/12210.18WO");
+    CHECK(formatted([](APRSPayload& p) { aprs_put_latitude(p, 379999999); }) == "3800.00N"); //was 3759.100N
+    CHECK(formatted([](APRSPayload& p) { aprs_put_longitude(p, -9999999); }) == "00100.00W");
+    CHECK(formatted([](APRSPayload& p) { aprs_put_latitude(p, -900000000); }) == "9000.00S");
+    CHECK(formatted([](APRSPayload& p) { aprs_put_altitude(p, -30); }) == "/A=-00098");
+    uint32_t seed = 11;
+    int mismatches = 0;
+    for(int i = 0; i < 100000; i++) {
+        seed = seed * 1103515245 + 12345;
+        const int32_t latitude = (int32_t) (seed % 1800000001u) - 900000000;
+        seed = seed * 1103515245 + 12345;
+        const int32_t longitude = (int32_t) (((uint64_t) seed * 3600000001ull) >> 32) - 1800000000;
+        mismatches += formatted([&](APRSPayload& p) { aprs_put_latitude(p, latitude); }) != referenceAngle(latitude, 2, 'N', 'S');
+        mismatches += formatted([&](APRSPayload& p) { aprs_put_longitude(p, longitude); }) != referenceAngle(longitude, 3, 'E', 'W');
+    }
+    CHECK(mismatches == 0);
+
+    APRSPayload payload;
+    for(int i = 0; i < APRS_PAYLOAD_MAX + 5; i++) payload.put('x');
+    CHECK(payload.length() == APRS_PAYLOAD_MAX && payload.overflowed());
+    payload.clear();
+    aprs_put_string(payload, ">status");
+    CHECK(payload.length() == 7 && !payload.overflowed());
+
+    DRA818V radio(PTT_PIN, AUDIO_PIN, MIC_PIN, DRATX, DRARX);
+    APRS aprs(&radio, &checkHeader);
+    afsk_cancel();
+    CHECK(aprs.sendPacketGPSFixed(16, 12, 30, 374275000, -1221697000, 1234, 90, 12, "one"));
+    const std::string expected = "/161230z3725.65N/12210.18WO090/012/A=004049one";
+    CHECK(queuedInfo() == expected);
+    afsk_cancel();
+    CHECK(aprs.sendPacketGPS(16, 12, 30, 37.4275f, -122.1697f, 1234.0f, 90, 12.0f, "one"));
+    CHECK(queuedInfo() == expected);
+    afsk_cancel();
+    CHECK(aprs.sendPacketGPS(16, 12, 30, 37.4275f, -122.1697f, 1234.0f, 90, 12.0f, String("one")));
+    CHECK(queuedInfo() == expected);
+    afsk_cancel();
+    CHECK(aprs.sendPacketGPS(16, 12, 30, 37.4275, -122.1697, 1234.0, 90, 12.0, "one")); //double literals, as before
+    CHECK(queuedInfo() == expected);
+    afsk_cancel();
+    CHECK(aprs.sendPayload(payload) && queuedInfo() == ">status");
+    afsk_cancel();
+}
+
+//Mic-E decoded by the spec's rules, independently of the encoder. Positions in signed hundredths of a minute.
+struct MicEReport {
+    int32_t latitude, longitude;
+    int speed, course, message;
+    int32_t altitude;
+};
+
+static MicEReport decodeMicE(const uint8_t* destination, const uint8_t* info) {
+    int digits[6];
+    bool flags[6];
+    for(int i = 0; i < 6; i++) {
+        const char c = destination[i] >> 1;
+        flags[i] = c >= 'P';
+        digits[i] = flags[i] ? c - 'P' : c - '0';
+    }
+    MicEReport out;
+    out.message = flags[0] << 2 | flags[1] << 1 | flags[2];
+    out.latitude = (digits[0] * 10 + digits[1]) * 6000 + (digits[2] * 10 + digits[3]) * 100 + digits[4] * 10 + digits[5];
+    if(!flags[3]) out.latitude = -out.latitude;
+    int degrees = info[1] - 28 + (flags[4] ? 100 : 0);
+    if(degrees >= 180 && degrees <= 189) degrees -= 80;
+    if(degrees >= 190 && degrees <= 199) degrees -= 190;
+    int minutes = info[2] - 28;
+    if(minutes >= 60) minutes -= 60;
+    out.longitude = degrees * 6000 + minutes * 100 + info[3] - 28;
+    if(flags[5]) out.longitude = -out.longitude;
+    const int dc = info[5] - 28;
+    out.speed = (info[4] - 28) * 10 + dc / 10;
+    if(out.speed >= 800) out.speed -= 800;
+    out.course = dc % 10 * 100 + info[6] - 28;
+    if(out.course >= 400) out.course -= 400;
+    out.altitude = info[MICE_INFO_LENGTH + 3] == '}' ? ((info[9] - 33) * 91 + info[10] - 33) * 91 + info[11] - 33 - 10000 : INT32_MIN;
+    return out;
+}
+
+static int32_t minuteHundredths(int32_t degrees) {
+    const int32_t magnitude = (int32_t) ((std::abs((int64_t) degrees) * 6000 + 5000000) / 10000000);
+    return degrees < 0 ? -magnitude : magnitude;
+}
+
+static void checkMicE() {
+    //APRS 1.0.1 chapter 10 examples: destination S32U6T is 33 25.64N, "Returning", no longitude offset, west;
+    //information `(_fn"Oj/ is 112 07.74W (offset +100), 20 knots, 251 degrees, jeep
+    uint8_t destination[AX25_ADDRESS_LENGTH];
+    aprs_mice_destination(destination, 334273333, -725000000, MICE_RETURNING);
+    char callsign[AX25_CALLSIGN_LENGTH + 1];
+    AX25Address(destination).callsign(callsign);
+    CHECK(strcmp(callsign, "S32U6T") == 0 && AX25Address(destination).ssid() == 0);
+    aprs_mice_destination(destination, 334273333, -1121290000, MICE_RETURNING);
+    AX25Address(destination).callsign(callsign);
+    CHECK(strcmp(callsign, "S32UVT") == 0);
+    uint8_t info[MICE_INFO_LENGTH + MICE_ALTITUDE_LENGTH + 1] = {};
+    aprs_mice_info(info, -1121290000, 251, 20, '/', 'j');
+    CHECK(memcmp(info, "`(_fn\"Oj/", MICE_INFO_LENGTH) == 0);
+    aprs_mice_altitude(info + MICE_INFO_LENGTH, 61);
+    CHECK(memcmp(info + MICE_INFO_LENGTH, "\"4T}", MICE_ALTITUDE_LENGTH) == 0); //10061 m
+
+    //every longitude offset band, both hemispheres, speeds either side of 200 knots
+    const int32_t latitudes[] = {0, 1, -1, 334273333, -334273333, 899999999, 900000000, -900000000};
+    const int32_t longitudes[] = {0, -95000000, 95000000, 105000000, -1095500000, 1100000000, -1121290000, 1799999999, -1800000000};
+    const uint16_t speeds[] = {0, 9, 20, 199, 200, 555, 799};
+    const uint16_t courses[] = {0, 3, 99, 251, 359};
+    bool allMatch = true;
+    int count = 0;
+    for(int32_t lat : latitudes) {
+        for(int32_t lon : longitudes) {
+            for(uint16_t speed : speeds) {
+                for(uint16_t course : courses) {
+                    const MicEMessage message = (MicEMessage) (count++ % 8);
+                    aprs_mice_destination(destination, lat, lon, message);
+                    aprs_mice_info(info, lon, course, speed, '/', 'O');
+                    aprs_mice_altitude(info + MICE_INFO_LENGTH, count * 13 - 2000);
+                    const MicEReport report = decodeMicE(destination, info);
+                    const int32_t expectLon = std::max(std::min(minuteHundredths(lon), 180 * 6000 - 1), -(180 * 6000 - 1));
+                    bool printable = true;
+                    for(int i = 0; i < MICE_INFO_LENGTH; i++) {
+                        printable = printable && info[i] >= 28 && info[i] <= 127;
+                    }
+                    allMatch = allMatch && printable && report.latitude == minuteHundredths(lat) && report.longitude == expectLon &&
+                               report.speed == speed && report.course == course && report.message == message &&
+                               report.altitude == count * 13 - 2000;
+                }
+            }
+        }
+    }
+    CHECK(allMatch);
+
+    //a sent frame: generated destination, the header's other path entries unchanged
+    DRA818V radio(PTT_PIN, AUDIO_PIN, MIC_PIN, DRATX, DRARX);
+    APRS aprs(&radio, &checkHeader);
+    afsk_cancel();
+    CHECK(aprs.sendPacketMicE(334273333, -1121290000, 61, 251, 20, MICE_RETURNING, "hi"));
+    uint8_t frame[AFSK_RX_MAX_FRAME];
+    const int length = unstuff(txQueue.front(), frame);
+    afsk_cancel();
+    AX25Frame view;
+    CHECK(view.parse(frame, length));
+    CHECK(pathString(frame, length) == "KM6HBK-11>S32UVT,WIDE2-1");
+    CHECK(spanIs(view.info(), "`(_fn\"OO/\"4T}hi"));
+    const MicEReport report = decodeMicE(view.destination().bytes(), view.info().data);
+    CHECK(report.latitude == 33 * 6000 + 2564 && report.longitude == -(112 * 6000 + 774) && report.altitude == 61);
+}
+
+//Information fields of every queued frame, oldest first; empties the queue
+static std::vector<std::string> drainInfos() {
+    std::vector<std::string> infos;
+    uint8_t frame[AFSK_RX_MAX_FRAME];
+    AX25Frame view;
+    for(const TxFrame* sent; (sent = txQueue.front()); txQueue.pop()) {
+        const int length = unstuff(sent, frame);
+        infos.push_back(view.parse(frame, length) ? std::string((const char*) view.info().data, view.info().length) : "(invalid)");
+    }
+    afsk_cancel();
+    return infos;
+}
+
+static void checkTelemetry() {
+    char out[TELEMETRY_COMMENT_MAX + 1];
+    const int32_t values[] = {199, 0, 255, 73, 123};
+    CHECK(aprs_telemetry_report(out, 5, values, 5, 0x69) == 34);
+    CHECK(strcmp(out, "T#005,199,000,255,073,123,01101001") == 0);
+    CheckHandler handler;
+    CHECK(dispatchInfo(out, handler) == APRS_TYPE_TELEMETRY && handler.lastTelemetry.digital == 0x69 && handler.lastTelemetry.analog[4] == 123000);
+    const int32_t wide[] = {-5, 1234};
+    aprs_telemetry_report(out, 1005, wide, 2, 0);
+    CHECK(strcmp(out, "T#005,-005,1234,000,000,000,00000000") == 0);
+    const int32_t spec[] = {1472, 1564, 1656, 1748}; //"11", "22", "33", "44"
+    CHECK(aprs_telemetry_base91(out, 7544, spec, 4, false, 0) == 12 && strcmp(out, "|ss11223344|") == 0);
+    const int32_t clamped[] = {-1, 9000};
+    aprs_telemetry_base91(out, 0, clamped, 2, true, 0x80); //B1 only
+    CHECK(strcmp(out, "|!!!!{{!!!!!!!\"|") == 0); //channels 3-5 padded with 0 ahead of the digital value
+
+    DRA818V radio(PTT_PIN, AUDIO_PIN, MIC_PIN, DRATX, DRARX);
+    APRS aprs(&radio, &checkHeader);
+    Telemetry telemetry(&aprs, {"KM6HBK", 11});
+    telemetry.setDefinitions("Vbat,Temp", "V,C", "0,0.1,0,0,1,-40", 0);
+    telemetry.setDefinitionInterval(3);
+    telemetry.setChannels(values, 2, 0x01);
+    afsk_cancel();
+    CHECK(telemetry.send());
+    std::vector<std::string> infos = drainInfos();
+    CHECK(infos.size() == 4 && infos[0] == "T#000,199,000,000,000,000,00000001");
+    CHECK(infos[1] == ":KM6HBK-11:PARM.Vbat,Temp" && infos[2] == ":KM6HBK-11:UNIT.V,C" && infos[3] == ":KM6HBK-11:EQNS.0,0.1,0,0,1,-40");
+    CHECK(telemetry.send() && telemetry.send());
+    CHECK(drainInfos().size() == 2); //definitions only every third report
+    const char* comment = telemetry.comment("hello");
+    CHECK(strcmp(comment, "|!$#2!!!!!!!!\"F|hello") == 0); //sequence 3, 199, 0, three unused channels, B8 set
+
+    CHECK(aprs.sendPacketCompressedFixed(16, 12, 30, 374275000, -1221696700, 1234, 90, 12, comment));
+    infos = drainInfos();
+    CHECK(infos.size() == 4 && infos[0].compare(0, 11, ":KM6HBK-11:") == 0 && infos[3].find("/A=004049|!$#2!!!!!!!!\"F|hello") != std::string::npos);
+
+    //a nearly full queue: one definition fits behind the report, the rest follow from poll()
+    aprs.sendPacketNoGPS((char*) ">busy");
+    aprs.sendPacketNoGPS((char*) ">busy");
+    telemetry.setDefinitions("Vbat,Temp", "V,C", "0,0.1,0,0,1,-40", "10000000,Balloon");
+    CHECK(telemetry.send());
+    CHECK(drainInfos().size() == 4); //2 busy, the report and PARM
+    telemetry.poll();
+    infos = drainInfos();
+    CHECK(infos.size() == 3 && infos[2] == ":KM6HBK-11:BITS.10000000,Balloon"); //one slot left free
+
+    //a definition over the 67 character message limit is cut there, with nothing after it
+    const std::string longUnits(80, 'U');
+    telemetry.setDefinitions(0, longUnits.c_str(), 0, 0);
+    CHECK(telemetry.send());
+    infos = drainInfos();
+    CHECK(infos.size() == 2 && infos[1] == ":KM6HBK-11:UNIT." + longUnits.substr(0, TELEMETRY_MESSAGE_MAX - 5));
+}
+
+static void checkScheduler() {
+    BeaconScheduler fixed;
+    fixed.setFixedInterval(60000);
+    CHECK(fixed.poll(1000) && fixed.reason() == BEACON_FIRST);
+    CHECK(!fixed.poll(60999));
+    CHECK(fixed.poll(61000) && fixed.reason() == BEACON_RATE);
+
+    BeaconScheduler smart; //3 knots / 30 min, 50 knots / 3 min, 30 + 255/speed degrees
+    smart.setMotion(2, 0);
+    CHECK(smart.interval() == 1800000);
+    smart.setMotion(25, 0);
+    CHECK(smart.interval() == 360000);
+    smart.setMotion(80, 0);
+    CHECK(smart.interval() == 180000);
+    smart.setMotion(25, 0);
+    uint32_t now = 0x7FFFF000; //across the millis() wrap
+    CHECK(smart.poll(now));
+    smart.setMotion(25, 30);
+    CHECK(!smart.poll(now + 20000)); //40 degrees needed at 25 knots
+    smart.setMotion(25, 315);
+    CHECK(!smart.poll(now + 10000)); //corner, but within minTurnTime
+    CHECK(smart.poll(now + 15000) && smart.reason() == BEACON_CORNER);
+    now += 15000;
+    smart.setMotion(2, 90); //slow: turns don't count
+    CHECK(!smart.poll(now + 60000));
+    smart.setMotion(80, 315);
+    smart.setMinInterval(200000);
+    CHECK(!smart.poll(now + 180000)); //the minimum interval holds back the 3 minute rate
+    CHECK(smart.poll(now + 200000) && smart.reason() == BEACON_RATE);
+
+    //two stations sharing a 60 s frame in slots 0 and 30 s; the GPS says 12:00:10 at millis() 5000
+    BeaconScheduler a, b;
+    a.setFixedInterval(60000);
+    b.setFixedInterval(100000); //rounded to every other slot
+    a.setSlot(60, 0);
+    b.setSlot(60, 30);
+    a.setTime(16, 12, 0, 10, 5000);
+    b.setTime(16, 12, 0, 10, 5000);
+    std::vector<uint32_t> beaconsA, beaconsB;
+    for(uint32_t t = 5000; t < 5000 + 300000; t += 100) {
+        if(a.poll(t)) beaconsA.push_back(t);
+        if(b.poll(t)) beaconsB.push_back(t);
+    }
+    CHECK(beaconsA == std::vector<uint32_t>({55000, 115000, 175000, 235000, 295000}));
+    CHECK(beaconsB == std::vector<uint32_t>({25000, 145000, 265000}));
+    //without fresh GPS time the slots no longer apply
+    CHECK(!a.poll(5000 + BEACON_TIME_STALE_MS - 100) && a.poll(5000 + BEACON_TIME_STALE_MS + 100));
+}
+
+//Collects what is printed to it
+class StringStream : public Stream
+{
+public:
+    size_t write(uint8_t b) { text += (char) b; return 1; }
+    using Stream::write;
+    std::string text;
+};
+
+static void checkProfile() {
+    profile_begin();
+    const uint32_t samples[] = {0, 1, 3, 1000, 1024, 4000000000u};
+    for(uint32_t ticks : samples) profile_record(PROFILE_RX_CRC, ticks);
+    ProfileStats stats;
+    profile_snapshot(PROFILE_RX_CRC, &stats);
+    CHECK(stats.count == 6 && stats.min == 0 && stats.max == 4000000000u && stats.total == 4000002028ull);
+    CHECK(stats.histogram[0] == 1 && stats.histogram[1] == 1 && stats.histogram[2] == 1 && stats.histogram[10] == 1 &&
+          stats.histogram[11] == 1 && stats.histogram[32] == 1);
+    profile_isr_entry(1000000);
+    profile_isr_entry(1000000); //back to back: the whole 1 ms period is jitter, less the time in between
+    profile_snapshot(PROFILE_ISR_JITTER, &stats);
+    CHECK(stats.count == 1 && stats.max <= 1000000 && stats.max > 900000);
+    profile_isr_restart();
+    profile_isr_entry(1000000);
+    profile_snapshot(PROFILE_ISR_JITTER, &stats);
+    CHECK(stats.count == 1);
+
+    StringStream out;
+    profile_reset(PROFILE_ISR_JITTER);
+    profile_dump(out);
+    CHECK(out.text == "RX CRC: n=6 min=0.00 mean=666667.00 max=4000000.00 us\r\n"
+                      "  log2 ticks: 0+:1 1+:1 2+:1 512+:1 1024+:1 2147483648+:1\r\n");
+    profile_begin();
+}
+
+//Polls on the simulated clock until the driver has settled, returning the milliseconds it took
+static uint32_t settle(DRA818V& radio) {
+    const uint32_t start = millis();
+    while(radio.poll() == DRA818_BUSY && millis() - start < 10000) {
+        delay(1);
+    }
+    return millis() - start;
+}
+
+static void checkDRA818() {
+    char command[DRA818_COMMAND_MAX];
+    CHECK(dra818_group_command(command, true, 144390000, 145825000, "0000", 1, "0000") == 48);
+    CHECK(strcmp(command, "AT+DMOSETGROUP=1,144.3900,145.8250,0000,1,0000\r\n") == 0);
+    dra818_group_command(command, false, 440012500, 439999950, "0012", 12, "0000");
+    CHECK(strcmp(command, "AT+DMOSETGROUP=0,440.0125,440.0000,0012,8,0000\r\n") == 0);
+    const std::string longTone(2 * DRA818_COMMAND_MAX, '0');
+    CHECK(dra818_group_command(command, true, 144390000, 144390000, longTone.c_str(), 1, "0000") == -1 && command[0] == 0);
+    CHECK(dra818_group_command(command, true, 144390000, 144390000, "0000", 1, "00") == -1);
+    CHECK(dra818_group_command(command, true, 144390000, 144390000, 0, 1, "0000") == -1);
+
+    DRA818Sim sim;
+    host_set_serial_peer(&sim);
+    DRA818V radio(PTT_PIN, AUDIO_PIN, MIC_PIN, DRATX, DRARX);
+    CHECK(radio.poll() == DRA818_OFF);
+    const uint32_t before = millis();
+    radio.init();
+    CHECK(millis() == before && radio.state() == DRA818_BUSY); //nothing blocks
+    sim.sendNoise("+DMOSETGROUP:0\r\nthis line is far too long for the reply buffer\r\n"); //not waiting: ignored
+    const uint32_t bootMs = settle(radio);
+    CHECK(radio.ready() && radio.failures() == 0);
+    CHECK(bootMs >= DRA818_BOOT_MS && bootMs < DRA818_BOOT_MS + 250);
+    CHECK(sim.commands == std::vector<std::string>({"AT+DMOCONNECT", "AT+DMOSETGROUP=1,144.3900,144.3900,0000,1,0000"}));
+    CHECK(sim.connected && sim.txHz == 144390000 && sim.rxHz == 144390000 && sim.squelch == 1);
+
+    radio.setSquelch(12);
+    CHECK(radio.state() == DRA818_BUSY);
+    settle(radio);
+    CHECK(radio.ready() && sim.squelch == DRA818_MAX_SQUELCH && sim.commands.size() == 3);
+
+    //a lost reply is retried after the timeout
+    sim.commands.clear();
+    sim.dropReplies(1);
+    radio.init();
+    CHECK(settle(radio) > DRA818_BOOT_MS + DRA818_REPLY_TIMEOUT_MS && radio.ready());
+    CHECK(sim.commands.size() == 3 && sim.commands[0] == sim.commands[1]);
+
+    //refused more often than retried: given up on, the rest of the queue still goes out
+    sim.commands.clear();
+    sim.refuseCommands(DRA818_RETRIES + 1);
+    radio.init();
+    settle(radio);
+    CHECK(radio.state() == DRA818_FAILED && radio.failures() == 1);
+    CHECK(sim.commands.size() == DRA818_RETRIES + 2u && sim.squelch == DRA818_MAX_SQUELCH);
+
+    //a module that never answers
+    host_set_serial_peer(0);
+    radio.init();
+    CHECK(settle(radio) >= DRA818_BOOT_MS + 2 * (DRA818_RETRIES + 1) * DRA818_REPLY_TIMEOUT_MS);
+    CHECK(radio.state() == DRA818_FAILED && radio.failures() == 2);
+}
+
+static DRA818Sim* planSim = 0;
+static DRA818V* planRadio = 0;
+static std::map<uint32_t, long> samplesOn; //DAC samples by the frequency the simulated module was on
+
+static void countByFrequency(uint8_t pin, int value) {
+    (void) value;
+    if(pin == SINK_PIN) samplesOn[planSim->txHz]++;
+}
+
+//Frames for different channels of the plan: the transmitter retunes before each key-up and never mixes channels
+static void checkChannelPlan() {
+    static const DRA818Channel plan[] = {
+        {144390000, 144390000, "0000", "0000", true},
+        {145825000, 145825000, "0000", "0000", true} //ISS digipeater
+    };
+    DRA818Sim sim;
+    planSim = &sim;
+    host_set_serial_peer(&sim);
+    DRA818V radio(PTT_PIN, AUDIO_PIN, MIC_PIN, DRATX, DRARX);
+    static const DRA818Channel badPlan[] = {
+        {144390000, 144390000, "0000", "0000", true},
+        {145825000, 145825000, "00000", "0000", true}
+    };
+    CHECK(radio.setChannels(badPlan, 2) == 1 && !radio.tune(1)); //stops at the entry that doesn't render
+    CHECK(radio.setChannels(plan, 2) == 2);
+    CHECK(!radio.tune(2));
+    radio.init();
+    settle(radio);
+    CHECK(radio.ready() && radio.channel() == 0 && sim.txHz == 144390000);
+
+    const uint32_t start = millis();
+    CHECK(radio.tune(1) && !radio.tuned(1));
+    while(!radio.tuned(1) && millis() - start < 5000) {
+        radio.poll();
+        delay(1);
+    }
+    const uint32_t latency = millis() - start;
+    CHECK(latency >= DRA818_SETTLE_MS && latency < 150 && sim.txHz == 145825000);
+
+    SSID ssids[] = {
+        {(char*) "APRS", 0},
+        {(char*) "KM6HBK", 11}
+    };
+    APRS aprs(&radio, ssids, 2);
+    host_set_analog_write_hook(countByFrequency);
+    samplesOn.clear();
+    const uint8_t channels[] = {0, 1, 1, 0}; //three key-ups: {0}, {1, 1}, {0}
+    long bits[2] = {0, 0};
+    for(uint8_t channel : channels) {
+        aprs.setChannel(channel);
+        CHECK(aprs.sendPacketNoGPS(String(">channel test")));
+        bits[channel] += aprs.getPacketSize();
+    }
+    CHECK(samplesOn.empty()); //the radio is on channel 1, the first frame waits for the retune
+    while(txQueue.queued() && millis() - start < 20000) {
+        radio.poll();
+        if(!host_timer_step()) delay(1);
+    }
+    host_run_timers(); //the last frame has left the queue, let it play out
+    CHECK(txQueue.queued() == 0 && radio.channel() == 0);
+#if AFSK_SINK != AFSK_SINK_PCM //counted through the sink's pin
+    long expected[2] = {(2 * TXDELAY_FLAGS * 8 + bits[0]) * (long) SAMPLES_PER_BIT,
+                        (TXDELAY_FLAGS * 8 + bits[1]) * (long) SAMPLES_PER_BIT};
+#if AFSK_PIPELINE == AFSK_PIPELINE_BLOCK
+    //every key-up plays its last block out in full
+    expected[0] = ((TXDELAY_FLAGS * 8 + bits[0] / 2) * (long) SAMPLES_PER_BIT / AFSK_BLOCK_SAMPLES + 1) * AFSK_BLOCK_SAMPLES * 2;
+    expected[1] = (expected[1] / AFSK_BLOCK_SAMPLES + 1) * AFSK_BLOCK_SAMPLES;
+#endif
+    CHECK(samplesOn[144390000] == expected[0] + 2 * SINK_PARK_WRITES); //parked at mid-scale after each unkey
+    CHECK(samplesOn[145825000] == expected[1] + SINK_PARK_WRITES);
+#endif
+    CHECK(std::count_if(sim.commands.begin(), sim.commands.end(),
+                        [](const std::string& c) { return c.compare(0, 15, "AT+DMOSETGROUP=") == 0; }) == 5);
+
+    //a channel the module keeps refusing: its frames are dropped once the retries run out, the rest go out
+    sim.commands.clear();
+    samplesOn.clear();
+    sim.refuseCommands(DRA818_RETRIES + 1);
+    long sentBits = 0;
+    for(uint8_t channel : {1, 1, 0}) {
+        aprs.setChannel(channel);
+        CHECK(aprs.sendPacketNoGPS(String(">channel test")));
+        sentBits = aprs.getPacketSize();
+    }
+    const uint32_t refusedAt = millis();
+    while(txQueue.queued() && millis() - refusedAt < 20000) {
+        radio.poll();
+        if(!host_timer_step()) delay(1);
+    }
+    host_run_timers();
+    CHECK(txQueue.queued() == 0 && millis() - refusedAt < (DRA818_RETRIES + 2) * DRA818_REPLY_TIMEOUT_MS);
+    CHECK(radio.state() == DRA818_FAILED && radio.failures() == 1 && radio.channel() == 0);
+    CHECK(sim.commands.size() == DRA818_RETRIES + 2u); //channel 1 three times, then channel 0
+    long sent = (TXDELAY_FLAGS * 8 + sentBits) * (long) SAMPLES_PER_BIT;
+#if AFSK_PIPELINE == AFSK_PIPELINE_BLOCK
+    sent = (sent / AFSK_BLOCK_SAMPLES + 1) * AFSK_BLOCK_SAMPLES;
+#endif
+#if AFSK_SINK != AFSK_SINK_PCM
+    CHECK(samplesOn.size() == 1 && samplesOn[144390000] == sent + SINK_PARK_WRITES); //only the channel 0 frame
+#else
+    (void) sent;
+#endif
+
+    //the next frame for it tries again
+    aprs.setChannel(1);
+    CHECK(aprs.sendPacketNoGPS(String(">channel test")));
+    while(txQueue.queued() && millis() - refusedAt < 20000) {
+        radio.poll();
+        if(!host_timer_step()) delay(1);
+    }
+    host_run_timers();
+    CHECK(txQueue.queued() == 0 && radio.channel() == 1);
+#if AFSK_SINK != AFSK_SINK_PCM
+    CHECK(samplesOn[145825000] > 0);
+#endif
+
+    //the transmit interrupt retunes while loop() is inside tune() for the same channel: one command between them
+    settle(radio);
+    sim.commands.clear();
+    planRadio = &radio;
+    host_set_interrupt_hook([]() {
+        host_set_interrupt_hook(0);
+        planRadio->tune(0);
+    });
+    CHECK(radio.tune(0));
+    settle(radio);
+    CHECK(sim.commands.size() == 1 && radio.channel() == 0);
+
+    afsk_set_radio(0);
+    host_set_analog_write_hook(0);
+    host_set_serial_peer(0);
+}
+
+int main() {
+    host_set_serial_echo(false);
+#if AFSK_SINK == AFSK_SINK_PCM
+    Sink::stream = fopen("/dev/null", "wb"); //the checks count samples themselves, stdout stays clean
+#endif
+    checkCRC();
+    checkStuffing();
+    checkHeaderCache();
+    checkToneFrequency();
+    checkG3RUH();
+    checkDemodulator();
+    checkFX25();
+    checkParser();
+    checkDigipeater();
+    checkCompressed();
+    checkPayload();
+    checkMicE();
+    checkTelemetry();
+    checkScheduler();
+    checkProfile();
+    checkSinks();
+    checkDRA818();
+    checkChannelPlan();
+    checkTransmitQueue();
+    if(failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
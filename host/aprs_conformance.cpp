@@ -0,0 +1,351 @@
+//Encoder conformance suite, run by `make check`:
+//  golden vectors   frames from golden/golden_vectors.h, generated by a separate bit-by-bit encoder, are sent
+//                   through APRS (cached header and sendFrame) and compared bit for bit: length, FCS and the
+//                   NRZI line levels, both as computed from the queued bitstream and as tones on the DAC
+//  differential     random paths and information fields, heavy on stuffing, against a reference encoder
+//  limits           frames too long for a slot are refused instead of overrunning it
+//  streaming        the same frames encoded a chunk at a time by AX25Stream, up to the longest AX.25 frame
+#include "afsk.h"
+#include "aprs.h"
+#include "crc16.h"
+#include "golden/golden_vectors.h"
+#include <algorithm>
+#include <math.h>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if(!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while(0)
+
+//A path as SSIDs plus the strings they point into
+struct Path {
+    std::vector<std::string> calls;
+    std::vector<SSID> ssids;
+};
+
+static Path parsePath(const char* text) {
+    Path path;
+    std::string all = text;
+    size_t start = 0;
+    while(start <= all.size()) {
+        size_t comma = all.find(',', start);
+        if(comma == std::string::npos) comma = all.size();
+        const std::string entry = all.substr(start, comma - start);
+        const size_t dash = entry.find('-');
+        path.calls.push_back(entry.substr(0, dash));
+        path.ssids.push_back({0, (uint8_t) atoi(entry.c_str() + dash + 1)});
+        start = comma + 1;
+    }
+    for(size_t i = 0; i < path.calls.size(); i++) {
+        path.ssids[i].address = path.calls[i].c_str();
+    }
+    return path;
+}
+
+static int bitAt(const uint8_t* bits, int i) {
+    return (bits[i / 8] >> (7 - i % 8)) & 1;
+}
+
+//Line levels of a bitstream from an idle mark: a 0 changes the level
+static std::vector<uint8_t> nrzi(const std::vector<uint8_t>& bits) {
+    std::vector<uint8_t> levels;
+    int level = 1;
+    for(uint8_t bit : bits) {
+        if(!bit) level ^= 1;
+        levels.push_back(level);
+    }
+    return levels;
+}
+
+static std::vector<uint8_t> nrzi(const TxFrame* frame) {
+    std::vector<uint8_t> bits;
+    for(int i = 0; i < frame->size; i++) bits.push_back(bitAt(frame->bits, i));
+    return nrzi(bits);
+}
+
+//Runs an AX25Stream to the end and strings its chunks together, one entry per bit
+static std::vector<uint8_t> streamedBits(const AX25FrameSource& source) {
+    AX25Stream stream;
+    stream.begin(source);
+    std::vector<uint8_t> bits;
+    uint8_t chunk[AX25_STREAM_CHUNK_BYTES];
+    for(int size; (size = stream.next(chunk)) > 0;) {
+        if(size > AX25_STREAM_CHUNK_BYTES * 8) return std::vector<uint8_t>(); //overran the chunk
+        for(int i = 0; i < size; i++) bits.push_back(bitAt(chunk, i));
+    }
+    return bits;
+}
+
+//An AX25InfoReader over a string that hands out at most limit bytes per call, to split reads unevenly
+struct InfoReader {
+    const std::string* text;
+    size_t position;
+    int limit;
+};
+
+static int readInfo(void* context, uint8_t* out, int capacity) {
+    InfoReader* reader = (InfoReader*) context;
+    int count = std::min((int) (reader->text->size() - reader->position), std::min(capacity, reader->limit));
+    memcpy(out, reader->text->data() + reader->position, count);
+    reader->position += count;
+    return count;
+}
+
+static bool levelsMatch(const std::vector<uint8_t>& levels, const GoldenVector& vector) {
+    if((int) levels.size() != vector.bits) return false;
+    for(int i = 0; i < vector.bits; i++) {
+        if(levels[i] != bitAt((const uint8_t*) vector.nrzi, i)) return false;
+    }
+    return true;
+}
+
+//The on-air checks read the tones back off the DAC at full resolution
+#define CHECK_ON_AIR (APRS_MODEM == MODEM_AFSK1200 && AFSK_SINK == AFSK_SINK_DAC)
+
+#if CHECK_ON_AIR
+static std::vector<uint16_t> dacSamples;
+
+static void captureDAC(uint8_t pin, int value) {
+    if(pin == MIC_PIN) dacSamples.push_back(value);
+}
+
+//Which tone a bit period carries: DFT power at mark and space, the mark boosted back by the transmit twist
+static int toneAt(const uint16_t* samples) {
+    double power[2];
+    const int freqs[2] = {SPACE_FREQ, MARK_FREQ};
+    for(int t = 0; t < 2; t++) {
+        double re = 0, im = 0;
+        for(int n = 0; n < (int) SAMPLES_PER_BIT; n++) {
+            const double phase = 2 * M_PI * freqs[t] * n / SAMPLE_RATE;
+            re += (samples[n] - (double) AFSK_IDLE_LEVEL) * cos(phase);
+            im += (samples[n] - (double) AFSK_IDLE_LEVEL) * sin(phase);
+        }
+        power[t] = re * re + im * im;
+    }
+    return power[1] / (PREEMPHASIS_RATIO * PREEMPHASIS_RATIO) > power[0];
+}
+
+//Plays the queue through radioISR and reads the frame back off the DAC, one tone per bit after TXDELAY
+static std::vector<uint8_t> transmittedLevels(int bits) {
+    dacSamples.clear();
+    host_set_analog_write_hook(captureDAC);
+    host_run_timers();
+    host_set_analog_write_hook(0);
+    std::vector<uint8_t> levels;
+    const size_t first = (size_t) TXDELAY_FLAGS * 8 * SAMPLES_PER_BIT; //the flags leave the line at mark
+    for(int i = 0; i < bits && first + (i + 1) * SAMPLES_PER_BIT <= dacSamples.size(); i++) {
+        levels.push_back(toneAt(&dacSamples[first + i * SAMPLES_PER_BIT]));
+    }
+    return levels;
+}
+#endif
+
+static void checkGoldenVectors() {
+    DRA818V radio(PTT_PIN, AUDIO_PIN, MIC_PIN, DRATX, DRARX);
+    for(const GoldenVector& vector : GOLDEN_VECTORS) {
+        Path path = parsePath(vector.path);
+        const AX25Header header = ax25_header(path.ssids.data(), path.ssids.size());
+        APRS aprs(&radio, path.ssids.data(), path.ssids.size());
+        std::string info(vector.info, vector.infoLength);
+
+        uint8_t body[AX25_MAX_ADDRESSES * AX25_ADDRESS_LENGTH + 2 + 256];
+        memcpy(body, header.address, header.addressLength);
+        body[header.addressLength] = AX25_CONTROL_UI;
+        body[header.addressLength + 1] = AX25_PID_NO_LAYER3;
+        memcpy(body + header.addressLength + 2, vector.info, vector.infoLength);
+        const bool fcsMatches = (uint16_t) ~crc16_update(CRC16_INIT, body, header.addressLength + 2 + vector.infoLength) == vector.fcs;
+
+        afsk_cancel();
+        const bool sent = aprs.sendPacketNoGPS((char*) info.c_str());
+        const bool cachedMatches = sent && levelsMatch(nrzi(txQueue.front()), vector);
+#if CHECK_ON_AIR
+        const bool airMatches = sent && levelsMatch(transmittedLevels(vector.bits), vector);
+#else
+        const bool airMatches = true;
+#endif
+        afsk_cancel();
+        const bool rawSent = aprs.sendFrame(header.address, header.addressLength, (const uint8_t*) vector.info, vector.infoLength);
+        const bool rawMatches = rawSent && levelsMatch(nrzi(txQueue.front()), vector);
+        afsk_cancel();
+        const AX25FrameSource source = {&header, (const uint8_t*) vector.info, vector.infoLength, 0, 0};
+        const bool streamMatches = levelsMatch(nrzi(streamedBits(source)), vector);
+        const bool streamSent = aprs.streamPacket((const uint8_t*) vector.info, vector.infoLength);
+#if CHECK_ON_AIR
+        const bool streamAirMatches = streamSent && levelsMatch(transmittedLevels(vector.bits), vector);
+#else
+        const bool streamAirMatches = streamSent;
+#endif
+        afsk_cancel();
+        if(!(fcsMatches && cachedMatches && airMatches && rawMatches && streamMatches && streamAirMatches)) {
+            fprintf(stderr, "golden vector \"%s\": fcs %d, cached header %d, on air %d, sendFrame %d, "
+                    "streamed %d, streamed on air %d\n", vector.name, fcsMatches, cachedMatches, airMatches,
+                    rawMatches, streamMatches, streamAirMatches);
+            failures++;
+        }
+    }
+}
+
+//Bit-serial encoder written from the spec: the same frame layout APRS produces, one bit at a time
+static std::vector<uint8_t> referenceBits(const std::vector<uint8_t>& body) {
+    std::vector<uint8_t> bits;
+    auto flag = [&bits]() { for(int i = 0; i < 8; i++) bits.push_back((HDLC_FLAG >> i) & 1); };
+    for(int i = 0; i < N_HDLC_FLAGS; i++) flag();
+    uint16_t crc = 0xFFFF;
+    int ones = 0;
+    auto put = [&bits, &ones](uint8_t byte) {
+        for(int i = 0; i < 8; i++) {
+            const int bit = (byte >> i) & 1;
+            bits.push_back(bit);
+            ones = bit ? ones + 1 : 0;
+            if(ones == 5) {
+                bits.push_back(0);
+                ones = 0;
+            }
+        }
+    };
+    for(uint8_t byte : body) {
+        for(int i = 0; i < 8; i++) {
+            crc = ((crc ^ (byte >> i)) & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+        }
+        put(byte);
+    }
+    put(~crc & 0xFF);
+    put(~crc >> 8);
+    flag();
+    return bits;
+}
+
+static bool sameBits(const TxFrame* frame, const std::vector<uint8_t>& bits) {
+    if(!frame || frame->size != (int) bits.size()) return false;
+    for(size_t i = 0; i < bits.size(); i++) {
+        if(bitAt(frame->bits, i) != bits[i]) return false;
+    }
+    return true;
+}
+
+static void checkDifferential() {
+    DRA818V radio(PTT_PIN, AUDIO_PIN, MIC_PIN, DRATX, DRARX);
+    uint32_t seed = 18;
+    auto next = [&seed]() { seed = seed * 1103515245 + 12345; return seed >> 16; };
+    static const char CALL_CHARS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    int mismatches = 0, refused = 0;
+    for(int trial = 0; trial < 3000; trial++) {
+        Path path;
+        const int addresses = 2 + next() % (AX25_MAX_ADDRESSES - 1);
+        for(int a = 0; a < addresses; a++) {
+            std::string call;
+            for(int n = 1 + next() % 6; n > 0; n--) call += CALL_CHARS[next() % 36];
+            path.calls.push_back(call);
+            path.ssids.push_back({0, (uint8_t) (next() % 16)});
+        }
+        for(int a = 0; a < addresses; a++) path.ssids[a].address = path.calls[a].c_str();
+        //mostly printable text, every fourth frame all 0xFF-ish to stuff as hard as possible
+        std::string info;
+        const int length = next() % 230;
+        for(int i = 0; i < length; i++) {
+            info += (char) (trial % 4 == 0 ? (next() | 0xF7) : 32 + next() % 95);
+        }
+
+        const AX25Header header = ax25_header(path.ssids.data(), path.ssids.size());
+        std::vector<uint8_t> body(header.address, header.address + header.addressLength);
+        body.push_back(AX25_CONTROL_UI);
+        body.push_back(AX25_PID_NO_LAYER3);
+        body.insert(body.end(), info.begin(), info.end());
+        const std::vector<uint8_t> expected = referenceBits(body);
+        const bool fits = (int) expected.size() <= BUFFER_SIZE_MAX * 8;
+
+        APRS aprs(&radio, path.ssids.data(), path.ssids.size());
+        afsk_cancel();
+        const bool sent = aprs.sendPacketNoGPS((char*) info.c_str());
+        if(sent != fits || (sent && !sameBits(txQueue.front(), expected))) mismatches++;
+        afsk_cancel();
+        const bool rawSent = aprs.sendFrame(header.address, header.addressLength, (const uint8_t*) info.data(), info.size());
+        if(rawSent != fits || (rawSent && !sameBits(txQueue.front(), expected))) mismatches++;
+        afsk_cancel();
+        refused += !fits;
+
+        //streamed, whether or not it fits a slot
+        const AX25FrameSource span = {&header, (const uint8_t*) info.data(), (int) info.size(), 0, 0};
+        if(streamedBits(span) != expected) mismatches++;
+        InfoReader reader = {&info, 0, 1 + trial % 23};
+        const AX25FrameSource pulled = {&header, 0, 0, readInfo, &reader};
+        if(streamedBits(pulled) != expected) mismatches++;
+    }
+    printf("differential: 3000 random frames, %d too long for a slot and refused\n", refused);
+    CHECK(mismatches == 0);
+}
+
+//Frames that don't fit a TxFrame slot are refused and leave the queue untouched; long strings don't hang loadString
+static void checkLimits() {
+    DRA818V radio(PTT_PIN, AUDIO_PIN, MIC_PIN, DRATX, DRARX);
+    SSID path[] = {{"APRS", 0}, {"KM6HBK", 11}, {"WIDE2", 1}};
+    APRS aprs(&radio, path, 3);
+    afsk_cancel();
+    const std::string longest(224, 'A');
+    const std::string tooLong(300, 'A');
+    CHECK(aprs.sendPacketNoGPS((char*) longest.c_str()));
+    CHECK(!aprs.sendPacketNoGPS((char*) tooLong.c_str()));
+    CHECK(!aprs.sendPacketNoGPS(String(tooLong.c_str())));
+    CHECK(!aprs.sendPacketGPS(16, 12, 30, 37.4f, -122.1f, 100.0f, 90, 12.0f, tooLong.c_str()));
+    CHECK(txQueue.queued() == 1);
+    afsk_cancel();
+}
+
+//The longest frame AX.25 allows, 8 digipeaters and 256 bytes that stuff after every five bits, doesn't fit a
+//slot but streams, from a span and from a reader; a reader with more to give is cut at the limit
+static void checkStreaming() {
+    DRA818V radio(PTT_PIN, AUDIO_PIN, MIC_PIN, DRATX, DRARX);
+    Path path = parsePath("APRS-0,KM6HBK-11,WIDE1-1,WIDE2-2,RELAY-0,TRACE3-3,NOCALL-15,SPACE-7,ISS-0,ARISS-0");
+    const AX25Header header = ax25_header(path.ssids.data(), path.ssids.size());
+    const std::string info(AX25_MAX_INFO_LENGTH, (char) 0xFF);
+    std::vector<uint8_t> body(header.address, header.address + header.addressLength);
+    body.push_back(AX25_CONTROL_UI);
+    body.push_back(AX25_PID_NO_LAYER3);
+    body.insert(body.end(), info.begin(), info.end());
+    const std::vector<uint8_t> expected = referenceBits(body);
+    CHECK((int) expected.size() > BUFFER_SIZE_MAX * 8);
+
+    const AX25FrameSource span = {&header, (const uint8_t*) info.data(), (int) info.size(), 0, 0};
+    CHECK(streamedBits(span) == expected);
+    const std::string more(AX25_MAX_INFO_LENGTH + 40, (char) 0xFF);
+    InfoReader reader = {&more, 0, AX25_STREAM_READ_BYTES};
+    const AX25FrameSource pulled = {&header, 0, 0, readInfo, &reader};
+    CHECK(streamedBits(pulled) == expected);
+    CHECK(reader.position == (size_t) AX25_MAX_INFO_LENGTH);
+
+    APRS aprs(&radio, path.ssids.data(), path.ssids.size());
+    afsk_cancel();
+    CHECK(!aprs.sendPacketNoGPS((char*) info.c_str()));
+    CHECK(!aprs.streamPacket((const uint8_t*) more.data(), more.size()));
+    CHECK(aprs.streamPacket((const uint8_t*) info.data(), info.size()));
+#if CHECK_ON_AIR
+    CHECK(transmittedLevels(expected.size()) == nrzi(expected));
+#else
+    host_run_timers();
+#endif
+    CHECK(txQueue.queued() == 0);
+    afsk_cancel();
+}
+
+int main() {
+    host_set_serial_echo(false);
+#if AFSK_SINK == AFSK_SINK_PCM
+    Sink::stream = fopen("/dev/null", "wb"); //stdout only carries the summary
+#endif
+    checkGoldenVectors();
+    checkDifferential();
+    checkLimits();
+    checkStreaming();
+    if(failures) {
+        fprintf(stderr, "%d conformance check(s) failed\n", failures);
+        return 1;
+    }
+    printf("%d golden vectors, all conformance checks passed\n", (int) (sizeof(GOLDEN_VECTORS) / sizeof(GOLDEN_VECTORS[0])));
+    return 0;
+}
@@ -0,0 +1,30 @@
+//Decodes AFSK1200 APRS frames from a WAV recording with the library's receive demodulator and prints them
+//in the usual monitor format, SOURCE>DEST,PATH:info, followed by a count of good frames and FCS errors.
+#include "demod.h"
+#include "monitor.h"
+#include "wav.h"
+#include <stdio.h>
+#include <string.h>
+
+int main(int argc, char** argv) {
+    if(argc != 2) {
+        fprintf(stderr, "usage: aprs_decode <recording.wav>\n");
+        return 2;
+    }
+    std::vector<int16_t> samples;
+    uint32_t rate = 0;
+    if(!wav_read(argv[1], samples, rate)) {
+        fprintf(stderr, "aprs_decode: could not read %s\n", argv[1]);
+        return 1;
+    }
+    AFSKDemodConfig config = AFSK_DEMOD_DEFAULTS;
+    config.sampleRate = rate;
+    AFSKDemodulator demod(config);
+    for(size_t i = 0; i < samples.size(); i++) {
+        if(demod.process(samples[i])) {
+            monitor_print(stdout, demod.frame(), demod.frameLength());
+        }
+    }
+    fprintf(stderr, "%u frames, %u FCS errors\n", (unsigned) demod.frames(), (unsigned) demod.fcsErrors());
+    return 0;
+}
@@ -0,0 +1,417 @@
+//Traffic generator for load-testing receivers and digipeaters. Many simulated stations beacon over a common
+//channel: each has its own path, payload kind, TXDELAY, level and clock error, and beacons at a jittered interval
+//chosen so the channel carries the requested offered load. Stations render their bursts on a pool of threads
+//through the library's APRS encoder and a modem template, then the bursts are summed (or spread over channels of
+//a multi-channel WAV) with white noise, again in parallel, one slice of the output per task.
+//The ground truth goes to stdout in time order, one frame per line: start and end (closing flag) time, channel,
+//'*' when it overlaps another burst on its channel, and the frame as aprs_decode and aprs_batch print it.
+//The output only depends on the options and the seed, not on the thread count.
+#include "afsk.h"
+#include "aprs.h"
+#include "crc16.h"
+#include "monitor.h"
+#include "wav.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <math.h>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const int TAIL_FLAGS = 3;
+static const double SLICE_SECONDS = 10; //output mixed per task
+static const double MAX_DRIFT_PPM = 100; //station clocks are off by up to this much, both ways
+
+struct Options {
+    int stations;
+    double seconds;
+    double load; //offered load: fraction of the time a channel is keyed, summed over its stations
+    int channels;
+    double snr; //dB, of a full level station against the noise; negative for no noise
+    uint32_t seed;
+    int threads;
+};
+
+//Small, fast and seedable, so every station and slice gets its own reproducible stream
+class Random
+{
+public:
+    Random(uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ull + 1) {}
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state >> 32;
+    }
+    double uniform() { return next() / 4294967296.0; }
+    double uniform(double low, double high) { return low + (high - low) * uniform(); }
+    //Irwin-Hall approximation: close enough to gaussian for channel noise and cheap enough for hours of it
+    double gaussian() { return (uniform() + uniform() + uniform() + uniform() - 2) * 1.7320508; }
+private:
+    uint64_t state;
+};
+
+enum PayloadKind {
+    PAYLOAD_PLAIN,
+    PAYLOAD_COMPRESSED,
+    PAYLOAD_MICE,
+    PAYLOAD_STATUS,
+    PAYLOAD_KINDS
+};
+
+struct Burst {
+    size_t start; //output sample
+    int channel;
+    std::vector<int16_t> samples;
+};
+
+struct Truth {
+    double start;
+    double end;
+    int channel;
+    bool collided;
+    std::vector<uint8_t> frame;
+};
+
+struct Station {
+    int index;
+    char callsign[8];
+    std::vector<SSID> path;
+    PayloadKind kind;
+    int channel;
+    double gain;
+    double drift; //clock rate relative to nominal, 1 + ppm / 1e6
+    int txDelayFlags;
+    int32_t latitude, longitude; //1e-7 degrees, random walk
+    uint16_t sequence;
+    std::vector<Burst> bursts;
+    std::vector<Truth> truths;
+};
+
+//The APRS encoder queues into the library's one txQueue, so stations take turns with it. Encoding is
+//microseconds per frame against milliseconds of modulation, which runs unlocked.
+static std::mutex encoderLock;
+
+//The frame between the opening and closing flags of a queued bitstream, stuffed zeros removed and FCS checked
+//and dropped. Returns its length, -1 if the FCS is wrong.
+static int unstuff(const TxFrame& sent, uint8_t* out, int capacity) {
+    int ones = 0, bits = 0, length = 0;
+    uint8_t byte = 0;
+    for(int i = 0; i < sent.size; i++) {
+        const int bit = (sent.bits[i / 8] >> (7 - i % 8)) & 1;
+        if(bit) {
+            ones++;
+        } else if(ones == 5) {
+            ones = 0;
+            continue; //stuffed
+        } else if(ones == 6) {
+            //a flag: its first seven bits never made a whole byte
+            if(length > 2) {
+                const uint16_t fcs = ~crc16_update(CRC16_INIT, out, length - 2);
+                return (out[length - 2] | (out[length - 1] << 8)) == fcs ? length - 2 : -1;
+            }
+            ones = bits = length = 0;
+            byte = 0;
+            continue;
+        } else {
+            ones = 0;
+        }
+        byte |= bit << bits;
+        if(++bits == 8) {
+            if(length < capacity) out[length++] = byte;
+            bits = 0;
+            byte = 0;
+        }
+    }
+    return -1;
+}
+
+//Encodes the station's next beacon through APRS and copies the frame out of the queue
+static bool encodeBeacon(APRS& aprs, Station& station, Random& random, TxFrame& frame) {
+    station.latitude += (int32_t) random.uniform(-20000, 20000);
+    station.longitude += (int32_t) random.uniform(-20000, 20000);
+    const uint16_t heading = random.next() % 360;
+    const uint16_t speed = random.next() % 60;
+    const int32_t altitude = 100 + random.next() % 3000;
+    char comment[48];
+    snprintf(comment, sizeof(comment), "%s load test %u", station.callsign, (unsigned) station.sequence++);
+    std::lock_guard<std::mutex> guard(encoderLock);
+    afsk_cancel();
+    bool sent = false;
+    switch(station.kind) {
+    case PAYLOAD_PLAIN:
+        sent = aprs.sendPacketGPS(1 + random.next() % 28, random.next() % 24, random.next() % 60,
+                                  station.latitude * 1e-7f, station.longitude * 1e-7f, (float) altitude, heading,
+                                  (float) speed, comment);
+        break;
+    case PAYLOAD_COMPRESSED:
+        sent = aprs.sendPacketCompressedFixed(1 + random.next() % 28, random.next() % 24, random.next() % 60,
+                                              station.latitude, station.longitude, altitude, heading, speed, comment);
+        break;
+    case PAYLOAD_MICE:
+        sent = aprs.sendPacketMicE(station.latitude, station.longitude, altitude, heading, speed, MICE_EN_ROUTE, comment);
+        break;
+    default:
+        char status[sizeof(comment) + 1];
+        snprintf(status, sizeof(status), ">%s", comment);
+        sent = aprs.sendPacketNoGPS(status);
+        break;
+    }
+    if(sent) {
+        frame = *txQueue.front();
+    }
+    afsk_cancel();
+    return sent;
+}
+
+//Modulates TXDELAY flags, the frame and a few tail flags at the station's level, then resamples by its clock
+//error with linear interpolation
+template <class M>
+static std::vector<int16_t> modulate(const Station& station, const TxFrame& frame) {
+    static const uint8_t flag = HDLC_FLAG;
+    M modem;
+    modem.reset();
+    std::vector<int16_t> nominal;
+    uint16_t sample;
+    const double scale = station.gain * (1 << (15 - SINE_WAVE_RESOLUTION));
+    for(int f = 0; f < station.txDelayFlags + 1 + TAIL_FLAGS; f++) {
+        if(f == station.txDelayFlags) {
+            modem.load(frame.bits, frame.size);
+        } else {
+            modem.load(&flag, 8);
+        }
+        while(modem.next(&sample)) {
+            nominal.push_back((int16_t) lrint(((int) sample - AFSK_IDLE_LEVEL) * scale));
+        }
+    }
+    std::vector<int16_t> out;
+    out.reserve(nominal.size() / station.drift + 1);
+    for(double t = 0; t < nominal.size() - 1; t += station.drift) {
+        const size_t i = (size_t) t;
+        const double fraction = t - i;
+        out.push_back((int16_t) lrint(nominal[i] * (1 - fraction) + nominal[i + 1] * fraction));
+    }
+    return out;
+}
+
+//One station for the whole run: beacons at its interval, stretched by its clock error and jittered by a quarter
+template <class M>
+static void renderStation(Station& station, const Options& options, double interval, DRA818V* radio) {
+    Random random(((uint64_t) options.seed << 20) + station.index);
+    APRS* aprs;
+    {
+        std::lock_guard<std::mutex> guard(encoderLock);
+        aprs = new APRS(radio, station.path.data(), station.path.size());
+    }
+    const double bitSamples = (double) M::SAMPLE_RATE / M::BIT_RATE;
+    double at = random.uniform(0, interval);
+    TxFrame frame;
+    uint8_t bytes[BUFFER_SIZE_MAX];
+    while(at < options.seconds) {
+        if(encodeBeacon(*aprs, station, random, frame)) {
+            Burst burst;
+            burst.start = (size_t) (at * M::SAMPLE_RATE);
+            burst.channel = station.channel;
+            burst.samples = modulate<M>(station, frame);
+            const int length = unstuff(frame, bytes, sizeof(bytes));
+            if(length > 0) {
+                //the closing flag ends TAIL_FLAGS flags before the burst does
+                const double end = burst.start + burst.samples.size() - TAIL_FLAGS * 8 * bitSamples / station.drift;
+                station.truths.push_back({at, end / M::SAMPLE_RATE, station.channel, false,
+                                          std::vector<uint8_t>(bytes, bytes + length)});
+            }
+            station.bursts.push_back(std::move(burst));
+        }
+        at += interval * station.drift * random.uniform(0.75, 1.25);
+    }
+    std::lock_guard<std::mutex> guard(encoderLock);
+    delete aprs;
+}
+
+//Sums the bursts that touch one slice of the output into it, with this slice's noise
+static void mixSlice(std::vector<int16_t>& out, size_t slice, size_t sliceSamples, const std::vector<const Burst*>& bursts,
+                     const Options& options) {
+    const size_t frames = out.size() / options.channels;
+    const size_t begin = slice * sliceSamples;
+    const size_t end = std::min(frames, begin + sliceSamples);
+    std::vector<int32_t> sum((end - begin) * options.channels, 0);
+    for(const Burst* burst : bursts) {
+        const size_t from = std::max(begin, burst->start);
+        const size_t to = std::min(end, burst->start + burst->samples.size());
+        for(size_t i = from; i < to; i++) {
+            sum[(i - begin) * options.channels + burst->channel] += burst->samples[i - burst->start];
+        }
+    }
+    Random random(((uint64_t) options.seed << 32) ^ (slice + 1));
+    const double noise = options.snr < 0 ? 0 : (1 << 14) * 0.7071 / pow(10, options.snr / 20); //against a half scale sine
+    for(size_t i = 0; i < sum.size(); i++) {
+        const double value = sum[i] + (noise > 0 ? noise * random.gaussian() : 0);
+        out[begin * options.channels + i] = (int16_t) std::max(-32768.0, std::min(32767.0, value));
+    }
+}
+
+template <class M>
+static bool generate(const Options& options, const char* path) {
+    std::vector<Station> stations(options.stations);
+    static const char* const wides[] = {"WIDE1", "WIDE2", "WIDE2"};
+    Random setup(options.seed);
+    for(int i = 0; i < options.stations; i++) {
+        Station& station = stations[i];
+        station.index = i;
+        snprintf(station.callsign, sizeof(station.callsign), "T%05d", i % 100000);
+        station.path.push_back({"APRS", 0});
+        station.path.push_back({station.callsign, (uint8_t) (setup.next() % 16)});
+        const int hops = setup.next() % 3;
+        for(int h = 0; h < hops; h++) {
+            station.path.push_back({wides[h], (uint8_t) (h + 1)});
+        }
+        station.kind = (PayloadKind) (setup.next() % PAYLOAD_KINDS);
+        station.channel = i % options.channels;
+        station.gain = setup.uniform(0.25, 1);
+        station.drift = 1 + setup.uniform(-MAX_DRIFT_PPM, MAX_DRIFT_PPM) * 1e-6;
+        station.txDelayFlags = (int) (setup.uniform(0.1, 0.4) * M::BIT_RATE / 8); //100 to 400 ms
+        station.latitude = (int32_t) setup.uniform(30e7, 45e7);
+        station.longitude = (int32_t) setup.uniform(-125e7, -75e7);
+        station.sequence = 0;
+    }
+    //a burst is TXDELAY (250 ms on average), about 70 stuffed bytes of frame and the tail
+    const double burstSeconds = 0.25 + (70 + TAIL_FLAGS) * 8.0 / M::BIT_RATE;
+    const double interval = burstSeconds * options.stations / options.channels / options.load;
+
+    host_set_serial_echo(false);
+    DRA818V radio(PTT_PIN, AUDIO_PIN, MIC_PIN, DRATX, DRARX);
+    const std::chrono::steady_clock::time_point began = std::chrono::steady_clock::now();
+    std::atomic<int> next(0);
+    std::vector<std::thread> pool;
+    for(int t = 0; t < options.threads; t++) {
+        pool.emplace_back([&]() {
+            for(int i; (i = next++) < options.stations;) {
+                renderStation<M>(stations[i], options, interval, &radio);
+            }
+        });
+    }
+    for(std::thread& thread : pool) thread.join();
+
+    //truth, with overlaps on the same channel marked, and the bursts each slice has to sum
+    std::vector<Truth> truths;
+    for(Station& station : stations) {
+        truths.insert(truths.end(), station.truths.begin(), station.truths.end());
+    }
+    std::sort(truths.begin(), truths.end(), [](const Truth& a, const Truth& b) { return a.start < b.start; });
+    for(size_t i = 0; i < truths.size(); i++) {
+        for(size_t j = i + 1; j < truths.size() && truths[j].start < truths[i].end; j++) {
+            if(truths[j].channel == truths[i].channel) {
+                truths[i].collided = truths[j].collided = true;
+            }
+        }
+    }
+    const size_t frames = (size_t) (options.seconds * M::SAMPLE_RATE);
+    const size_t sliceSamples = (size_t) (SLICE_SECONDS * M::SAMPLE_RATE);
+    const size_t slices = (frames + sliceSamples - 1) / sliceSamples;
+    std::vector<std::vector<const Burst*>> sliceBursts(slices);
+    double keyed = 0;
+    for(const Station& station : stations) {
+        for(const Burst& burst : station.bursts) {
+            keyed += (double) burst.samples.size() / M::SAMPLE_RATE;
+            const size_t last = std::min(slices, (burst.start + burst.samples.size() + sliceSamples - 1) / sliceSamples);
+            for(size_t s = burst.start / sliceSamples; s < last; s++) {
+                sliceBursts[s].push_back(&burst);
+            }
+        }
+    }
+
+    std::vector<int16_t> out(frames * options.channels);
+    std::atomic<size_t> nextSlice(0);
+    pool.clear();
+    for(int t = 0; t < options.threads; t++) {
+        pool.emplace_back([&]() {
+            for(size_t s; (s = nextSlice++) < slices;) {
+                mixSlice(out, s, sliceSamples, sliceBursts[s], options);
+            }
+        });
+    }
+    for(std::thread& thread : pool) thread.join();
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - began).count();
+
+    if(!wav_write(path, out.data(), out.size(), M::SAMPLE_RATE, options.channels)) {
+        fprintf(stderr, "aprs_traffic: could not write %s\n", path);
+        return false;
+    }
+    int collided = 0;
+    for(const Truth& truth : truths) {
+        const double at = truth.end;
+        printf("%02d:%02d:%05.2f %02d:%02d:%05.2f ch%d %c ", (int) truth.start / 3600, (int) truth.start / 60 % 60,
+               fmod(truth.start, 60), (int) at / 3600, (int) at / 60 % 60, fmod(at, 60), truth.channel,
+               truth.collided ? '*' : ' ');
+        monitor_print(stdout, truth.frame.data(), truth.frame.size());
+        collided += truth.collided;
+    }
+    fprintf(stderr, "%u frames from %d stations, offered load %.2f, %d overlapping; %.0f s of audio in %.2f s on %d "
+            "threads (%.0fx real time)\n", (unsigned) truths.size(), options.stations,
+            keyed / options.seconds / options.channels, collided, options.seconds, elapsed, options.threads,
+            options.seconds / elapsed);
+    return true;
+}
+
+static void usage() {
+    fprintf(stderr, "usage: aprs_traffic [options] <output.wav>\n"
+                    "  -n  stations, default 200\n"
+                    "  -d  seconds of audio, default 3600\n"
+                    "  -l  offered load per channel (0.3 = keyed 30%% of the time), sets the collision density\n"
+                    "  -c  channels: stations are spread over a multi-channel WAV instead of summed, default 1\n"
+                    "  -s  SNR in dB of a full level station, default 30; -1 for no noise\n"
+                    "  -m  afsk1200|afsk300|g3ruh9600, default afsk1200\n"
+                    "  -r  random seed, default 1\n"
+                    "  -j  threads, default one per core\n"
+                    "The ground-truth frame list goes to stdout.\n");
+}
+
+int main(int argc, char** argv) {
+    Options options = {200, 3600, 0.3, 1, 30, 1, (int) std::thread::hardware_concurrency()};
+    const char* mode = "afsk1200";
+    int arg = 1;
+    for(; arg + 1 < argc && argv[arg][0] == '-'; arg += 2) {
+        const char* value = argv[arg + 1];
+        if(strcmp(argv[arg], "-n") == 0) {
+            options.stations = atoi(value);
+        } else if(strcmp(argv[arg], "-d") == 0) {
+            options.seconds = atof(value);
+        } else if(strcmp(argv[arg], "-l") == 0) {
+            options.load = atof(value);
+        } else if(strcmp(argv[arg], "-c") == 0) {
+            options.channels = atoi(value);
+        } else if(strcmp(argv[arg], "-s") == 0) {
+            options.snr = atof(value);
+        } else if(strcmp(argv[arg], "-m") == 0) {
+            mode = value;
+        } else if(strcmp(argv[arg], "-r") == 0) {
+            options.seed = strtoul(value, 0, 10);
+        } else if(strcmp(argv[arg], "-j") == 0) {
+            options.threads = atoi(value);
+        } else {
+            break;
+        }
+    }
+    if(arg + 1 != argc || options.stations < 1 || options.seconds <= 0 || options.load <= 0 || options.channels < 1 ||
+       options.channels > 16 || options.threads < 1) {
+        usage();
+        return 2;
+    }
+    bool ok;
+    if(strcmp(mode, "afsk1200") == 0) {
+        ok = generate<AFSK1200>(options, argv[arg]);
+    } else if(strcmp(mode, "afsk300") == 0) {
+        ok = generate<AFSK300>(options, argv[arg]);
+    } else if(strcmp(mode, "g3ruh9600") == 0) {
+        ok = generate<G3RUH9600>(options, argv[arg]);
+    } else {
+        usage();
+        return 2;
+    }
+    return ok ? 0 : 1;
+}
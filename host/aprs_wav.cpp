@@ -0,0 +1,169 @@
+//Renders APRS packets through the library's modulator and writes the DAC samples to a WAV (or raw PCM) file.
+//Each comment argument becomes one position report; they are queued together and go out under one key-up.
+//radioISR() is driven by the simulated IntervalTimer clock of the host shim, one DAC write per tick.
+//With -m the frames are instead rendered straight through the chosen modem template, so every mode in modem.h
+//can be listened to from one build whatever APRS_MODEM the library was compiled for.
+//Raw output (-r) is never collected first: samples go straight into a PCMStreamSink as they are produced, from
+//the DAC hook, from -m, or from radioISR itself when the library is built with DEFS=-DAFSK_SINK=AFSK_SINK_PCM.
+#include "afsk.h"
+#include "aprs.h"
+#include "wav.h"
+#include <vector>
+
+static std::vector<int16_t> samples;
+static std::vector<TxFrame> frames;
+typedef PCMStreamSink<SINE_WAVE_RESOLUTION> StreamSink;
+
+//Map the unsigned DAC code (SINE_WAVE_RESOLUTION bits) to signed 16-bit PCM
+static void captureSample(int value) {
+    const int midScale = 1 << (SINE_WAVE_RESOLUTION - 1);
+    int pcm = (value - midScale) << (16 - SINE_WAVE_RESOLUTION);
+    if(pcm > INT16_MAX) pcm = INT16_MAX;
+    if(pcm < INT16_MIN) pcm = INT16_MIN;
+    samples.push_back((int16_t) pcm);
+}
+
+static bool streaming = false; //raw output: DAC samples go to StreamSink rather than into samples
+static size_t streamed = 0;
+
+static void captureDAC(uint8_t pin, int value) {
+    if(pin != MIC_PIN) {
+        return;
+    }
+    if(streaming) {
+        StreamSink::write(value);
+        streamed++;
+    } else {
+        captureSample(value);
+    }
+}
+
+//Collects samples for the WAV writer
+struct CaptureSink {
+    static void begin() {}
+    static inline void write(uint16_t sample) {
+        captureSample(sample);
+    }
+    static void idle() {}
+};
+
+//TXDELAY flags and then every captured frame through one modem instance into a sink, returning its sample rate
+template <class M, class S>
+static uint32_t render(size_t* count) {
+    static const uint8_t flag = HDLC_FLAG;
+    M modem;
+    modem.reset();
+    for(uint32_t i = 0; i < (uint32_t) PTT_DELAY * M::BIT_RATE / 8000; i++) {
+        modem.load(&flag, 8);
+        *count += sink_play<S>(modem);
+    }
+    for(size_t i = 0; i < frames.size(); i++) {
+        modem.load(frames[i].bits, frames[i].size);
+        *count += sink_play<S>(modem);
+    }
+    S::idle();
+    return M::SAMPLE_RATE;
+}
+
+template <class M>
+static uint32_t render(bool raw, size_t* count) {
+    return raw ? render<M, StreamSink>(count) : render<M, CaptureSink>(count);
+}
+
+static void usage() {
+    fprintf(stderr, "usage: aprs_wav [-r] [-m afsk1200|afsk300|g3ruh9600] <output.wav|output.raw|-> [comment...]\n"
+                    "  -r  write headerless 16-bit little-endian PCM instead of WAV (\"-\" for stdout)\n"
+                    "  -m  render with the given modem instead of running the library's radioISR\n");
+}
+
+int main(int argc, char** argv) {
+    bool raw = false;
+    const char* mode = 0;
+    int arg = 1;
+    for(; arg < argc && argv[arg][0] == '-' && argv[arg][1]; arg++) {
+        if(strcmp(argv[arg], "-r") == 0) {
+            raw = true;
+        } else if(strcmp(argv[arg], "-m") == 0 && arg + 1 < argc) {
+            mode = argv[++arg];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if(mode && strcmp(mode, "afsk1200") && strcmp(mode, "afsk300") && strcmp(mode, "g3ruh9600")) {
+        usage();
+        return 2;
+    }
+    if(arg >= argc) {
+        usage();
+        return 2;
+    }
+    const char* path = argv[arg++];
+#if AFSK_SINK == AFSK_SINK_PCM
+    if(!raw && !mode) {
+        fprintf(stderr, "aprs_wav: built with AFSK_SINK_PCM, radioISR can only write raw PCM (-r)\n");
+        return 2;
+    }
+#endif
+    const bool toStdout = strcmp(path, "-") == 0;
+    if(raw) {
+        StreamSink::stream = toStdout ? stdout : fopen(path, "wb");
+        if(!StreamSink::stream) {
+            fprintf(stderr, "aprs_wav: could not write %s\n", path);
+            return 1;
+        }
+        streaming = true;
+    }
+
+    SSID ssids[] = {
+        {(char*) "APRS", 0},
+        {(char*) "KM6HBK", 11},
+        {(char*) "WIDE2", 1}
+    };
+    host_set_serial_echo(false);
+    host_set_analog_write_hook(captureDAC);
+    DRA818V radio(PTT_PIN, AUDIO_PIN, MIC_PIN, DRATX, DRARX);
+    APRS aprs(&radio, ssids, sizeof(ssids) / sizeof(ssids[0]));
+    int bits = 0;
+    do {
+        const char* comment = arg < argc ? argv[arg] : "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+        if(!aprs.sendPacketGPS(16, 12, 30, 37.4275f, -122.1697f, 1234.5f, 90, 12.0f, comment)) {
+            host_run_timers(); //every slot is queued, let the transmitter drain them
+            aprs.sendPacketGPS(16, 12, 30, 37.4275f, -122.1697f, 1234.5f, 90, 12.0f, comment);
+        }
+        bits += aprs.getPacketSize();
+        if(mode) {
+            frames.push_back(*txQueue.front()); //keep the frame for render() instead of sending it
+            afsk_cancel();
+        }
+    } while(++arg < argc);
+
+    uint32_t rate = SAMPLE_RATE;
+    size_t count = 0;
+    if(!mode) {
+        host_run_timers();
+        count = raw ? streamed : samples.size(); //streamed stays 0 when radioISR wrote to the sink itself
+    } else if(strcmp(mode, "afsk1200") == 0) {
+        rate = render<AFSK1200>(raw, &count);
+    } else if(strcmp(mode, "afsk300") == 0) {
+        rate = render<AFSK300>(raw, &count);
+    } else {
+        rate = render<G3RUH9600>(raw, &count);
+    }
+
+    bool ok;
+    if(!raw) {
+        ok = wav_write(path, samples.data(), samples.size(), rate);
+    } else {
+        ok = fflush(StreamSink::stream) == 0 && ferror(StreamSink::stream) == 0;
+        if(!toStdout) {
+            ok = fclose(StreamSink::stream) == 0 && ok;
+        }
+    }
+    if(!ok) {
+        fprintf(stderr, "aprs_wav: could not write %s\n", path);
+        return 1;
+    }
+    fprintf(stderr, "%d frame bits, %u samples at %u Hz\n", bits, (unsigned) count, (unsigned) rate);
+    return 0;
+}
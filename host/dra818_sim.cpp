@@ -0,0 +1,99 @@
+#include "dra818_sim.h"
+#include "Arduino.h"
+
+static const uint32_t BYTE_US = 1042; //10 bits at 9600 baud
+
+DRA818Sim::DRA818Sim() : connected(false), txHz(0), rxHz(0), squelch(-1), tunedAt(0), replyDelayUs(20000), drop(0),
+                         refuse(0) {}
+
+void DRA818Sim::receive(uint8_t b) {
+    if(b == '\n') {
+        if(!line.empty() && line.back() == '\r') line.pop_back();
+        commands.push_back(line);
+        command(line, micros() + (line.size() + 2) * BYTE_US); //the shim delivers at once, the UART would not
+        line.clear();
+    } else {
+        line += (char) b;
+    }
+}
+
+int DRA818Sim::available() {
+    int count = 0;
+    for(size_t i = 0; i < output.size() && output[i].first <= micros(); i++) count++;
+    return count;
+}
+
+int DRA818Sim::read() {
+    if(output.empty() || output.front().first > micros()) {
+        return -1;
+    }
+    const char c = output.front().second;
+    output.pop_front();
+    return (uint8_t) c;
+}
+
+void DRA818Sim::sendNoise(const std::string& text) {
+    const uint32_t now = micros();
+    for(char c : text) output.push_back(std::make_pair(now, c));
+}
+
+//Parses "MMM.FFFF" into Hz, 0 if malformed
+static uint32_t parseMHz(const std::string& text) {
+    unsigned mhz, fraction;
+    char tail;
+    if(text.size() != 8 || text[3] != '.' || sscanf(text.c_str(), "%3u.%4u%c", &mhz, &fraction, &tail) != 2) {
+        return 0;
+    }
+    return mhz * 1000000 + fraction * 100;
+}
+
+static bool validFrequency(uint32_t hz) {
+    return (hz >= 134000000 && hz <= 174000000) || (hz >= 400000000 && hz <= 470000000);
+}
+
+void DRA818Sim::command(const std::string& text, uint32_t now) {
+    std::string reply;
+    bool ok = true;
+    if(text == "AT+DMOCONNECT") {
+        reply = "+DMOCONNECT:";
+        connected = true;
+    } else if(text.compare(0, 15, "AT+DMOSETGROUP=") == 0) {
+        reply = "+DMOSETGROUP:";
+        std::vector<std::string> fields;
+        size_t start = 15;
+        for(size_t comma; (comma = text.find(',', start)) != std::string::npos; start = comma + 1) {
+            fields.push_back(text.substr(start, comma - start));
+        }
+        fields.push_back(text.substr(start));
+        ok = fields.size() == 6 && (fields[0] == "0" || fields[0] == "1") && fields[4].size() == 1 &&
+             fields[4][0] >= '0' && fields[4][0] <= '8' && validFrequency(parseMHz(fields[1])) &&
+             validFrequency(parseMHz(fields[2])) && fields[3].size() == 4 && fields[5].size() == 4;
+        if(ok && !refuse && !drop) {
+            txHz = parseMHz(fields[1]);
+            rxHz = parseMHz(fields[2]);
+            squelch = fields[4][0] - '0';
+            tunedAt = now + replyDelayUs;
+        }
+    } else if(text.compare(0, 16, "AT+DMOSETVOLUME=") == 0) {
+        reply = "+DMOSETVOLUME:";
+    } else if(text.compare(0, 13, "AT+SETFILTER=") == 0) {
+        reply = "+DMOSETFILTER:";
+    } else {
+        return; //the module says nothing to what it does not understand
+    }
+    if(drop > 0) {
+        drop--;
+        return;
+    }
+    if(refuse > 0) {
+        refuse--;
+        ok = false;
+    }
+    reply += ok ? "0\r\n" : "1\r\n";
+    uint32_t at = now + replyDelayUs;
+    if(!output.empty() && output.back().first > at) at = output.back().first;
+    for(char c : reply) {
+        at += BYTE_US;
+        output.push_back(std::make_pair(at, c));
+    }
+}
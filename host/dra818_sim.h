@@ -0,0 +1,41 @@
+#ifndef DRA818_SIM_H
+#define DRA818_SIM_H
+//Simulated DRA818V for the host tools, on the far end of the SoftwareSerial shim (host_set_serial_peer).
+//A command takes effect replyDelay ms (simulated clock) after its last byte would have crossed the 9600 baud
+//line, then the reply comes out one byte per character time, so a poll() loop sees it in pieces like on the
+//real UART.
+#include "SoftwareSerial.h"
+#include <stdint.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+class DRA818Sim : public HostSerialPeer
+{
+public:
+    DRA818Sim();
+    void receive(uint8_t b);
+    int available();
+    int read();
+
+    void setReplyDelay(uint32_t ms) { replyDelayUs = ms * 1000; }
+    void dropReplies(int count) { drop = count; } //the next count commands get no answer
+    void refuseCommands(int count) { refuse = count; } //the next count commands are answered with :1
+    void sendNoise(const std::string& text); //unsolicited bytes, available at once
+
+    std::vector<std::string> commands; //every command line received, without \r\n
+    bool connected;
+    uint32_t txHz; //last accepted DMOSETGROUP
+    uint32_t rxHz;
+    int squelch;
+    uint32_t tunedAt; //micros() the last accepted DMOSETGROUP took effect
+private:
+    void command(const std::string& text, uint32_t now);
+    std::string line;
+    std::deque<std::pair<uint32_t, char> > output; //reply bytes and the micros() they are sent at
+    uint32_t replyDelayUs;
+    int drop;
+    int refuse;
+};
+
+#endif // DRA818_SIM_H
@@ -0,0 +1,57 @@
+//Generated by make_vectors.py from a bit-by-bit encoder written from the AX.25 2.2 spec. Do not edit.
+#ifndef GOLDEN_VECTORS_H
+#define GOLDEN_VECTORS_H
+
+struct GoldenVector {
+    const char* name;
+    const char* path; //callsign-ssid, comma separated, destination first
+    const char* info;
+    int infoLength;
+    unsigned short fcs;
+    int bits; //on air, leading flags to closing flag
+    const char* nrzi; //line levels, packed most significant bit first, 1 = mark
+};
+
+static const GoldenVector GOLDEN_VECTORS[] = {
+    {"empty information field", "APRS-0,N0CALL-0",
+     "", 0, 0xA2A3, 169,
+     "\x01\x01\x2b\x53\x6c\xec\xa9\x56\xae\x84\xae\xeb\x2b\x44\xbb\xae\x2a\xa0\x69\x96\x7f\x00"},
+    {"status", "APRS-0,KM6HBK-11,WIDE2-1",
+     "\x3e\x46\x6c\x6f\x61\x74\x20\x61\x6c\x74\x69\x74\x75\x64\x65\x20\x72\x65\x61\x63\x68\x65\x64", 23, 0x98A8, 409,
+     "\x01\x01\x2b\x53\x6c\xec\xa9\x56\xae\xe4\xc4\x8e\xa4\x94\xe4\xe1\x0c\xdb\x4b\x34\x91\x56\x2e\x2a\xa0\xfd\x74\xb8\xf8\xd7\x4f\x56\xd7\x47\x4f\x27\x4f\x30\xb7\x37\x56\x90\xc8\xd7\x17\x58\xc8\xb7\x59\xa2\x7f\x00"},
+    {"position", "APRS-0,KM6HBK-11,WIDE2-1",
+     "\x2f\x31\x36\x31\x32\x33\x30\x7a\x33\x37\x32\x35\x2e\x36\x35\x4e\x2f\x31\x32\x32\x31\x30\x2e\x31\x38\x57\x4f\x30\x39\x30\x2f\x30\x31\x32\x2f\x41\x3d\x30\x30\x34\x30\x35\x30\x62\x61\x6c\x6c\x6f\x6f\x6e", 50, 0x4E77, 625,
+     "\x01\x01\x2b\x53\x6c\xec\xa9\x56\xae\xe4\xc4\x8e\xa4\x94\xe4\xe1\x0c\xdb\x4b\x34\x91\x56\x2e\x2a\xa0\x79\x2e\x8e\xd1\x6e\xee\xae\x9f\x11\x0e\x91\x31\x79\x71\x31\x7b\x06\xd1\x6e\x91\x2e\xae\x86\xd1\x5e\xf3\x04\xae\xde\xae\xf9\x51\x2e\x91\x06\xd4\xc1\x51\x51\x4e\xae\xce\xae\x97\x28\xb8\xb8\xf8\xf8\x87\x0f\x7b\x7f\x00"},
+    {"compressed position", "APRS-0,KM6HBK-11,WIDE2-1",
+     "\x2f\x31\x36\x31\x32\x33\x30\x7a\x2f\x35\x4c\x21\x21\x3c\x2a\x65\x37\x4f\x37\x50\x5b\x2f\x41\x3d\x30\x30\x34\x30\x34\x39", 30, 0x31C0, 465,
+     "\x01\x01\x2b\x53\x6c\xec\xa9\x56\xae\xe4\xc4\x8e\xa4\x94\xe4\xe1\x0c\xdb\x4b\x34\x91\x56\x2e\x2a\xa0\x79\x2e\x8e\xd1\x6e\xee\xae\x9f\x06\xce\xbb\x29\x29\x41\x66\xc8\xf1\x04\xf1\x53\x1c\xf9\x2b\x3e\xae\xae\xb1\x51\x4e\xde\xab\xd1\x7f\x00"},
+    {"telemetry", "APZSSI-0,KM6HBK-15,WIDE1-1,WIDE2-2",
+     "\x54\x23\x30\x30\x35\x2c\x31\x39\x39\x2c\x30\x30\x30\x2c\x32\x35\x35\x2c\x30\x37\x33\x2c\x31\x32\x33\x2c\x30\x31\x31\x30\x31\x30\x30\x31", 34, 0xE74F, 553,
+     "\x01\x01\x2b\x53\x63\x13\x13\x24\xae\xe4\xc4\x8e\xa4\x94\xe4\xfc\x86\x6d\xa5\x9a\x68\xab\x68\x86\x6d\xa5\x9a\x48\xab\x37\x15\x50\x4c\xe9\x51\x51\x31\x46\xd1\x21\x21\x46\xae\xae\xae\xb9\x6e\xce\xce\xb9\x51\x0e\xee\xb9\x2e\x91\x11\x46\xae\xd1\x2e\xae\xd1\x51\x51\x2e\xfb\x08\x7f\x00"},
+    {"all ones", "APRS-0,KM6HBK-11,WIDE2-1",
+     "\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff", 40, 0xF736, 608,
+     "\x01\x01\x2b\x53\x6c\xec\xa9\x56\xae\xe4\xc4\x8e\xa4\x94\xe4\xe1\x0c\xdb\x4b\x34\x91\x56\x2e\x2a\xa0\x7e\x07\xe0\x7e\x07\xe0\x7e\x07\xe0\x7e\x07\xe0\x7e\x07\xe0\x7e\x07\xe0\x7e\x07\xe0\x7e\x07\xe0\x7e\x07\xe0\x7e\x07\xe0\x7e\x07\xe0\x7e\x07\xe0\x7e\x07\xe0\x7e\x07\xe0\x7e\x07\xe0\x7e\x07\xe0\xe2\x1f\x01"},
+    {"flag bytes", "APRS-0,KM6HBK-11,WIDE2-1",
+     "\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e\x7e", 40, 0xA1EE, 584,
+     "\x01\x01\x2b\x53\x6c\xec\xa9\x56\xae\xe4\xc4\x8e\xa4\x94\xe4\xe1\x0c\xdb\x4b\x34\x91\x56\x2e\x2a\xa0\xfc\x81\xbf\x20\x6f\xc8\x1b\xf2\x06\xfc\x81\xbf\x20\x6f\xc8\x1b\xf2\x06\xfc\x81\xbf\x20\x6f\xc8\x1b\xf2\x06\xfc\x81\xbf\x20\x6f\xc8\x1b\xf2\x06\xfc\x81\xbf\x20\x6f\xc8\x1b\xf2\x06\xf0\x53\x01"},
+    {"runs across bytes", "APRS-0,KM6HBK-11,WIDE2-1",
+     "\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f\xf8\x1f", 60, 0xC9CD, 764,
+     "\x01\x01\x2b\x53\x6c\xec\xa9\x56\xae\xe4\xc4\x8e\xa4\x94\xe4\xe1\x0c\xdb\x4b\x34\x91\x56\x2e\x2a\xa0\xbf\x02\xaf\xc0\xab\xf0\x2a\xfc\x0a\xbf\x02\xaf\xc0\xab\xf0\x2a\xfc\x0a\xbf\x02\xaf\xc0\xab\xf0\x2a\xfc\x0a\xbf\x02\xaf\xc0\xab\xf0\x2a\xfc\x0a\xbf\x02\xaf\xc0\xab\xf0\x2a\xfc\x0a\xbf\x02\xaf\xc0\xab\xf0\x2a\xfc\x0a\xbf\x02\xaf\xc0\xab\xf0\x2a\xfc\x0a\xbf\x02\xaf\xc0\xa7\x7b\x70\x10"},
+    {"six callsign characters", "APRS00-15,ABCDEF-15,ZZZZZZ-15",
+     "\x21", 1, 0x45EE, 236,
+     "\x01\x01\x2b\x53\x6c\xec\xae\xae\xfc\x95\xb5\x8a\x5a\x65\xba\x7e\x58\xd8\xd8\xd8\xd8\xd8\xfc\x3a\xab\xf5\x2f\x06\x90\x10"},
+    {"eight digipeaters", "APRS-0,KM6HBK-11,WIDE1-0,WIDE2-1,WIDE3-2,WIDE4-3,WIDE5-4,WIDE6-5,WIDE7-6,WIDE1-7",
+     "\x3e\x66\x75\x6c\x6c\x20\x70\x61\x74\x68", 10, 0x2BFF, 699,
+     "\x01\x01\x2b\x53\x6c\xec\xa9\x56\xae\xe4\xc4\x8e\xa4\x94\xe4\xe1\x0c\xdb\x4b\x34\xd1\x56\xae\xf3\x24\xb4\xcb\x6e\xa9\x2e\xf3\x24\xb4\xcb\x11\x56\x91\x0c\xdb\x4b\x34\xb1\x56\xee\xf3\x24\xb4\xcb\x31\x56\xb1\x0c\xdb\x4b\x34\x8e\xa9\x31\x0c\xdb\x4b\x34\xf1\x56\x8e\xf3\x24\xb4\xcb\x2e\xa9\xf1\xd5\x5f\x02\x88\xcf\x47\x47\x56\xaf\x28\xb0\xa7\x03\xf6\x5f\xc0"},
+    {"every byte value", "APRS-0,KM6HBK-11,WIDE2-1",
+     "\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f\x10\x11\x12\x13\x14\x15\x16\x17\x18\x19\x1a\x1b\x1c\x1d\x1e\x1f\x20\x21\x22\x23\x24\x25\x26\x27\x28\x29\x2a\x2b\x2c\x2d\x2e\x2f\x30\x31\x32\x33\x34\x35\x36\x37\x38\x39\x3a\x3b\x3c\x3d\x3e\x3f\x40\x41\x42\x43\x44\x45\x46\x47\x48\x49\x4a\x4b\x4c\x4d\x4e\x4f\x50\x51\x52\x53\x54\x55\x56\x57\x58\x59\x5a\x5b\x5c\x5d\x5e\x5f\x60\x61\x62\x63\x64\x65\x66\x67\x68\x69\x6a\x6b\x6c\x6d\x6e\x6f\x70\x71\x72\x73\x74\x75\x76\x77\x78\x79\x7a\x7b\x7c\x7d\x7e\x7f\x80\x81\x82\x83\x84\x85\x86\x87\x88\x89\x8a\x8b\x8c\x8d\x8e\x8f\x90\x91\x92\x93\x94\x95\x96\x97\x98\x99\x9a\x9b\x9c\x9d\x9e\x9f\xa0\xa1\xa2\xa3\xa4\xa5\xa6\xa7\xa8\xa9\xaa\xab\xac\xad\xae\xaf\xb0\xb1\xb2\xb3\xb4\xb5\xb6\xb7\xb8\xb9\xba\xbb\xbc\xbd\xbe\xbf\xc0\xc1\xc2\xc3\xc4\xc5\xc6\xc7\xc8", 200, 0x6A5C, 1839,
+     "\x01\x01\x2b\x53\x6c\xec\xa9\x56\xae\xe4\xc4\x8e\xa4\x94\xe4\xe1\x0c\xdb\x4b\x34\x91\x56\x2e\x2a\xa0\x55\x6a\xea\xb5\x35\x75\x0a\xa5\x25\x65\x1a\xba\xc5\x7a\xfa\xad\x2d\x6d\x12\xb2\xcd\x72\xf2\xa2\xdd\x62\xe2\xbd\x3d\x7d\x02\xab\x6b\x4b\x74\xa4\x9b\x44\x84\xac\x93\x4c\x8c\xa3\x63\x43\x7c\xa8\x97\x48\x88\xa7\x67\x47\x78\xaf\x6f\x4f\x70\xa0\x9f\x40\xbf\x2a\x9a\x92\x9d\x69\x66\x91\x61\x6b\x64\x93\x63\x68\x98\x90\x9f\x6a\x65\x92\x62\x69\x99\x91\x9e\x6b\x9b\x93\x9c\x68\x67\x90\x60\x4a\x8d\x76\x8e\x8b\x73\x77\x70\x8a\x72\x76\x71\x8b\x8c\x77\x8f\x8a\xf2\xf6\xf1\x0b\x0c\xf7\x0f\x0a\x0d\xf6\x0e\x0b\xf6\x05\xf9\xf8\xaa\x2a\x6a\x15\xb5\xca\x75\xf5\xa5\xda\x65\xe5\xba\x3a\x7a\x05\x29\x16\xc9\x09\x26\xe6\xc6\xf9\x2e\xee\xce\xf1\x21\x1e\xc1\x03\x6a\x75\x9a\x7a\x6d\x8d\x9d\x82\x69\x89\x99\x86\x6e\x71\x9e\x7e\xca\x3a\x32\x3d\xc9\xc6\x31\xc1\xcb\xc4\x33\xc3\xc8\x38\x30\x20\x72\xa1\x5c\xa0\xa2\x5e\x5c\x5f\xae\x91\x0d\x9d\xfc"},
+    {"pseudo-random binary", "APRS-0,KM6HBK-11,WIDE2-1",
+     "\xac\x56\xb5\xcc\xf4\x2f\xee\xc9\x1d\x6f\x21\xc1\x80\xc7\x33\x84\xf1\xa3\x67\xfb\x0d\x18\x74\xde\x7c\x24\x45\xc8\x39\x58\x38\x37\x8c\xb8\x95\x9a\x5b\x98\xa2\x8b\x20\x97\x7f\xbf\x79\x12\xbc\x64\x40\xb7\x52\xf4\x89\xf2\x64\xa2\x0d\x8f\x09\xf7\xce\x91\xeb\x44\xfc\x48\x8a\xfc\x75\x16\x6e\x19\x4a\x59\x8e\x1f\x55\x91\xce\x65\x91\x97\x38\xb8\xe6\x86\x6a\x73\x99\xb7\x60\xae\x6c\xdf\x7c\x1b\x57\x3b\x8d\xb0\x40\x56\x2b\x34\x19\xd2\x9f\x5b\x62\x4b\x4c\xf4\xe4\x29\x28\x61\x29\x0f\xd7\x4f\x02\x29\x73\x87\x28\x96\x04\x28\xbd\xa5\x42\xab\x45\xa3\x1f\x96\x51\x7e\x33\xac\xfd\x61\x08\x01\x03\x2f\xdc\x44\xde\x63", 150, 0xAC0C, 1441,
+     "\x01\x01\x2b\x53\x6c\xec\xa9\x56\xae\xe4\xc4\x8e\xa4\x94\xe4\xe1\x0c\xdb\x4b\x34\x91\x56\x2e\x2a\xa0\x8c\xe6\x63\x77\x60\x79\x78\x24\x3d\x07\x29\x2b\xaa\x0b\xee\xb5\xd0\x34\xfb\x8f\xce\xa8\xac\x20\xef\xd6\xd9\x6b\x7b\xd4\x6b\xde\x28\xb4\x39\xb3\xbc\x6b\xb2\xc3\x4a\xde\x40\xf0\x31\x04\x95\xf2\x45\x58\x73\x65\x81\x69\xbe\xdd\xa7\x14\x17\x6b\xc1\xef\x48\x61\x2d\x03\x49\x34\x81\xcf\x72\x87\x22\x9b\x23\x7a\x06\x99\x96\xc2\x1b\x96\xf9\x2f\x50\xc4\x3a\xcc\x77\x91\x07\x2b\xbc\xdc\x7e\xef\xdc\x5e\x63\xd8\xb5\xca\x91\x9c\xd6\x24\x52\x7e\x21\xc9\x71\xb4\x4b\x04\x82\x6a\x6d\x72\x6f\xaf\x3f\x24\xa9\x37\x78\x52\xcb\x92\x55\x36\x0e\x4c\xa7\x31\xa7\x4f\xca\x37\x4d\xf9\xdd\x73\x81\xd7\x5a\xd5\x15\x06\xbc\x4b\x7c\x17\x45\x46\x7f\x00"},
+    {"longest comment that fits a slot", "APRS-0,KM6HBK-11,WIDE2-1",
+     "\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41\x41", 224, 0xD8C7, 2017,
+     "\x01\x01\x2b\x53\x6c\xec\xa9\x56\xae\xe4\xc4\x8e\xa4\x94\xe4\xe1\x0c\xdb\x4b\x34\x91\x56\x2e\x2a\xa0\x54\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xd4\xf4\x5c\x7f\x00"},
+};
+
+#endif // GOLDEN_VECTORS_H
@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+"""Writes golden_vectors.h: AX.25 UI frames encoded bit by bit from the spec, independently of the library.
+
+Each vector is the path and information field a frame is built from, the FCS, and the on-air bitstream: two
+leading flags, the stuffed frame, a closing flag, NRZI coded from an idle mark level (a 0 changes the level).
+Run it from host/golden/ after changing the corpus; the output is checked in.
+"""
+
+FLAG = 0x7E
+LEADING_FLAGS = 2  # N_HDLC_FLAGS
+
+
+def crc_x25(data):
+    crc = 0xFFFF
+    for byte in data:
+        for i in range(8):
+            bit = (byte >> i) & 1
+            crc = (crc >> 1) ^ 0x8408 if (crc ^ bit) & 1 else crc >> 1
+    return crc ^ 0xFFFF
+
+
+def address_field(path):
+    out = []
+    for n, (call, ssid) in enumerate(path):
+        out += [ord(c) << 1 for c in call.ljust(6)]
+        out.append(((ord('0') + ssid) << 1) | (1 if n == len(path) - 1 else 0))
+    return out
+
+
+def frame_bits(path, info):
+    body = address_field(path) + [0x03, 0xF0] + list(info)
+    fcs = crc_x25(body)
+    bits = []
+    for _ in range(LEADING_FLAGS):
+        bits += [(FLAG >> i) & 1 for i in range(8)]
+    ones = 0
+    for byte in body + [fcs & 0xFF, fcs >> 8]:
+        for i in range(8):
+            bit = (byte >> i) & 1
+            bits.append(bit)
+            ones = ones + 1 if bit else 0
+            if ones == 5:
+                bits.append(0)
+                ones = 0
+    bits += [(FLAG >> i) & 1 for i in range(8)]
+    return bits, fcs
+
+
+def nrzi(bits):
+    level = 1
+    out = []
+    for bit in bits:
+        if not bit:
+            level ^= 1
+        out.append(level)
+    return out
+
+
+def pack(bits):
+    out = bytearray((len(bits) + 7) // 8)
+    for i, bit in enumerate(bits):
+        if bit:
+            out[i // 8] |= 0x80 >> (i % 8)
+    return bytes(out)
+
+
+def c_string(data):
+    return '"' + ''.join('\\x%02x' % b for b in data) + '"'
+
+
+def lcg(seed):
+    while True:
+        seed = (seed * 1103515245 + 12345) & 0xFFFFFFFF
+        yield seed >> 16
+
+
+STANDARD = [("APRS", 0), ("KM6HBK", 11), ("WIDE2", 1)]
+rand = lcg(2017)
+CORPUS = [
+    ("empty information field", [("APRS", 0), ("N0CALL", 0)], b""),
+    ("status", STANDARD, b">Float altitude reached"),
+    ("position", STANDARD, b"/161230z3725.65N/12210.18WO090/012/A=004050balloon"),
+    ("compressed position", STANDARD, b"/161230z/5L!!<*e7O7P[/A=004049"),
+    ("telemetry", [("APZSSI", 0), ("KM6HBK", 15), ("WIDE1", 1), ("WIDE2", 2)], b"T#005,199,000,255,073,123,01101001"),
+    ("all ones", STANDARD, b"\xff" * 40),
+    ("flag bytes", STANDARD, b"\x7e" * 40),
+    ("runs across bytes", STANDARD, b"\xf8\x1f" * 30),
+    ("six callsign characters", [("APRS00", 15), ("ABCDEF", 15), ("ZZZZZZ", 15)], b"!"),
+    ("eight digipeaters", [("APRS", 0), ("KM6HBK", 11)] + [("WIDE%d" % (i % 7 + 1), i % 8) for i in range(8)], b">full path"),
+    ("every byte value", STANDARD, bytes(range(1, 201))),
+    ("pseudo-random binary", STANDARD, bytes(next(rand) % 255 + 1 for _ in range(150))),
+    ("longest comment that fits a slot", STANDARD, b"A" * 224),
+]
+
+
+def main():
+    lines = [
+        "//Generated by make_vectors.py from a bit-by-bit encoder written from the AX.25 2.2 spec. Do not edit.",
+        "#ifndef GOLDEN_VECTORS_H",
+        "#define GOLDEN_VECTORS_H",
+        "",
+        "struct GoldenVector {",
+        "    const char* name;",
+        "    const char* path; //callsign-ssid, comma separated, destination first",
+        "    const char* info;",
+        "    int infoLength;",
+        "    unsigned short fcs;",
+        "    int bits; //on air, leading flags to closing flag",
+        "    const char* nrzi; //line levels, packed most significant bit first, 1 = mark",
+        "};",
+        "",
+        "static const GoldenVector GOLDEN_VECTORS[] = {",
+    ]
+    for name, path, info in CORPUS:
+        bits, fcs = frame_bits(path, info)
+        lines.append('    {"%s", "%s",' % (name, ",".join("%s-%d" % p for p in path)))
+        lines.append("     %s, %d, 0x%04X, %d," % (c_string(info), len(info), fcs, len(bits)))
+        lines.append("     %s}," % c_string(pack(nrzi(bits))))
+    lines += ["};", "", "#endif // GOLDEN_VECTORS_H", ""]
+    with open("golden_vectors.h", "w") as out:
+        out.write("\n".join(lines))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,38 @@
+#include "monitor.h"
+#include "ax25.h"
+
+static void printAddress(FILE* out, AX25Address address) {
+    char callsign[AX25_CALLSIGN_LENGTH + 1];
+    address.callsign(callsign);
+    fputs(callsign, out);
+    if(address.ssid()) {
+        fprintf(out, "-%d", address.ssid());
+    }
+}
+
+void monitor_print(FILE* out, const uint8_t* frame, int length) {
+    AX25Frame view;
+    if(!view.parse(frame, length)) {
+        return;
+    }
+    printAddress(out, view.source());
+    fputc('>', out);
+    printAddress(out, view.destination());
+    for(int i = 0; i < view.digipeaters(); i++) {
+        fputc(',', out);
+        printAddress(out, view.digipeater(i));
+        if(view.digipeater(i).repeated()) {
+            fputc('*', out);
+        }
+    }
+    fputc(':', out);
+    const AX25Span info = view.info();
+    for(int i = 0; i < info.length; i++) {
+        if(info.data[i] >= ' ' && info.data[i] < 0x7F) {
+            fputc(info.data[i], out);
+        } else {
+            fprintf(out, "<0x%02x>", info.data[i]);
+        }
+    }
+    fputc('\n', out);
+}
@@ -0,0 +1,11 @@
+#ifndef MONITOR_H
+#define MONITOR_H
+//Text rendering of received AX.25 frames shared by the host decoders
+#include <stdint.h>
+#include <stdio.h>
+
+//Prints SOURCE>DEST,PATH:info and a newline, with repeated path entries starred and unprintable info bytes
+//escaped as <0xNN>. Anything AX25Frame::parse rejects (not a UI frame) prints nothing.
+void monitor_print(FILE* out, const uint8_t* frame, int length);
+
+#endif // MONITOR_H
@@ -0,0 +1,143 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+//Host (Linux) stand-in for the Teensyduino core. Only the pieces used by the library are provided.
+//Pins are inert, delay()/millis() run on a simulated clock and IntervalTimer callbacks are only fired
+//when a host driver calls host_timer_step()/host_run_timers(), so radioISR() runs as fast as the host can go.
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "binary.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+
+#define DEC 10
+#define HEX 16
+#define BIN 2
+
+//Teensy 3.2 analog pin numbers
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+#define A6 20
+#define A7 21
+#define A8 22
+#define A9 23
+#define A10 34
+#define A11 35
+#define A12 36
+#define A13 37
+#define A14 40
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+uint8_t digitalRead(uint8_t pin);
+void analogWrite(uint8_t pin, int val);
+void analogWriteResolution(unsigned int bits);
+void analogWriteFrequency(uint8_t pin, float frequency);
+void analogReadResolution(unsigned int bits);
+int analogRead(uint8_t pin);
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+uint32_t millis();
+uint32_t micros();
+long random(long howbig);
+long random(long howsmall, long howbig);
+void noInterrupts();
+static inline void interrupts() {}
+
+class String
+{
+public:
+    String(const char *cstr = "");
+    String(char c);
+    String(int value);
+    String(const String &other);
+    ~String();
+    String &operator=(const String &other);
+    String &operator+=(const String &other);
+    String &operator+=(char c);
+    friend String operator+(const String &lhs, const String &rhs);
+    friend String operator+(const String &lhs, char c);
+    bool operator==(const String &other) const;
+    bool operator!=(const String &other) const { return !(*this == other); }
+    char operator[](unsigned int index) const;
+    unsigned int length() const { return len; }
+    const char *c_str() const { return buffer; }
+private:
+    void assign(const char *cstr, unsigned int length);
+    char *buffer;
+    unsigned int len;
+};
+
+//Common base for Serial and SoftwareSerial. Bytes written go to write(), which each port overrides.
+class Stream
+{
+public:
+    virtual ~Stream() {}
+    virtual size_t write(uint8_t b) = 0;
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    size_t write(const char *str);
+    size_t print(const char *str) { return write(str); }
+    size_t print(const String &str) { return write(str.c_str()); }
+    size_t print(char c) { return write((uint8_t) c); }
+    size_t print(int n, int base = DEC) { return print((long) n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long) n, base); }
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(double n, int digits = 2);
+    template <typename T> size_t println(const T &value) { size_t n = print(value); return n + println(); }
+    template <typename T> size_t println(const T &value, int format) { size_t n = print(value, format); return n + println(); }
+    size_t println() { return write("\r\n"); }
+};
+
+class HardwareSerial : public Stream
+{
+public:
+    void begin(uint32_t baud) { (void) baud; }
+    size_t write(uint8_t b);
+    operator bool() const { return true; }
+    using Stream::write;
+};
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+class IntervalTimer
+{
+public:
+    IntervalTimer();
+    ~IntervalTimer();
+    bool begin(void (*funct)(), float microseconds);
+    void end();
+private:
+    friend bool host_timer_step();
+    void (*callback)();
+    double period;
+    double nextFire;
+    bool running;
+};
+
+//Host-only hooks used by the drivers in host/
+typedef void (*host_analog_write_hook)(uint8_t pin, int value);
+void host_set_analog_write_hook(host_analog_write_hook hook);
+typedef int (*host_analog_read_hook)(uint8_t pin);
+void host_set_analog_read_hook(host_analog_read_hook hook); //supplies analogRead() values, 0 without a hook
+typedef void (*host_interrupt_hook)();
+void host_set_interrupt_hook(host_interrupt_hook hook); //runs on noInterrupts(), as if an interrupt came in just before it
+void host_set_serial_echo(bool echo); //Serial output goes to stderr when enabled
+bool host_timer_step(); //fire the earliest due IntervalTimer and advance the clock to it; false if none is running
+void host_run_timers(); //step until every IntervalTimer has been ended
+
+#endif // ARDUINO_H
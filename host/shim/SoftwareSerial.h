@@ -0,0 +1,32 @@
+#ifndef SOFTWARESERIAL_H
+#define SOFTWARESERIAL_H
+//Host stand-in for SoftwareSerial. Without a peer, transmitted bytes are discarded and nothing is ever received;
+//host_set_serial_peer() puts a simulated device (e.g. host/dra818_sim.h) on the other end of every port.
+#include "Arduino.h"
+
+class HostSerialPeer
+{
+public:
+    virtual ~HostSerialPeer() {}
+    virtual void receive(uint8_t b) = 0; //a byte the library wrote
+    virtual int available() = 0; //bytes the device has sent by now (on the simulated clock)
+    virtual int read() = 0;
+};
+void host_set_serial_peer(HostSerialPeer* peer);
+HostSerialPeer* host_serial_peer();
+
+class SoftwareSerial : public Stream
+{
+public:
+    SoftwareSerial(uint8_t rxPin, uint8_t txPin) { (void) rxPin; (void) txPin; }
+    void begin(long speed) { (void) speed; }
+    size_t write(uint8_t b) {
+        if(host_serial_peer()) host_serial_peer()->receive(b);
+        return 1;
+    }
+    int available() { return host_serial_peer() ? host_serial_peer()->available() : 0; }
+    int read() { return host_serial_peer() ? host_serial_peer()->read() : -1; }
+    using Stream::write;
+};
+
+#endif // SOFTWARESERIAL_H
@@ -0,0 +1,250 @@
+#include "Arduino.h"
+#include "SoftwareSerial.h"
+
+HardwareSerial Serial;
+HardwareSerial Serial1;
+
+static double clockMicros = 0; //simulated time since start
+static host_analog_write_hook analogWriteHook = 0;
+static host_analog_read_hook analogReadHook = 0;
+static host_interrupt_hook interruptHook = 0;
+static bool serialEcho = true;
+static HostSerialPeer* serialPeer = 0;
+
+static const int MAX_TIMERS = 4; //Teensy 3.2 has four PIT channels
+static IntervalTimer* activeTimers[MAX_TIMERS] = {0};
+
+void pinMode(uint8_t pin, uint8_t mode) { (void) pin; (void) mode; }
+void digitalWrite(uint8_t pin, uint8_t val) { (void) pin; (void) val; }
+uint8_t digitalRead(uint8_t pin) { (void) pin; return LOW; }
+void analogWriteResolution(unsigned int bits) { (void) bits; }
+void analogWriteFrequency(uint8_t pin, float frequency) { (void) pin; (void) frequency; }
+void analogReadResolution(unsigned int bits) { (void) bits; }
+int analogRead(uint8_t pin) { return analogReadHook ? analogReadHook(pin) : 0; }
+
+void noInterrupts() {
+    if(interruptHook) {
+        interruptHook();
+    }
+}
+
+void analogWrite(uint8_t pin, int val) {
+    if(analogWriteHook) {
+        analogWriteHook(pin, val);
+    }
+}
+
+void delay(uint32_t ms) {
+    clockMicros += ms * 1000.0;
+}
+
+void delayMicroseconds(uint32_t us) {
+    clockMicros += us;
+}
+
+uint32_t millis() {
+    return (uint32_t) (clockMicros / 1000.0);
+}
+
+uint32_t micros() {
+    return (uint32_t) clockMicros;
+}
+
+long random(long howbig) {
+    if(howbig <= 0) return 0;
+    return rand() % howbig;
+}
+
+long random(long howsmall, long howbig) {
+    if(howsmall >= howbig) return howsmall;
+    return howsmall + random(howbig - howsmall);
+}
+
+void host_set_analog_write_hook(host_analog_write_hook hook) {
+    analogWriteHook = hook;
+}
+
+void host_set_analog_read_hook(host_analog_read_hook hook) {
+    analogReadHook = hook;
+}
+
+void host_set_interrupt_hook(host_interrupt_hook hook) {
+    interruptHook = hook;
+}
+
+void host_set_serial_echo(bool echo) {
+    serialEcho = echo;
+}
+
+void host_set_serial_peer(HostSerialPeer* peer) {
+    serialPeer = peer;
+}
+
+HostSerialPeer* host_serial_peer() {
+    return serialPeer;
+}
+
+IntervalTimer::IntervalTimer() : callback(0), period(0), nextFire(0), running(false) {}
+
+IntervalTimer::~IntervalTimer() {
+    end();
+}
+
+bool IntervalTimer::begin(void (*funct)(), float microseconds) {
+    end();
+    for(int i = 0; i < MAX_TIMERS; i++) {
+        if(!activeTimers[i]) {
+            activeTimers[i] = this;
+            callback = funct;
+            period = microseconds;
+            nextFire = clockMicros + microseconds;
+            running = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+void IntervalTimer::end() {
+    for(int i = 0; i < MAX_TIMERS; i++) {
+        if(activeTimers[i] == this) {
+            activeTimers[i] = 0;
+        }
+    }
+    running = false;
+}
+
+bool host_timer_step() {
+    IntervalTimer* next = 0;
+    for(int i = 0; i < MAX_TIMERS; i++) {
+        if(activeTimers[i] && (!next || activeTimers[i]->nextFire < next->nextFire)) {
+            next = activeTimers[i];
+        }
+    }
+    if(!next) {
+        return false;
+    }
+    if(next->nextFire > clockMicros) {
+        clockMicros = next->nextFire;
+    }
+    next->nextFire += next->period;
+    next->callback();
+    return true;
+}
+
+void host_run_timers() {
+    while(host_timer_step());
+}
+
+size_t HardwareSerial::write(uint8_t b) {
+    if(serialEcho) {
+        fputc(b, stderr);
+    }
+    return 1;
+}
+
+size_t Stream::write(const char *str) {
+    size_t n = 0;
+    while(*str) {
+        n += write((uint8_t) *str++);
+    }
+    return n;
+}
+
+size_t Stream::print(long n, int base) {
+    if(n < 0) {
+        return write((uint8_t) '-') + print((unsigned long) -n, base);
+    }
+    return print((unsigned long) n, base);
+}
+
+size_t Stream::print(unsigned long n, int base) {
+    char buf[8 * sizeof(long) + 1];
+    char *str = &buf[sizeof(buf) - 1];
+    if(base < 2) base = 10;
+    *str = '\0';
+    do {
+        const unsigned long digit = n % base;
+        n /= base;
+        *--str = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    } while(n);
+    return write(str);
+}
+
+size_t Stream::print(double n, int digits) {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", digits, n);
+    return write(buf);
+}
+
+String::String(const char *cstr) : buffer(0), len(0) {
+    assign(cstr, strlen(cstr));
+}
+
+String::String(char c) : buffer(0), len(0) {
+    assign(&c, 1);
+}
+
+String::String(int value) : buffer(0), len(0) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%d", value);
+    assign(buf, strlen(buf));
+}
+
+String::String(const String &other) : buffer(0), len(0) {
+    assign(other.buffer, other.len);
+}
+
+String::~String() {
+    free(buffer);
+}
+
+void String::assign(const char *cstr, unsigned int length) {
+    char *copy = (char*) malloc(length + 1);
+    memcpy(copy, cstr, length);
+    copy[length] = '\0';
+    free(buffer);
+    buffer = copy;
+    len = length;
+}
+
+String &String::operator=(const String &other) {
+    if(this != &other) {
+        assign(other.buffer, other.len);
+    }
+    return *this;
+}
+
+String &String::operator+=(const String &other) {
+    char *joined = (char*) malloc(len + other.len + 1);
+    memcpy(joined, buffer, len);
+    memcpy(joined + len, other.buffer, other.len + 1);
+    free(buffer);
+    buffer = joined;
+    len += other.len;
+    return *this;
+}
+
+String &String::operator+=(char c) {
+    return *this += String(c);
+}
+
+String operator+(const String &lhs, const String &rhs) {
+    String result(lhs);
+    result += rhs;
+    return result;
+}
+
+String operator+(const String &lhs, char c) {
+    String result(lhs);
+    result += c;
+    return result;
+}
+
+bool String::operator==(const String &other) const {
+    return len == other.len && memcmp(buffer, other.buffer, len) == 0;
+}
+
+char String::operator[](unsigned int index) const {
+    return index < len ? buffer[index] : '\0';
+}
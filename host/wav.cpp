@@ -0,0 +1,116 @@
+#include "wav.h"
+#include <stdio.h>
+#include <string.h>
+
+static void put16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+    put16(p, v & 0xFFFF);
+    put16(p + 2, v >> 16);
+}
+
+static bool writeSamples(FILE* f, const int16_t* samples, size_t count) {
+    uint8_t buf[512];
+    size_t i = 0;
+    while(i < count) {
+        size_t n = 0;
+        for(; n < sizeof(buf) && i < count; n += 2, i++) {
+            put16(&buf[n], (uint16_t) samples[i]);
+        }
+        if(fwrite(buf, 1, n, f) != n) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool wav_write(const char* path, const int16_t* samples, size_t count, uint32_t sampleRate, uint16_t channels) {
+    FILE* f = fopen(path, "wb");
+    if(!f) {
+        return false;
+    }
+    const uint32_t dataBytes = count * 2;
+    uint8_t header[44];
+    memcpy(header, "RIFF", 4);
+    put32(header + 4, 36 + dataBytes);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put32(header + 16, 16);         // fmt chunk size
+    put16(header + 20, 1);          // PCM
+    put16(header + 22, channels);
+    put32(header + 24, sampleRate);
+    put32(header + 28, sampleRate * 2 * channels);
+    put16(header + 32, 2 * channels); // block align
+    put16(header + 34, 16);         // bits per sample
+    memcpy(header + 36, "data", 4);
+    put32(header + 40, dataBytes);
+    bool ok = fwrite(header, 1, sizeof(header), f) == sizeof(header) && writeSamples(f, samples, count);
+    return fclose(f) == 0 && ok;
+}
+
+bool raw_write(const char* path, const int16_t* samples, size_t count) {
+    const bool toStdout = strcmp(path, "-") == 0;
+    FILE* f = toStdout ? stdout : fopen(path, "wb");
+    if(!f) {
+        return false;
+    }
+    bool ok = writeSamples(f, samples, count);
+    if(toStdout) {
+        return fflush(f) == 0 && ok;
+    }
+    return fclose(f) == 0 && ok;
+}
+
+static uint32_t get16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t* p) {
+    return get16(p) | (get16(p + 2) << 16);
+}
+
+bool wav_read(const char* path, std::vector<int16_t>& samples, uint32_t& sampleRate) {
+    FILE* f = fopen(path, "rb");
+    if(!f) {
+        return false;
+    }
+    uint8_t header[12];
+    uint32_t channels = 0, bits = 0;
+    bool ok = fread(header, 1, 12, f) == 12 && memcmp(header, "RIFF", 4) == 0 && memcmp(header + 8, "WAVE", 4) == 0;
+    while(ok) {
+        uint8_t chunk[8];
+        if(fread(chunk, 1, 8, f) != 8) {
+            ok = false;
+            break;
+        }
+        const uint32_t size = get32(chunk + 4);
+        if(memcmp(chunk, "fmt ", 4) == 0) {
+            uint8_t fmt[16];
+            ok = size >= 16 && fread(fmt, 1, 16, f) == 16 && get16(fmt) == 1 && fseek(f, size - 16 + (size & 1), SEEK_CUR) == 0;
+            channels = get16(fmt + 2);
+            sampleRate = get32(fmt + 4);
+            bits = get16(fmt + 14);
+            ok = ok && channels > 0 && (bits == 8 || bits == 16);
+        } else if(memcmp(chunk, "data", 4) == 0) {
+            if(!channels) {
+                ok = false;
+                break;
+            }
+            const uint32_t frameBytes = channels * bits / 8;
+            std::vector<uint8_t> data(size);
+            const size_t got = fread(data.data(), 1, size, f);
+            samples.clear();
+            samples.reserve(got / frameBytes);
+            for(size_t i = 0; i + frameBytes <= got; i += frameBytes) {
+                samples.push_back(bits == 16 ? (int16_t) get16(&data[i]) : (int16_t) ((data[i] - 128) << 8));
+            }
+            break;
+        } else if(fseek(f, size + (size & 1), SEEK_CUR) != 0) {
+            ok = false;
+        }
+    }
+    fclose(f);
+    return ok;
+}
@@ -0,0 +1,14 @@
+#ifndef WAV_H
+#define WAV_H
+//Minimal 16-bit PCM readers and writers shared by the host tools
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+//count is the number of samples over all channels, interleaved
+bool wav_write(const char* path, const int16_t* samples, size_t count, uint32_t sampleRate, uint16_t channels = 1);
+bool raw_write(const char* path, const int16_t* samples, size_t count); //headerless little-endian PCM, "-" for stdout
+//Reads 8 or 16-bit PCM, keeping the first channel of multi-channel files
+bool wav_read(const char* path, std::vector<int16_t>& samples, uint32_t& sampleRate);
+
+#endif // WAV_H
@@ -1,125 +1,413 @@
 #include "afsk.h"
+#include "profile.h"
 
 // Interrupt-related constants and instance variables
 IntervalTimer interruptTimer;
+IntervalTimer rxTimer;
 volatile bool txing = false;
 volatile bool rxing = false;
 
-volatile int freq = MARK_FREQ;
-
-volatile uint16_t analogOut = 0;
-volatile uint32_t currentPhase = 0; //32bit integer for higher res integer math
-volatile uint32_t increment = MARK_INCREMENT;
-
-//the index used to count how many samples we've sent for the current bit
-volatile byte bitIndex = 0;
-//the index denoting which bit within the current byte we are transmitting
-volatile byte byteIndex = 0;
-//the index denoting which bit we are transmitting
-volatile int packetIndex = 0;
-//the current byte being transmitted
-volatile char currentByte = 0; 
-//data structure for the packet
-volatile uint8_t* packet;
-//the total number of bits in the packet
+//the modulator selected by APRS_MODEM, holding the bit position, NRZI and phase state
+static Modem modem;
+//the buffer passed to afsk_modulate_packet and its total number of bits
+const volatile uint8_t* packet;
 volatile int packet_size = 0;
 
-// 1200 Baud settings
+//true while playing frames from txQueue rather than a single buffer passed to afsk_modulate_packet
+static volatile bool fromQueue = false;
+//the queued frame being modulated, released once its last bit has been rendered
+static TxFrame* volatile currentFrame = 0;
+//encoder of a streamed frame and the chunk the modulator is reading
+static AX25Stream frameStream;
+static uint8_t streamChunk[AX25_STREAM_CHUNK_BYTES];
+//the radio retuned before a key-up, and the channel the current key-up is on
+static DRA818V* tuner = 0;
+static volatile uint8_t keyedChannel = 0;
+//HDLC flags still to be sent as TXDELAY after key-up, before the first queued frame
+static volatile int txDelayFlags = 0;
+static const uint8_t txDelayFlag = HDLC_FLAG;
+//radioISR period in profiler ticks, the reference for its entry jitter
+static const uint32_t ISR_PERIOD_TICKS = (uint64_t) PROFILE_TICKS_PER_US * 1000000 * (DEBUG ? DEBUG_PRESCALER : 1) / SAMPLE_RATE;
+
+#if AFSK_PIPELINE != AFSK_PIPELINE_DIRECT
+//Ping-pong sample blocks. They are contiguous so the DMA engine can walk both halves as one circular buffer.
+static uint16_t sampleBuffer[2 * AFSK_BLOCK_SAMPLES];
+//the block holding the last samples of the packet, -1 until the producer has reached the end
+static volatile int8_t finalBlock = -1;
+#endif
+#if AFSK_PIPELINE == AFSK_PIPELINE_BLOCK
+//the block radioISR is copying samples from, and the next sample within it
+static volatile uint8_t playBlock = 0;
+static volatile int playIndex = 0;
+//the drained block the background producer has to refill
+static volatile uint8_t refillBlock = 0;
+#endif
+
+//Receive path: frames completed in rxISR wait in a small ring until afsk_receive copies them out
+static const uint8_t RX_QUEUE_SLOTS = 2;
+static AFSKDemodulator demod;
+static uint8_t rxFrames[RX_QUEUE_SLOTS][AFSK_RX_MAX_FRAME];
+static int rxLengths[RX_QUEUE_SLOTS];
+static volatile uint8_t rxHead = 0;
+static volatile uint8_t rxCount = 0;
+
 void radioISR(void);
+static void endTransmission();
+static void startOutput();
+
+//Moves the modulator on to the next TXDELAY flag or queued frame once the current bits have all been sent.
+//Frames are only separated by their own opening and closing flags, all under the same key-up. A streamed frame
+//is loaded a chunk at a time, encoding each one here as the previous one runs out.
+static bool nextFrame() {
+    if(!fromQueue) {
+        return false;
+    }
+    if(txDelayFlags > 0) {
+        txDelayFlags--;
+        modem.load(&txDelayFlag, 8);
+        return true;
+    }
+    if(currentFrame && currentFrame->streamed) {
+        const int bits = frameStream.next(streamChunk);
+        if(bits > 0) {
+            modem.load(streamChunk, bits);
+            return true;
+        }
+    }
+    if(currentFrame) {
+        txQueue.pop();
+    }
+    currentFrame = txQueue.front();
+    if(!currentFrame || currentFrame->channel != keyedChannel) {
+        currentFrame = 0; //a frame for another channel waits for its own key-up, after the retune
+        return false;
+    }
+    if(currentFrame->streamed) {
+        frameStream.begin(currentFrame->source);
+        modem.load(streamChunk, frameStream.next(streamChunk)); //the header alone gives a non-empty first chunk
+    } else {
+        modem.load(currentFrame->bits, currentFrame->size);
+    }
+    return true;
+}
+
+//Produces the next DAC sample, moving on to the next frame whenever the modulator runs out of bits.
+//Returns false once every bit has been sent.
+static inline bool modulateSample(uint16_t* sample) {
+    while(!modem.next(sample)) {
+        if(!nextFrame()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int afsk_fill_block(uint16_t* block, int count) {
+    int produced = 0;
+    while(produced < count && modulateSample(&block[produced])) {
+        produced++;
+    }
+    for(int i = produced; i < count; i++) {
+        block[i] = AFSK_IDLE_LEVEL;
+    }
+    return produced;
+}
+
+#if AFSK_PIPELINE != AFSK_PIPELINE_DIRECT
+//Background producer: renders one block, remembering which block the packet ended in
+static void fillBlock(uint8_t block) {
+    if(finalBlock >= 0) {
+        //already finished; the DMA reads on into this block while the final one's interrupt unkeys
+        for(int i = 0; i < AFSK_BLOCK_SAMPLES; i++) {
+            sampleBuffer[block * AFSK_BLOCK_SAMPLES + i] = AFSK_IDLE_LEVEL;
+        }
+        return;
+    }
+    if(afsk_fill_block(&sampleBuffer[block * AFSK_BLOCK_SAMPLES], AFSK_BLOCK_SAMPLES) < AFSK_BLOCK_SAMPLES) {
+        finalBlock = block;
+    }
+}
+
+//Called once a block has been played out: either the transmission is over or the block gets refilled
+static void blockDone(uint8_t block);
+
+const uint16_t* afsk_sample_blocks() {
+    return sampleBuffer;
+}
+#endif
+
+#if AFSK_PIPELINE == AFSK_PIPELINE_BLOCK
+static void refillISR() {
+    fillBlock(refillBlock);
+}
+
+#if defined(KINETISK)
+//The refill runs from the software interrupt at a lower priority than the sample timer, so rendering a block
+//never delays the next DAC write. This is the same interrupt the Teensy Audio library uses for its updates.
+static void requestRefill() {
+    NVIC_SET_PENDING(IRQ_SOFTWARE);
+}
+static void setupRefill() {
+    attachInterruptVector(IRQ_SOFTWARE, refillISR);
+    NVIC_SET_PRIORITY(IRQ_SOFTWARE, 208);
+    NVIC_ENABLE_IRQ(IRQ_SOFTWARE);
+}
+#else
+static void requestRefill() {
+    refillISR();
+}
+static void setupRefill() {}
+#endif
+
+static void blockDone(uint8_t block) {
+    if(finalBlock == block) {
+        endTransmission();
+        return;
+    }
+    refillBlock = block;
+    requestRefill();
+}
+#endif
+
+#if AFSK_PIPELINE == AFSK_PIPELINE_DMA
+#include <DMAChannel.h>
+#if SINE_WAVE_RESOLUTION != 12
+#error "AFSK_PIPELINE_DMA writes samples straight into the 12 bit DAC, use SINE_WAVE_RESOLUTION 12"
+#endif
+//PDB0 paces the DAC at SAMPLE_RATE and raises a DMA request per sample; the DMA channel copies from the
+//ping-pong buffer into DAC0 and interrupts at each half, where the drained half is refilled.
+#define AFSK_PDB_CONFIG (PDB_SC_TRGSEL(15) | PDB_SC_PDBEN | PDB_SC_CONT | PDB_SC_PDBIE | PDB_SC_DMAEN)
+static DMAChannel dacDMA(false);
+
+static void blockDone(uint8_t block) {
+    if(finalBlock == block) {
+        endTransmission();
+        return;
+    }
+    fillBlock(block);
+}
+
+static void dacDMAISR() {
+    const uint32_t saddr = (uint32_t) dacDMA.TCD->SADDR;
+    dacDMA.clearInterrupt();
+    //the DMA is reading the second half, so the first half has just been played, and vice versa
+    blockDone(saddr < (uint32_t) &sampleBuffer[AFSK_BLOCK_SAMPLES] ? 1 : 0);
+}
+
+static void dmaBegin() {
+    dacDMA.begin(true);
+    SIM_SCGC2 |= SIM_SCGC2_DAC0;
+    DAC0_C0 = DAC_C0_DACEN | DAC_C0_DACRFS; //3.3V reference, same as analogWrite
+    SIM_SCGC6 |= SIM_SCGC6_PDB;
+    PDB0_IDLY = 1;
+    PDB0_MOD = F_BUS / SAMPLE_RATE - 1;
+    PDB0_SC = AFSK_PDB_CONFIG | PDB_SC_LDOK;
+    PDB0_SC = AFSK_PDB_CONFIG | PDB_SC_SWTRIG;
+    PDB0_CH0C1 = 0x0101;
+    dacDMA.TCD->SADDR = sampleBuffer;
+    dacDMA.TCD->SOFF = 2;
+    dacDMA.TCD->ATTR = DMA_TCD_ATTR_SSIZE(1) | DMA_TCD_ATTR_DSIZE(1);
+    dacDMA.TCD->NBYTES_MLNO = 2;
+    dacDMA.TCD->SLAST = -sizeof(sampleBuffer);
+    dacDMA.TCD->DADDR = &DAC0_DAT0L;
+    dacDMA.TCD->DOFF = 0;
+    dacDMA.TCD->CITER_ELINKNO = sizeof(sampleBuffer) / 2;
+    dacDMA.TCD->DLASTSGA = 0;
+    dacDMA.TCD->BITER_ELINKNO = sizeof(sampleBuffer) / 2;
+    dacDMA.TCD->CSR = DMA_TCD_CSR_INTHALF | DMA_TCD_CSR_INTMAJOR;
+    dacDMA.triggerAtHardwareEvent(DMAMUX_SOURCE_PDB);
+    dacDMA.attachInterrupt(dacDMAISR);
+    dacDMA.enable();
+}
 
-uint16_t sineLookup(const int currentPhase) {
-    uint16_t analogOut = 0;
-    int index = currentPhase % (SINE_TABLE_LENGTH/2);
-    analogOut = (index < SINE_TABLE_LENGTH/4) ? sineTable[index] : sineTable[SINE_TABLE_LENGTH/2 - index - 1];
-    analogOut = (currentPhase >= ( SINE_TABLE_LENGTH/2 )) ? ((SINE_WAVE_MAX/2)- 1) - analogOut : analogOut;
-    return analogOut;
+static void dmaEnd() {
+    PDB0_SC = 0;
+    dacDMA.disable();
 }
+#endif
 
 void afsk_modulate_packet(volatile uint8_t *buffer, int size, int trailingBits) {
+    fromQueue = false;
     packet = buffer;
     packet_size = size;
-    Serial.println(size);
-    analogWriteResolution(SINE_WAVE_RESOLUTION);
+    Sink::begin();
     afsk_timer_begin();
 }
 
+void afsk_set_radio(DRA818V* radio) {
+    tuner = radio;
+    if(radio) {
+        radio->setTunedCallback(afsk_transmit_queue);
+    }
+}
+
+void afsk_transmit_queue() {
+    if(txing) {
+        return; //already on air, the interrupt picks up the new frame after the current one
+    }
+    TxFrame* front = txQueue.front();
+    //the radio gave up switching to this channel: its frames go, retuning for them again would never end
+    while(front && tuner && tuner->tuneFailed(front->channel)) {
+        txQueue.pop();
+        front = txQueue.front();
+    }
+    if(!front) {
+        return;
+    }
+    if(tuner && !tuner->tuned(front->channel)) {
+        tuner->tune(front->channel); //called again from DRA818V::poll() once the module has settled
+        return;
+    }
+    keyedChannel = front->channel;
+    Sink::begin();
+    fromQueue = true;
+    currentFrame = 0;
+    packet = 0;
+    packet_size = 0;
+    resetVolatiles();
+    txDelayFlags = TXDELAY_FLAGS;
+    digitalWrite(PTT_PIN,LOW);
+    startOutput();
+}
+
+void afsk_cancel() {
+    txQueue.clear();
+    currentFrame = 0;
+    endTransmission();
+}
+
 void afsk_timer_begin() {
+    resetVolatiles();
+    digitalWrite(PTT_PIN,LOW);
+    delay(PTT_DELAY);//todo: change this to match DRA object's delay
+    startOutput();
+}
+
+static void startOutput() {
+#if AFSK_PIPELINE != AFSK_PIPELINE_DIRECT
+    fillBlock(0);
+    fillBlock(1);
+#endif
+    txing = true;
+#if AFSK_PIPELINE == AFSK_PIPELINE_DMA
+    dmaBegin();
+#else
+#if AFSK_PIPELINE == AFSK_PIPELINE_BLOCK
+    setupRefill();
+#endif
+    PROFILE_ISR_RESTART();
     if(DEBUG) {
         interruptTimer.begin(radioISR,(float)1E6/(SAMPLE_RATE/DEBUG_PRESCALER)); //microseconds
-//        Serial.println(SAMPLES_PER_BIT);
-//        Serial.println(MARK_INCREMENT);
-//        Serial.println(SPACE_INCREMENT);
     } else {
         interruptTimer.begin(radioISR,(float)1E6/(SAMPLE_RATE));
     }
-    resetVolatiles();
-    digitalWrite(PTT_PIN,LOW);
-    delay(PTT_DELAY);//todo: change this to match DRA object's delay
-    txing = true;
+#endif
 }
 
 void resetVolatiles() {
-    freq = MARK_FREQ;
-    analogOut = 0;
-    currentPhase = 0;
-    increment = MARK_INCREMENT;
-    bitIndex = 0;
-    byteIndex = 0;
-    packetIndex = 0;
-    currentByte = 0;
+    modem.reset();
+    modem.load(packet, packet_size);
+#if AFSK_PIPELINE != AFSK_PIPELINE_DIRECT
+    finalBlock = -1;
+#endif
+#if AFSK_PIPELINE == AFSK_PIPELINE_BLOCK
+    playBlock = 0;
+    playIndex = 0;
+#endif
 }
 
 void afsk_timer_stop() {
+#if AFSK_PIPELINE == AFSK_PIPELINE_DMA
+    dmaEnd();
+#else
     interruptTimer.end();
+#endif
+}
+
+static void endTransmission() {
+    txing = false;
+    Sink::idle();
+    digitalWrite(PTT_PIN,HIGH);
+    if(DEBUG) {
+        digitalWrite(LED_PIN,LOW);
+    }
+    afsk_timer_stop();
+    //a frame queued while the block pipeline was draining its last samples starts a new key-up
+    if(fromQueue && txQueue.front()) {
+        afsk_transmit_queue();
+    }
 }
 
+//Sample timer interrupt. In the direct pipeline every sample is modulated here; in the block pipeline the
+//sample was rendered ahead of time and is only copied out, so the sink is written at a fixed point in the ISR.
 void radioISR() {
     if(!txing) return;
+    PROFILE_ISR_ENTRY(ISR_PERIOD_TICKS);
+    PROFILE_SCOPE(PROFILE_RADIO_ISR);
     if(DEBUG) digitalWrite(LED_PIN,HIGH);
-    if(bitIndex == 0) {
-        if(packetIndex >= packet_size) {
-            txing = false;
-            analogWrite(MIC_PIN,SINE_WAVE_MAX/2);
-            digitalWrite(PTT_PIN,HIGH);
-            if(DEBUG) {
-                digitalWrite(LED_PIN,LOW);
-            }
-            afsk_timer_stop();
-            return;
-        } else if (byteIndex== 0) {
-            currentByte = packet[packetIndex/8]; //grab the next byte to transmit
-            byteIndex = B10000000; //reset the byte bitmask to the first bit
-        }
-        //if we are supposed to send a 1 at this bit, maintain current TX frequency (NRZ encoding), unless we have sent 5 1s in a row and must stuff a 0
-        if(currentByte & byteIndex) { //transmitting a 1
-          if(DEBUG) {
-//              Serial.println("-1-");
-          }
-            //freq remains unchanged
-        } else { //transmitting a 0
-            if(DEBUG)  {
-//                Serial.println("-0-");
-            }
-            freq = (freq == MARK_FREQ) ? SPACE_FREQ : MARK_FREQ; //if we are supposed to send a 0 at this bit, change the current TX frequency
-        }
-        increment = (freq == MARK_FREQ) ? MARK_INCREMENT : SPACE_INCREMENT; //adjust the phase delta we add each sample depending on whether we are transmitting 0 or 1
-        bitIndex = SAMPLES_PER_BIT; //reset the bitIndex;
-        packetIndex++;
-        byteIndex>>=1; //shift to the next bit to be transmitted
-    } //endif: bitIndex == 0
-    currentPhase+=increment;
-    if(currentPhase > SINE_TABLE_LENGTH*ANGLE_RESOLUTION_PRESCALER) {
-        currentPhase-=SINE_TABLE_LENGTH*ANGLE_RESOLUTION_PRESCALER;
-    }
-//    Serial.println(currentPhase/ANGLE_RESOLUTION_PRESCALER);
-    bitIndex--;
-    analogOut = sineLookup((currentPhase/ANGLE_RESOLUTION_PRESCALER));
-//    Serial.println(analogOut);
-    if(freq == MARK_FREQ) {
-        analogOut = analogOut*PREEMPHASIS_RATIO;
-    }
-    analogWrite(MIC_PIN, analogOut);
+#if AFSK_PIPELINE == AFSK_PIPELINE_BLOCK
+    Sink::write(sampleBuffer[playBlock * AFSK_BLOCK_SAMPLES + playIndex]);
+    if(++playIndex == AFSK_BLOCK_SAMPLES) {
+        const uint8_t played = playBlock;
+        playIndex = 0;
+        playBlock ^= 1;
+        blockDone(played);
+        if(!txing) return;
+    }
+#else
+    uint16_t sample;
+    if(!modulateSample(&sample)) {
+        endTransmission();
+        return;
+    }
+    Sink::write(sample);
+#endif
     if(DEBUG) digitalWrite(LED_PIN,LOW);
 }
 
-
+//ADC sample interrupt. The DRA818 audio output is centred on mid-scale; it is shifted up to 16 bits for the demodulator.
+static void rxISR() {
+    if(txing) {
+        return; //half duplex, and the receiver hears our own carrier
+    }
+    const int16_t sample = (analogRead(AUDIO_PIN) - (1 << (AFSK_RX_ADC_RESOLUTION - 1))) << (16 - AFSK_RX_ADC_RESOLUTION);
+    if(!demod.process(sample) || rxCount == RX_QUEUE_SLOTS) {
+        return;
+    }
+    const uint8_t slot = (rxHead + rxCount) % RX_QUEUE_SLOTS;
+    memcpy(rxFrames[slot], demod.frame(), demod.frameLength());
+    rxLengths[slot] = demod.frameLength();
+    rxCount++;
+}
+
+void afsk_rx_begin() {
+    AFSKDemodConfig config = AFSK_DEMOD_DEFAULTS;
+    config.sampleRate = AFSK_RX_SAMPLE_RATE;
+    demod.begin(config);
+    rxHead = 0;
+    rxCount = 0;
+    analogReadResolution(AFSK_RX_ADC_RESOLUTION);
+    rxing = true;
+    rxTimer.begin(rxISR, (float)1E6/AFSK_RX_SAMPLE_RATE);
+}
+
+void afsk_rx_stop() {
+    rxTimer.end();
+    rxing = false;
+}
+
+int afsk_receive(uint8_t* frame, int capacity) {
+    if(rxCount == 0) {
+        return 0;
+    }
+    const int length = rxLengths[rxHead];
+    if(length <= capacity) {
+        memcpy(frame, rxFrames[rxHead], length);
+    }
+    noInterrupts(); //rxISR places a new frame at rxHead + rxCount, so both move together
+    rxHead = (rxHead + 1) % RX_QUEUE_SLOTS;
+    rxCount--;
+    interrupts();
+    return length <= capacity ? length : 0;
+}
+
@@ -1,58 +1,143 @@
 #ifndef AFSK_H
 #define AFSK_H
 #include "aprs.h"
-#include "DRA818v.h"
+#include "dra818v.h"
 #include "Arduino.h"
 #include "aprs_global.h"
+#include "modem.h"
+#include "sink.h"
+#include "demod.h"
+#include "txqueue.h"
 #include <stdint.h>
+
+//Sample output pipeline:
+//  DIRECT: radioISR modulates and writes one sample per timer interrupt
+//  BLOCK:  samples are rendered into ping-pong blocks by a background producer; radioISR only copies one out
+//  DMA:    Teensy 3.x only, PDB0 + DMA feed the DAC from the ping-pong blocks with no per-sample interrupt
+#define AFSK_PIPELINE_DIRECT 0
+#define AFSK_PIPELINE_BLOCK 1
+#define AFSK_PIPELINE_DMA 2
+#ifndef AFSK_PIPELINE
+#define AFSK_PIPELINE AFSK_PIPELINE_DIRECT //override the output pipeline by defining it here
+#endif
+#if AFSK_PIPELINE == AFSK_PIPELINE_DMA && !defined(KINETISK)
+#error "AFSK_PIPELINE_DMA needs the Teensy 3.x PDB and DAC"
+#endif
+static const int AFSK_BLOCK_SAMPLES = 64; //samples per ping-pong block
+
+//Modem selection, see modem.h. Every mode shares the HDLC framing, the queue and the output pipelines.
+//  AFSK1200:  Bell 202 tones, the APRS standard on VHF
+//  AFSK300:   200 Hz shift HF packet, fed to an SSB transmitter
+//  G3RUH9600: scrambled baseband FSK; needs the radio's flat (unemphasised) modulator input, not the mic path
+#define MODEM_AFSK1200 0
+#define MODEM_AFSK300 1
+#define MODEM_G3RUH9600 2
+#ifndef APRS_MODEM
+#define APRS_MODEM MODEM_AFSK1200
+#endif
+
 //Frequency Constants
 static const int MARK_FREQ = 1200;
 static const int SPACE_FREQ = 2200;
-static const float PREEMPHASIS_RATIO = 0.75;
+static const int HF_MARK_FREQ = 1600;
+static const int HF_SPACE_FREQ = 1800;
+static constexpr float PREEMPHASIS_RATIO = 0.75; //mark amplitude relative to space
 
 //Time Constants
-static const int BIT_RATE = 1200; //APRS standard.
-static const uint32_t SAMPLE_RATE = 9600;
-static const uint32_t SAMPLES_PER_BIT = SAMPLE_RATE / BIT_RATE;
+#ifndef AFSK_SAMPLE_RATE
+#define AFSK_SAMPLE_RATE 9600 //a multiple of 1200; with the BLOCK/DMA pipelines it can be raised (e.g. 38400)
+#endif
+#ifndef G3RUH_SAMPLE_RATE
+#define G3RUH_SAMPLE_RATE 48000 //5 samples per bit, use the BLOCK or DMA pipeline at this rate
+#endif
+
+typedef AFSKModulator<1200, AFSK_SAMPLE_RATE, MARK_FREQ, SPACE_FREQ, SINE_WAVE_RESOLUTION, (int) (PREEMPHASIS_RATIO * 100)> AFSK1200;
+typedef AFSKModulator<300, 9600, HF_MARK_FREQ, HF_SPACE_FREQ, SINE_WAVE_RESOLUTION, 100> AFSK300;
+typedef G3RUHModulator<9600, G3RUH_SAMPLE_RATE, SINE_WAVE_RESOLUTION> G3RUH9600;
+#if APRS_MODEM == MODEM_AFSK1200
+typedef AFSK1200 Modem;
+#elif APRS_MODEM == MODEM_AFSK300
+typedef AFSK300 Modem;
+#elif APRS_MODEM == MODEM_G3RUH9600
+typedef G3RUH9600 Modem;
+#else
+#error "unknown APRS_MODEM"
+#endif
+
+static const int BIT_RATE = Modem::BIT_RATE;
+static const uint32_t SAMPLE_RATE = Modem::SAMPLE_RATE;
+static const uint32_t SAMPLES_PER_BIT = Modem::SAMPLES_PER_BIT;
+static const int TXDELAY_FLAGS = (uint32_t) PTT_DELAY * BIT_RATE / 8000; //flags sent while the radio keys up
 static const int DEBUG_PRESCALER = 1;//Set to 1 for full speed, higher to slow down interrupts by that factor
 
-//Phase Delta Constants
-static const int SINE_TABLE_LENGTH = 512;
-static const int SINE_WAVE_MAX = pow(2,SINE_WAVE_RESOLUTION + 1);
+static const uint16_t AFSK_IDLE_LEVEL = 1 << (SINE_WAVE_RESOLUTION - 1); //DAC mid-scale, parked there between packets
 
-static const int ANGLE_RESOLUTION_PRESCALER = 1000; 
-static const uint32_t MARK_INCREMENT = ANGLE_RESOLUTION_PRESCALER * SINE_TABLE_LENGTH * MARK_FREQ / SAMPLE_RATE;
-static const uint32_t SPACE_INCREMENT = ANGLE_RESOLUTION_PRESCALER * SINE_TABLE_LENGTH * SPACE_FREQ / SAMPLE_RATE;
+//Output sink, see sink.h. Every sink works with the DIRECT and BLOCK pipelines; DMA writes the DAC itself.
+//  DAC: analogWrite to MIC_PIN, the Teensy 3.x DAC
+//  PWM: PWM_PIN at AFSK_PWM_FREQUENCY, then an RC low-pass (two stages of about 3.3k and 10n, corner near
+//       5 kHz) into the radio's mic input. The ideal frequency for 8 bits on a Teensy 3.x is 187.5 kHz.
+//  I2S: an external codec on I2S0
+//  PCM: host only, 16-bit PCM written to PCMStreamSink::stream (stdout by default)
+#define AFSK_SINK_DAC 0
+#define AFSK_SINK_PWM 1
+#define AFSK_SINK_I2S 2
+#define AFSK_SINK_PCM 3
+#ifndef AFSK_SINK
+#define AFSK_SINK AFSK_SINK_DAC
+#endif
+#ifndef AFSK_PWM_RESOLUTION
+#define AFSK_PWM_RESOLUTION 8
+#endif
+#ifndef AFSK_PWM_FREQUENCY
+#define AFSK_PWM_FREQUENCY 187500
+#endif
+#if AFSK_PIPELINE == AFSK_PIPELINE_DMA && AFSK_SINK != AFSK_SINK_DAC
+#error "AFSK_PIPELINE_DMA only drives the DAC"
+#endif
+
+#if AFSK_SINK == AFSK_SINK_DAC
+typedef DACSink<MIC_PIN, SINE_WAVE_RESOLUTION> Sink;
+#elif AFSK_SINK == AFSK_SINK_PWM
+typedef PWMSink<PWM_PIN, SINE_WAVE_RESOLUTION, AFSK_PWM_RESOLUTION, AFSK_PWM_FREQUENCY> Sink;
+#elif AFSK_SINK == AFSK_SINK_I2S && defined(KINETISK)
+typedef I2SSink<SINE_WAVE_RESOLUTION, SAMPLE_RATE> Sink;
+#elif AFSK_SINK == AFSK_SINK_PCM && defined(APRS_HOST)
+typedef PCMStreamSink<SINE_WAVE_RESOLUTION> Sink;
+#else
+#error "AFSK_SINK is unknown or not available on this board"
+#endif
+
+//Receive: AUDIO_PIN is read by a second IntervalTimer at AFSK_RX_SAMPLE_RATE and fed to an AFSKDemodulator
+#ifndef AFSK_RX_SAMPLE_RATE
+#define AFSK_RX_SAMPLE_RATE 9600
+#endif
+static const int AFSK_RX_ADC_RESOLUTION = 12;
 // Exported functions
 
-void afsk_modulate_packet(volatile uint8_t* buffer, int size, int trailingBits);
+void afsk_modulate_packet(volatile uint8_t* buffer, int size, int trailingBits); //one buffer, blocking PTT_DELAY key-up
+//Starts sending txQueue if the transmitter is idle and returns straight away. PTT is keyed once, TXDELAY is
+//sent as flags and every queued frame follows back to back; frames queued while on air join the same key-up.
+void afsk_transmit_queue();
+void afsk_cancel(); //unkeys at once and drops every queued frame
+//The radio whose channel plan queued frames are sent on. Before each key-up the transmitter checks it is tuned
+//to the first frame's channel, or asks it to retune and starts once DRA818V::poll() reports the switch settled.
+//0 sends without checking.
+void afsk_set_radio(DRA818V* radio);
 void afsk_timer_begin();
 void afsk_timer_stop();
 void resetVolatiles();
+//Renders the next count samples of the packet being modulated, padding with AFSK_IDLE_LEVEL after its end.
+//Returns the number of packet samples written. This is the block producer behind the BLOCK and DMA pipelines.
+int afsk_fill_block(uint16_t* block, int count);
+#if AFSK_PIPELINE != AFSK_PIPELINE_DIRECT
+//Both ping-pong blocks, 2 * AFSK_BLOCK_SAMPLES. Once a packet has been rendered, everything after its last
+//sample is AFSK_IDLE_LEVEL.
+const uint16_t* afsk_sample_blocks();
+#endif
+void afsk_rx_begin(); //starts sampling AUDIO_PIN; samples taken while transmitting are skipped
+void afsk_rx_stop();
+//Copies out the oldest received frame (address field to info, FCS removed) and returns its length, or 0 if
+//none is waiting. Frames that are bigger than capacity are dropped.
+int afsk_receive(uint8_t* frame, int capacity);
 
-#if SINE_WAVE_RESOLUTION == 12
-static const uint16_t sineTable[128] = {
-2047, 2072, 2097, 2122, 2147, 2173, 2198, 2223, 2248, 2273, 2298, 2323, 2348, 2372, 2397, 2422,
-2447, 2471, 2496, 2520, 2545, 2569, 2593, 2617, 2642, 2666, 2689, 2713, 2737, 2761, 2784, 2807, 
-2831, 2854, 2877, 2900, 2923, 2945, 2968, 2990, 3012, 3035, 3056, 3078, 3100, 3121, 3143, 3164,
-3185, 3206, 3226, 3247, 3267, 3287, 3307, 3327, 3346, 3366, 3385, 3404, 3422, 3441, 3459, 3477,
-3495, 3513, 3530, 3547, 3564, 3581, 3598, 3614, 3630, 3646, 3662, 3677, 3692, 3707, 3721, 3736,
-3750, 3764, 3777, 3791, 3804, 3816, 3829, 3841, 3853, 3865, 3876, 3887, 3898, 3909, 3919, 3929,
-3939, 3949, 3958, 3967, 3975, 3984, 3992, 3999, 4007, 4014, 4021, 4027, 4034, 4040, 4045, 4051,
-4056, 4060, 4065, 4069, 4073, 4076, 4080, 4083, 4085, 4087, 4089, 4091, 4093, 4094, 4094, 4095,
-};
-#else
-#define SINE_WAVE_RESOLUTION 8
-static const uint8_t sineTable[128] = 
-{
-    128, 129, 131, 132, 134, 135, 137, 138, 140, 142, 143, 145, 146, 148, 149, 151,
-    152, 154, 155, 157, 158, 160, 162, 163, 165, 166, 167, 169, 170, 172, 173, 175,
-    176, 178, 179, 181, 182, 183, 185, 186, 188, 189, 190, 192, 193, 194, 196, 197,
-    198, 200, 201, 202, 203, 205, 206, 207, 208, 210, 211, 212, 213, 214, 215, 217,
-    218, 219, 220, 221, 222, 223, 224, 225, 226, 227, 228, 229, 230, 231, 232, 233,
-    234, 234, 235, 236, 237, 238, 238, 239, 240, 241, 241, 242, 243, 243, 244, 245,
-    245, 246, 246, 247, 248, 248, 249, 249, 250, 250, 250, 251, 251, 252, 252, 252,
-    253, 253, 253, 253, 254, 254, 254, 254, 254, 255, 255, 255, 255, 255, 255, 255,
-};
-#endif
-#endif // AFSK_H
+#endif // AFSK_H
@@ -1,18 +1,54 @@
 #include "aprs.h"
-uint16_t crc = 0;
-uint8_t consecutiveOnes = 0;
-uint8_t bitMask= B00000000;
-uint8_t bitPos = 8;
-void latToStr(char * const s, const int size, float lat);
-void lonToStr(char * const s, const int size, float lon);
+#include "profile.h"
 APRS::APRS(DRA818V *DRA, SSID *addr, uint8_t nSSIDs) {
    radio = DRA;
-   packet_buffer = new uint8_t[BUFFER_SIZE_MAX]();
+   packet_buffer = 0;
+   packet_size = 0;
    num_HDLC_Flags = N_HDLC_FLAGS;
+   channel = 0;
+   fx25 = FX25_OFF;
+   afsk_set_radio(radio);
    APRS::setSSIDs(addr, nSSIDs);
 }
 
-void APRS::sendPacketGPS(
+APRS::APRS(DRA818V *DRA, const AX25Header* prebuilt) {
+   radio = DRA;
+   packet_buffer = 0;
+   packet_size = 0;
+   num_HDLC_Flags = N_HDLC_FLAGS;
+   channel = 0;
+   fx25 = FX25_OFF;
+   afsk_set_radio(radio);
+   APRS::setHeader(prebuilt);
+}
+
+//"/DDHHMMzDDMM.mmN/DDDMM.mmWOCCC/SSS/A=nnnnnn" and the comment, formatted with integer math straight into the
+//encoder
+bool APRS::sendPacketGPSFixed(
+    const uint8_t dayOfMonth, const uint8_t hour, const uint8_t min,
+    const int32_t lat,
+    const int32_t lon,
+    const int32_t altitude,
+    const uint16_t heading,
+    const uint16_t speed,
+    const char * const comment) {
+
+    PROFILE_SCOPE(PROFILE_FRAME_BUILD);
+    if(!APRS::beginPacket()) {
+        return false;
+    }
+    APRS::loadHeader();
+    encoder.put('/'); // Report w/ timestamp, no APRS messaging. $ = NMEA raw data
+    aprs_put_timestamp(encoder, dayOfMonth, hour, min);
+    aprs_put_position(encoder, lat, lon, '/', 'O');
+    aprs_put_course_speed(encoder, heading, speed);
+    aprs_put_altitude(encoder, altitude); // Goes anywhere in the comment area
+    aprs_put_string(encoder, comment);
+    return APRS::endPacket();
+}
+
+//Converts once at the API boundary; double keeps the 1e-7 degree digits a float would lose
+bool APRS::sendPacketGPS(
     const uint8_t dayOfMonth, const uint8_t hour, const uint8_t min,
     const float lat,
     const float lon, // degrees
@@ -20,261 +56,250 @@ void APRS::sendPacketGPS(
     const uint16_t heading, // degrees
     const float speed,
     const char * const comment) {
+    return APRS::sendPacketGPSFixed(dayOfMonth, hour, min,
+        (int32_t) (lat * 10000000.0 + (lat < 0 ? -0.5 : 0.5)),
+        (int32_t) (lon * 10000000.0 + (lon < 0 ? -0.5 : 0.5)),
+        (int32_t) (altitude + (altitude < 0 ? -0.5f : 0.5f)),
+        heading,
+        (uint16_t) (speed > 0 ? speed + 0.5f : 0),
+        comment);
+}
 
-    crc = 0xffff;
-    consecutiveOnes = 0;
-    bitMask = 0;
-    bitPos = 8;
-    APRS::clearPacket();
-    APRS::loadHeader();
-    char temp[12];
-    APRS::loadByte('/'); // Report w/ timestamp, no APRS messaging. $ = NMEA raw data
-    snprintf(temp, sizeof(temp), "%02u%02u%02uz", (unsigned int) dayOfMonth,
-        (unsigned int) hour, (unsigned int) min);
-    APRS::loadString(temp);
-    latToStr(temp, sizeof(temp), lat);
-    APRS::loadString(temp);             // Lat:
-    APRS::loadByte('/');          // Which Symbol table to use
-    lonToStr(temp, sizeof(temp), lon);
-    APRS::loadString(temp);     // Lon: 000deg and 25.80 min
-    APRS::loadByte('O');  // The symbol
-    snprintf(temp, sizeof(temp), "%03u", heading);
-    APRS::loadString(temp);             // Heading (degrees)
-    APRS::loadByte('/');                // and
-    snprintf(temp, sizeof(temp), "%03d", (unsigned int) (speed + 0.5));
-    APRS::loadString(temp);             // speed (knots)
-    APRS::loadString("/A="); // Altitude (feet). Goes anywhere in the comment area
-    snprintf(temp, sizeof(temp), "%06ld", (long) (altitude / 0.3048)); // 10000 ft = 3048 m
-    APRS::loadString(temp);  
-    APRS::loadString(comment);
-    APRS::loadFooter();
-    APRS::loadTrailingBits(bitPos);//load the trailing bits that might exist due to bitstuffing
-    afsk_modulate_packet(packet_buffer, APRS::getPacketSize(),(8-bitPos));
-    }
-    
-void APRS::sendPacketGPS(
+bool APRS::sendPacketGPS(
     const uint8_t dayOfMonth, const uint8_t hour, const uint8_t min,
     const float lat,
     const float lon, // degrees
     const float altitude, // meters
     const uint16_t heading, // degrees
     const float speed,
-    String comment) {
-      
-    crc = 0xffff;
-    consecutiveOnes = 0;
-    bitMask = 0;
-    bitPos = 8;
-    APRS::clearPacket();
-    APRS::loadHeader();
-    char temp[12];
-    APRS::loadByte('/'); // Report w/ timestamp, no APRS messaging. $ = NMEA raw data
-    snprintf(temp, sizeof(temp), "%02u%02u%02uz", (unsigned int) dayOfMonth,
-        (unsigned int) hour, (unsigned int) min);
-    APRS::loadString(temp);
-    latToStr(temp, sizeof(temp), lat);
-    APRS::loadString(temp);             // Lat:
-    APRS::loadByte('/');          // Which Symbol table to use
-    lonToStr(temp, sizeof(temp), lon);
-    APRS::loadString(temp);     // Lon: 000deg and 25.80 min
-    APRS::loadByte('O');  // The symbol
-    snprintf(temp, sizeof(temp), "%03u", heading);
-    APRS::loadString(temp);             // Heading (degrees)
-    APRS::loadByte('/');                // and
-    snprintf(temp, sizeof(temp), "%03d", (unsigned int) (speed + 0.5));
-    APRS::loadString(temp);             // speed (knots)
-    APRS::loadString("/A="); // Altitude (feet). Goes anywhere in the comment area
-    snprintf(temp, sizeof(temp), "%06ld", (long) (altitude / 0.3048)); // 10000 ft = 3048 m
-    APRS::loadString(temp);  
-    APRS::loadString(comment);
-    APRS::loadFooter();
-    APRS::loadTrailingBits(bitPos);//load the trailing bits that might exist due to bitstuffing
-    afsk_modulate_packet(packet_buffer, APRS::getPacketSize(),(8-bitPos));  
+    const String& comment) {
+    return APRS::sendPacketGPS(dayOfMonth, hour, min, lat, lon, altitude, heading, speed, comment.c_str());
+}
+
+bool APRS::sendPacketCompressedFixed(
+    const uint8_t dayOfMonth, const uint8_t hour, const uint8_t min,
+    const int32_t lat,
+    const int32_t lon,
+    const int32_t altitude,
+    const uint16_t heading,
+    const uint16_t speed,
+    const char * const comment) {
+
+    if(!APRS::beginPacket()) {
+        return false;
     }
-    
-void APRS::sendPacketNoGPS(String data) {
-    crc = 0xffff;
-    consecutiveOnes = 0;
-    bitMask = 0;
-    bitPos = 8;
-    APRS::clearPacket();
     APRS::loadHeader();
-    APRS::loadString(data);
-    APRS::loadFooter();
-    APRS::loadTrailingBits(bitPos);//load the trailing bits that might exist due to bitstuffing
-    afsk_modulate_packet(packet_buffer, APRS::getPacketSize(),(8-bitPos));
+    char position[APRS_COMPRESSED_LENGTH];
+    encoder.put('/'); // Report w/ timestamp, no APRS messaging
+    aprs_put_timestamp(encoder, dayOfMonth, hour, min);
+    aprs_compress_position(position, lat, lon, '/', 'O', heading, speed);
+    aprs_put_data(encoder, position, APRS_COMPRESSED_LENGTH);
+    aprs_put_altitude(encoder, altitude); // cs carries course/speed, so altitude stays in the comment
+    aprs_put_string(encoder, comment);
+    return APRS::endPacket();
 }
 
-void APRS::clearPacket() {
-    packet_size = 0;
+//Converts once at the API boundary; double keeps the 1e-7 degree digits a float would lose
+bool APRS::sendPacketCompressed(
+    const uint8_t dayOfMonth, const uint8_t hour, const uint8_t min,
+    const float lat,
+    const float lon, // degrees
+    const float altitude, // meters
+    const uint16_t heading, // degrees
+    const float speed,
+    const char * const comment) {
+    return APRS::sendPacketCompressedFixed(dayOfMonth, hour, min,
+        (int32_t) (lat * 10000000.0 + (lat < 0 ? -0.5 : 0.5)),
+        (int32_t) (lon * 10000000.0 + (lon < 0 ? -0.5 : 0.5)),
+        (int32_t) (altitude + (altitude < 0 ? -0.5f : 0.5f)),
+        heading,
+        (uint16_t) (speed > 0 ? speed + 0.5f : 0),
+        comment);
 }
 
-void APRS::setSSIDs(SSID *addr, uint8_t numSSIDs) {
-    ssids = new SSID[numSSIDs];
-    for(int i = 0; i < numSSIDs; i++) {
-        ssids[i].address = addr[i].address;
-        ssids[i].ssid_designator = addr[i].ssid_designator;
+bool APRS::sendPacketMicE(
+    const int32_t lat,
+    const int32_t lon,
+    const int32_t altitude,
+    const uint16_t heading,
+    const uint16_t speed,
+    const MicEMessage message,
+    const char * const comment) {
+
+    if(!APRS::beginPacket()) {
+        return false;
     }
-    num_ssids = numSSIDs;
+    uint8_t temp[AX25_ADDRESS_LENGTH + MICE_INFO_LENGTH];
+    aprs_mice_destination(temp, lat, lon, message);
+    APRS::loadHeader(temp);
+    aprs_mice_info(temp, lon, heading, speed, '/', 'O');
+    aprs_mice_altitude(temp + MICE_INFO_LENGTH, altitude);
+    aprs_put_data(encoder, temp, MICE_INFO_LENGTH + MICE_ALTITUDE_LENGTH);
+    aprs_put_string(encoder, comment);
+    return APRS::endPacket();
 }
 
-void APRS::loadHeader() {
-    for(int i = 0; i < num_HDLC_Flags; i++) {
-        APRS::loadHDLCFlag();
-    }
-    for (int addr = 0; addr < num_ssids; addr++) {
-        // Transmit callsign   
-        uint8_t j = 0; 
-        for (j = 0; j<strlen(ssids[addr].address); j++) {
-          APRS::loadByte(ssids[addr].address[j] <<1);
-        }
-        // Transmit pad 
-        while (j < 6) {
-            APRS::loadByte(' '<<1);
-            j++;
-        }
-      // Transmit SSID. Termination signaled with last bit = 1
-      if (addr == num_ssids - 1)
-        APRS::loadByte(('0' + ssids[addr].ssid_designator) << 1 | 1);
-      else
-        APRS::loadByte(('0' + ssids[addr].ssid_designator) << 1);
-    }
+bool APRS::sendPacketNoGPS(const String& data) {
+    return APRS::sendPayload((const uint8_t*) data.c_str(), data.length());
+}
 
-    // Control field Byte: 3 = APRS-UI frame
-    APRS::loadByte(0x03);
+bool APRS::sendPacketNoGPS(const char* data) {
+    return APRS::sendPayload((const uint8_t*) data, strlen(data));
+}
 
-    // Protocol ID Byte: 0xf0 = no layer 3 data
-    APRS::loadByte(0xf0);
+bool APRS::sendPayload(const APRSPayload& payload) {
+    return APRS::sendPayload(payload.data(), payload.length());
 }
-void APRS::loadData(uint8_t* data_buffer, uint8_t length) {
-    for(int i = 0; i < length;i++ ) {
-        APRS::loadByte(data_buffer[i]);
+
+//A ready-made information field behind the cached header
+bool APRS::sendPayload(const uint8_t* info, int length) {
+    if(!APRS::beginPacket()) {
+        return false;
     }
+    APRS::loadHeader();
+    aprs_put_data(encoder, info, length);
+    return APRS::endPacket();
 }
 
-void APRS::loadFooter() {
-    uint16_t final_crc = crc;
-    // Send the CRC
-    APRS::loadByte(~(final_crc & 0xff));
-    final_crc >>= 8;
-    APRS::loadByte(~(final_crc & 0xff));
-    APRS::loadHDLCFlag();
+bool APRS::sendFrame(const uint8_t* address, uint8_t addressLength, const uint8_t* info, int infoLength, uint8_t pid) {
+    if(!APRS::beginPacket()) {
+        return false;
+    }
+    for(int i = 0; i < num_HDLC_Flags; i++) {
+        APRS::loadHDLCFlag();
+    }
+    APRS::loadData(address, addressLength);
+    APRS::loadByte(AX25_CONTROL_UI);
+    APRS::loadByte(pid);
+    APRS::loadData(info, infoLength);
+    return APRS::endPacket();
 }
 
-//Transmits a byte of information, which can be anything except for the FCS sequence.
-//By protocol, all bytes are transmitted least significant byte first, except for the FCS sequence.
-void APRS::loadByte(uint8_t byte) {
-//  Serial.println(byte,BIN);
-    for(int i = 0; i < 8; i++) {
-        APRS::loadBit(byte & 1,true);
-        byte>>=1;//next iteration transmits the next bit to the left
-    }  
-//  Serial.print(".");
-//  Serial.print((char) byte);
-//  Serial.println(byte,BIN);
+bool APRS::streamPacket(const uint8_t* info, int length) {
+    if(length < 0 || length > AX25_MAX_INFO_LENGTH) {
+        return false;
+    }
+    AX25FrameSource source = {header, info, length, 0, 0};
+    return APRS::queueStream(source);
 }
 
-//the loadBit function will load each bit of data to a bitmask, but will only insert the bitmask into the packet buffer after 8 bits
-//have been loaded. If bitstuffing occurs (a nonmultiple of 8 times), then there will be leftover bits in the bitmask that need to be added to the packet.
-void APRS::loadTrailingBits(uint8_t bitIndex) {
-    if(bitIndex==0) {
-        return; //if there were no trailing bits, return
+bool APRS::streamPacket(AX25InfoReader reader, void* context) {
+    AX25FrameSource source = {header, 0, 0, reader, context};
+    return APRS::queueStream(source);
+}
+
+//A streamed frame only takes a slot for its place in the queue; the transmitter encodes it from source
+bool APRS::queueStream(const AX25FrameSource& source) {
+    if(!txQueue.reserve()) {
+        return false;
     }
-    packet_buffer[packet_size/8] = bitMask;
+    txQueue.commitStream(source, channel);
+    afsk_transmit_queue();
+    return true;
 }
 
-void APRS::loadBit(uint8_t bit, bool bitStuff) {
-//    Serial.println(bit);
-//    Serial.println(bitPos);
-    if (bitStuff) {
-        APRS::update_crc(bit);
+//Claims the next free transmit slot and points the encoder at it
+bool APRS::beginPacket() {
+    TxFrame* slot = txQueue.reserve();
+    if(!slot) {
+        return false;
     }
-    if(bitPos == 0) {
-        bitPos = 8;
-        packet_buffer[packet_size/8 - 1] = bitMask;
-//        Serial.print("*");
-//        Serial.println(bitMask,BIN);
-        bitMask = B00000000;  
+    packet_buffer = slot->bits;
+    APRS::clearPacket();
+    return true;
+}
+
+//Closes the frame (FCS, flag, trailing bits), wraps it in an FX.25 codeblock if that is on and queues it. A frame
+//that outgrew its slot is dropped; the slot was never committed, so it stays free.
+bool APRS::endPacket() {
+    APRS::loadFooter();
+    APRS::loadTrailingBits();
+    if(encoder.overflowed()) {
+        return false;
     }
-    if (bit) {
-//          Serial.println(bitMask,BIN);
-//          Serial.println(bitPos);
-        bitMask |= (1<<(bitPos-1));
-//            Serial.println(bitMask,BIN);
-
-        bitPos--;
-        packet_size++;
-        if (bitStuff && ++consecutiveOnes == BIT_STUFF_THRESHOLD) {
-            APRS::loadBit(0, false);
-//            Serial.print("!");
-            consecutiveOnes = 0;
+    if(fx25 != FX25_OFF) {
+        const int size = fx25_wrap((uint8_t*) packet_buffer, packet_size, BUFFER_SIZE_MAX, fx25);
+        if(size > 0) {
+            packet_size = size;
         }
-    } else {
-        consecutiveOnes = 0;
-        bitPos--;
-        packet_size++;
     }
+    APRS::queuePacket();
+    return true;
 }
 
-void APRS::loadHDLCFlag() {
-    APRS::loadBit(0, false);
-    for (int i = 0; i < 6; i++) {
-        APRS::loadBit(1, false);
-    }
-    APRS::loadBit(0, false);
+//Hands the finished frame to the transmitter
+void APRS::queuePacket() {
+    txQueue.commit(packet_size, channel);
+    afsk_transmit_queue();
+}
+
+void APRS::clearPacket() {
+    packet_size = 0;
+    encoder.begin(packet_buffer, packet_buffer ? BUFFER_SIZE_MAX : 0);
 }
 
-void APRS::loadString(String str) {
-    for(uint8_t i = 0; i < str.length(); i++) {
-        APRS::loadByte(str[i]);
+//Encodes the path once; every packet then starts from a copy of this cached header
+void APRS::setSSIDs(SSID *addr, uint8_t numSSIDs) {
+    headerCache = ax25_header(addr, numSSIDs, num_HDLC_Flags);
+    header = &headerCache;
+}
+
+//Uses a header built elsewhere, typically a constexpr ax25_header() kept in flash. It must outlive its use here.
+void APRS::setHeader(const AX25Header* prebuilt) {
+    header = prebuilt;
+}
+
+//Copies the pre-stuffed flags, address field, control and PID bytes and resumes the encoder (FCS, stuffing
+//state and leftover bits) where the header ended, so only the information field is encoded per packet.
+void APRS::loadHeader() {
+    const int bytes = header->state.bytes;
+    for(int i = 0; i < bytes; i++) {
+        packet_buffer[i] = header->bits[i];
     }
+    encoder.resume(packet_buffer, BUFFER_SIZE_MAX, header->state);
 }
-void APRS::loadString(char* str) {
-    for(uint8_t i = 0; i < strlen(str); i++) {
-        APRS::loadByte(str[i]);
+
+//Header with a per-packet destination. The cached bits can't be reused since they start with the old
+//destination, but the raw address bytes of the other entries can: the whole address field is re-encoded.
+void APRS::loadHeader(const uint8_t* destination) {
+    for(int i = 0; i < header->flags; i++) {
+        APRS::loadHDLCFlag();
     }
+    APRS::loadData(destination, AX25_ADDRESS_LENGTH);
+    APRS::loadData(header->address + AX25_ADDRESS_LENGTH, header->addressLength - AX25_ADDRESS_LENGTH);
+    APRS::loadByte(AX25_CONTROL_UI);
+    APRS::loadByte(AX25_PID_NO_LAYER3);
 }
 
-void APRS::update_crc(uint8_t bit) {
-    const uint16_t xor_int = crc ^ bit;  // XOR lsb of CRC with the latest bit
-    crc >>= 1;                          // Shift 16-bit CRC one bit to the right
-    if (xor_int & 0x0001) {              // If XOR result from above has lsb set
-        crc ^= 0x8408;                  // Shift 16-bit CRC one bit to the right
+void APRS::loadData(const uint8_t* data_buffer, int length) {
+    for(int i = 0; i < length;i++ ) {
+        APRS::loadByte(data_buffer[i]);
     }
-    return;
 }
 
-int APRS::getPacketSize() {
-    return packet_size;
+void APRS::loadFooter() {
+    // Send the CRC
+    encoder.loadFCS();
+    APRS::loadHDLCFlag();
+}
+
+//Transmits a byte of information, which can be anything except for the FCS sequence.
+//By protocol, all bytes are transmitted least significant bit first; the encoder stuffs the whole byte at once.
+void APRS::loadByte(uint8_t byte) {
+    encoder.loadByte(byte);
 }
 
-void latToStr(char * const s, const int size, float lat)
-{
-  char hemisphere = 'N';
-  if (lat < 0) {
-    lat = -lat;
-    hemisphere = 'S';
-  }
-  const int deg = (int) lat;
-  lat = (lat - (float) deg) * 60.0f;
-  const int min = (int) lat;
-  lat = (lat - (float) min) * 100.0f;
-  const int minTenths = (int) (lat + 0.5); // Round the tenths
-  snprintf(s, size, "%02d%02d.%02d%c", deg, min, minTenths, hemisphere);
+//The encoder writes whole 32-bit words as they fill up. Bit stuffing makes the frame a non-multiple of 8 bits
+//in general, so whatever is left in the accumulator is flushed here, zero padded; a frame that ends exactly on a
+//byte boundary still gets its last byte written.
+void APRS::loadTrailingBits() {
+    packet_size = encoder.finish();
 }
 
-// Convert latitude from a float to a string
-void lonToStr(char * const s, const int size, float lon)
-{
-  char hemisphere = 'E';
-  if (lon < 0) {
-    lon = -lon;
-    hemisphere = 'W';
-  }
-  const int deg = (int) lon;
-  lon = (lon - (float) deg) * 60.0f;
-  const int min = (int) lon;
-  lon = (lon - (float) min) * 100.0f;
-  const int minTenths = (int) (lon + 0.5); // Round the tenths
-  snprintf(s, size, "%03d%02d.%02d%c", deg, min, minTenths, hemisphere);
-}
+void APRS::loadHDLCFlag() {
+    encoder.loadFlag();
+}
+
+int APRS::getPacketSize() {
+    return packet_size;
+}
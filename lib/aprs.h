@@ -4,56 +4,134 @@
 #include "dra818v.h"
 #include "Arduino.h"
 #include "afsk.h"
+#include "hdlc.h"
+#include "ax25.h"
+#include "ax25_stream.h"
+#include "fx25.h"
+#include "aprs_compressed.h"
+#include "aprs_mice.h"
+#include "aprs_payload.h"
 #include <SoftwareSerial.h>
 using namespace std;
 
-static const uint8_t HDLC_FLAG = 0x7E;
-static const int BUFFER_SIZE_MAX = 256; //bytes
-static const uint8_t BIT_STUFF_THRESHOLD = 5;
-
 class APRS
 {
 public:
     APRS(DRA818V* DRA, SSID* addr, uint8_t nSSIDs);
+    APRS(DRA818V* DRA, const AX25Header* prebuilt);
     void setSSIDs(SSID* addr, uint8_t numSSIDs);
+    void setHeader(const AX25Header* prebuilt);
+    //Channel of the radio's plan (DRA818V::setChannels) the next frames go out on. The transmitter retunes
+    //before keying up for them; frames for different channels never share a key-up.
+    void setChannel(uint8_t planChannel) { channel = planChannel; }
+    //Sends the following frames as FX.25 (fx25.h) with this many Reed-Solomon check bytes, in the smallest block
+    //that holds the stuffed frame. A frame too long for the largest block goes out as plain AX.25. Streamed
+    //frames are always plain AX.25.
+    void setFX25(FX25Check check) { fx25 = check; }
+    
+    //The send* calls encode the frame into a free txQueue slot, start the transmitter if it is idle and return
+    //without waiting for it. They return false, dropping the frame, when all TX_QUEUE_SLOTS are still queued or
+    //the stuffed frame would not fit a slot (BUFFER_SIZE_MAX bytes).
+    //"/DDHHMMzDDMM.mmN/DDDMM.mmWOCCC/SSS/A=nnnnnn" then the comment. lat/lon in 1e-7 degrees, altitude in
+    //meters, speed in knots; formatted with integer math (aprs_payload.h), no floating point or printf. Named
+    //apart from the float forms so calls with double or int arguments stay unambiguous.
+    bool sendPacketGPSFixed(const uint8_t dayOfMonth, const uint8_t hour, const uint8_t min,
+    const int32_t lat,
+    const int32_t lon,
+    const int32_t altitude,
+    const uint16_t heading,
+    const uint16_t speed,
+    const char * const comment);
     
-    void sendPacketGPS(const uint8_t dayOfMonth, const uint8_t hour, const uint8_t min,
+    //The float forms convert to the integer one once, rounding to nearest
+    bool sendPacketGPS(const uint8_t dayOfMonth, const uint8_t hour, const uint8_t min,
     const float lat,
     const float lon, // degrees
     const float altitude, // meters
     const uint16_t heading, // degrees
     const float speed,
-    String comment);
+    const char * const comment);
     
-    void sendPacketGPS(const uint8_t dayOfMonth, const uint8_t hour, const uint8_t min,
+    bool sendPacketGPS(const uint8_t dayOfMonth, const uint8_t hour, const uint8_t min,
     const float lat,
     const float lon, // degrees
     const float altitude, // meters
     const uint16_t heading, // degrees
     const float speed,
+    const String& comment);
+    
+    //Same report in the compressed format: "/DDHHMMz" and a 13 character base-91 position, course and speed
+    //instead of 26 characters of DDMM.mmN/DDDMM.mmW + CCC/SSS, then "/A=" altitude and the comment.
+    //lat/lon in 1e-7 degrees, altitude in meters, speed in knots; no floating point or printf on this path.
+    bool sendPacketCompressedFixed(const uint8_t dayOfMonth, const uint8_t hour, const uint8_t min,
+    const int32_t lat,
+    const int32_t lon,
+    const int32_t altitude,
+    const uint16_t heading,
+    const uint16_t speed,
     const char * const comment);
     
-    void sendPacketNoGPS(String data);
-    void sendPacketNoGPS(char* data);
+    bool sendPacketCompressed(const uint8_t dayOfMonth, const uint8_t hour, const uint8_t min,
+    const float lat,
+    const float lon, // degrees
+    const float altitude, // meters
+    const uint16_t heading, // degrees
+    const float speed,
+    const char * const comment);
     
+    //Mic-E report: the destination callsign is generated from the latitude for every packet, the rest of the
+    //path comes from the header. lat/lon in 1e-7 degrees, altitude in meters, speed in knots.
+    bool sendPacketMicE(const int32_t lat,
+    const int32_t lon,
+    const int32_t altitude,
+    const uint16_t heading,
+    const uint16_t speed,
+    const MicEMessage message,
+    const char * const comment);
+    
+    bool sendPacketNoGPS(const String& data);
+    bool sendPacketNoGPS(const char* data);
+    //Sends an information field built with APRSPayload and the aprs_put_* formatters, or any raw bytes
+    bool sendPayload(const APRSPayload& payload);
+    bool sendPayload(const uint8_t* info, int length);
+    //Sends a frame with a ready-made address field (raw AX.25 bytes, H bits included) instead of the cached
+    //header, e.g. a frame being digipeated.
+    bool sendFrame(const uint8_t* address, uint8_t addressLength, const uint8_t* info, int infoLength,
+    uint8_t pid = AX25_PID_NO_LAYER3);
+    
+    //Queues a frame with the cached header that is encoded while it is sent rather than into the slot, so the
+    //information field may be as long as AX.25 allows (AX25_MAX_INFO_LENGTH), whatever BUFFER_SIZE_MAX is.
+    //Nothing is copied: info, or the reader's data, and the header have to stay valid until the frame is out.
+    //False when every slot is queued or length is over AX25_MAX_INFO_LENGTH.
+    bool streamPacket(const uint8_t* info, int length);
+    //Same with the information field pulled from reader as the frame goes out, cut at AX25_MAX_INFO_LENGTH.
+    bool streamPacket(AX25InfoReader reader, void* context);
+
     int getPacketSize();
     void clearPacket();
 private:
+#ifdef APRS_HOST
+    friend class APRSBench; //host benchmarks time the private load* hot paths directly
+#endif
+    bool beginPacket();
+    bool queueStream(const AX25FrameSource& source);
+    bool endPacket();
+    void queuePacket();
     void loadHeader();
-    void loadData(uint8_t *data_buffer, uint8_t length);
+    void loadHeader(const uint8_t* destination);
+    void loadData(const uint8_t *data_buffer, int length);
     void loadFooter();
-    void loadTrailingBits(uint8_t bitIndex);
+    void loadTrailingBits();
     void loadByte(uint8_t byte);
-    void loadBit(uint8_t bit, bool bitStuff);
-    void loadString(String str);
-    void loadString(char* str);
     void loadHDLCFlag();
-    void update_crc(uint8_t bit);
     DRA818V* radio;
     uint8_t num_HDLC_Flags;
-    SSID* ssids;
-    uint8_t num_ssids;
+    uint8_t channel;
+    FX25Check fx25;
+    AX25Header headerCache;
+    const AX25Header* header;
     volatile uint8_t* packet_buffer;
     int packet_size;
+    HDLCEncoder encoder;
 };
-#endif // APRS_H
+#endif // APRS_H
@@ -0,0 +1,70 @@
+#include "aprs_compressed.h"
+
+static const uint8_t COMPRESSION_TYPE = 0x20 | 0x18 | 0x02; //current fix, RMC, software
+static const int SPEED_CODES = 90;
+
+//The speed code s stands for 1.08^s - 1 knots. Midpoints between neighbouring codes in hundredths of a knot,
+//built at compile time, turn the logarithm into a search.
+struct SpeedTable {
+    uint32_t midpoints[SPEED_CODES - 1];
+    constexpr SpeedTable() : midpoints() {
+        double knots = 0; //1.08^s - 1
+        for(int s = 0; s < SPEED_CODES - 1; s++) {
+            const double next = (knots + 1) * 1.08 - 1;
+            midpoints[s] = (uint32_t) ((knots + next) * 50 + 0.5);
+            knots = next;
+        }
+    }
+};
+static constexpr SpeedTable speedTable;
+
+static uint8_t speedCode(uint16_t knots) {
+    const uint32_t hundredths = (uint32_t) knots * 100;
+    uint8_t low = 0, high = SPEED_CODES - 1;
+    while(low < high) { //first code whose upper midpoint is above the speed
+        const uint8_t mid = (low + high) / 2;
+        if(speedTable.midpoints[mid] <= hundredths) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+//value * scale / 1e7, truncated as the spec's reference formulas do, and clamped to the 4 digit base-91 range
+static uint32_t scaled(int64_t value, uint32_t scale) {
+    int64_t out = value * scale / 10000000;
+    if(out < 0) out = 0;
+    if(out > 91L * 91 * 91 * 91 - 1) out = 91L * 91 * 91 * 91 - 1;
+    return (uint32_t) out;
+}
+
+void aprs_compress_position(char* out, int32_t latitude, int32_t longitude, char symbolTable, char symbol,
+    uint16_t course, uint16_t speedKnots) {
+    out[0] = symbolTable;
+    base91_encode(scaled(900000000LL - latitude, 380926), out + 1, 4); //380926 steps per degree from 90N
+    base91_encode(scaled(1800000000LL + longitude, 190463), out + 5, 4); //190463 steps per degree from 180W
+    out[9] = symbol;
+    out[10] = '!' + (course % 360 + 2) / 4 % 90; //4 degree steps, 0 = north or unknown
+    out[11] = '!' + speedCode(speedKnots);
+    out[12] = '!' + COMPRESSION_TYPE;
+}
+
+void aprs_format_altitude(char* out, int32_t meters) {
+    int32_t feet = (int32_t) (((int64_t) meters * 10000 + (meters < 0 ? -1524 : 1524)) / 3048);
+    out[0] = '/';
+    out[1] = 'A';
+    out[2] = '=';
+    char* digits = out + 3;
+    int count = 6;
+    if(feet < 0) {
+        *digits++ = '-'; //same layout as %06ld: the sign takes one of the six places
+        count--;
+        feet = -feet;
+    }
+    for(int i = count - 1; i >= 0; i--) {
+        digits[i] = '0' + feet % 10;
+        feet /= 10;
+    }
+}
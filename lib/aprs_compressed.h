@@ -0,0 +1,28 @@
+#ifndef APRS_COMPRESSED_H
+#define APRS_COMPRESSED_H
+#include <stdint.h>
+
+//Compressed position reports (APRS 1.0.1 chapter 9): latitude and longitude as 4 base-91 digits each,
+//course/speed in two more, 13 characters in all against 26 for the DDMM.mmN/DDDMM.mmW + CCC/SSS form,
+//and a resolution of about 0.3 m instead of 18 m. Everything here is integer arithmetic.
+
+static const int APRS_COMPRESSED_LENGTH = 13; //symbol table, YYYY, XXXX, symbol, cs, compression type
+static const int APRS_ALTITUDE_LENGTH = 9; //"/A=" and 6 digits
+
+//Writes digits base-91 digits of value, most significant first, as the characters '!' (0) to '{' (90)
+static inline void base91_encode(uint32_t value, char* out, uint8_t digits) {
+    for(int i = digits - 1; i >= 0; i--) {
+        out[i] = '!' + value % 91;
+        value /= 91;
+    }
+}
+
+//Fills out[APRS_COMPRESSED_LENGTH] (not terminated). latitude/longitude in 1e-7 degrees, course in degrees
+//(0 = unknown), speed in knots. The compression type says: current GPS fix, RMC source, software origin.
+void aprs_compress_position(char* out, int32_t latitude, int32_t longitude, char symbolTable, char symbol,
+    uint16_t course, uint16_t speedKnots);
+
+//Writes the "/A=nnnnnn" comment altitude for a height in meters (out[APRS_ALTITUDE_LENGTH], not terminated)
+void aprs_format_altitude(char* out, int32_t meters);
+
+#endif // APRS_COMPRESSED_H
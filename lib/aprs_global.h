@@ -4,7 +4,7 @@
 #include "Arduino.h"
 
 struct SSID {
-    char* address;
+    const char* address;
     uint8_t ssid_designator;
 };
 
@@ -12,7 +12,7 @@ const bool DEBUG = true;
 #define LED_PIN 13
 #define PTT_PIN 2
 #define MIC_PIN A14
-#define PWM_PIN A0
+#define PWM_PIN 3 //AFSK_SINK_PWM output, has to be a PWM capable pin on the board (checked for the Teensy 3.x in sink.h)
 #define AUDIO_PIN A8
 #define DRATX A9
 #define DRARX A8
@@ -30,4 +30,4 @@ static const float APRS_NA_FRX = 144.390; //receiving frequency in MHz
 #  define APRSSHARED_EXPORT Q_DECL_IMPORT
 #endif
 
-#endif // APRS_GLOBAL_H
+#endif // APRS_GLOBAL_H
@@ -0,0 +1,73 @@
+#include "aprs_mice.h"
+#include "aprs_compressed.h"
+
+static const int32_t MAX_LATITUDE = 90 * 6000; //hundredths of a minute
+static const int32_t MAX_LONGITUDE = 180 * 6000 - 1; //179 59.99: 180 itself has no encoding
+static const int32_t ALTITUDE_OFFSET = 10000;
+
+//|degrees| in 1e-7 as hundredths of a minute, rounded, so the DDMM.hh digits carry properly
+static int32_t hundredths(int32_t degrees, int32_t limit) {
+    const int64_t magnitude = degrees < 0 ? -(int64_t) degrees : degrees;
+    const int32_t out = (int32_t) ((magnitude * 6000 + 5000000) / 10000000);
+    return out < limit ? out : limit;
+}
+
+void aprs_mice_destination(uint8_t* address, int32_t latitude, int32_t longitude, MicEMessage message) {
+    const int32_t lat = hundredths(latitude, MAX_LATITUDE);
+    const int32_t lonDegrees = hundredths(longitude, MAX_LONGITUDE) / 6000;
+    const uint8_t digits[6] = {
+        (uint8_t) (lat / 60000), (uint8_t) (lat / 6000 % 10),
+        (uint8_t) (lat / 1000 % 6), (uint8_t) (lat / 100 % 10),
+        (uint8_t) (lat / 10 % 10), (uint8_t) (lat % 10)
+    };
+    //a set flag shifts the digit from '0'-'9' to 'P'-'Y'
+    const bool flags[6] = {
+        (message & 4) != 0, (message & 2) != 0, (message & 1) != 0,
+        latitude >= 0, //north
+        lonDegrees < 10 || lonDegrees >= 100, //longitude offset +100
+        longitude < 0 //west
+    };
+    for(int i = 0; i < 6; i++) {
+        address[i] = (uint8_t) ((flags[i] ? 'P' : '0') + digits[i]) << 1;
+    }
+    address[6] = '0' << 1;
+}
+
+void aprs_mice_info(uint8_t* out, int32_t longitude, uint16_t course, uint16_t speed, char symbolTable, char symbol) {
+    const int32_t lon = hundredths(longitude, MAX_LONGITUDE);
+    const int32_t degrees = lon / 6000;
+    const int32_t minutes = lon / 100 % 60;
+    if(speed > 799) {
+        speed = 799;
+    }
+    course %= 360;
+    out[0] = '`'; //current GPS data
+    //the receiver adds 100 when the destination's offset flag is set and folds 180-199 back to 0-109
+    if(degrees < 10) {
+        out[1] = 28 + degrees + 90;
+    } else if(degrees < 100) {
+        out[1] = 28 + degrees;
+    } else if(degrees < 110) {
+        out[1] = 28 + degrees - 20;
+    } else {
+        out[1] = 28 + degrees - 100;
+    }
+    out[2] = 28 + (minutes < 10 ? minutes + 60 : minutes);
+    out[3] = 28 + lon % 100;
+    //SP: tens of knots, 0-199 knots moved up by 80 out of the control characters
+    out[4] = 28 + speed / 10 + (speed < 200 ? 80 : 0);
+    //DC: units of knots and hundreds of degrees; the receiver takes course modulo 400, which keeps this printable too
+    const uint8_t dc = speed % 10 * 10 + course / 100;
+    out[5] = 28 + (dc < 4 ? dc + 4 : dc);
+    out[6] = 28 + course % 100;
+    out[7] = symbol;
+    out[8] = symbolTable;
+}
+
+void aprs_mice_altitude(uint8_t* out, int32_t meters) {
+    int32_t value = meters + ALTITUDE_OFFSET;
+    if(value < 0) value = 0;
+    if(value > 91 * 91 * 91 - 1) value = 91 * 91 * 91 - 1;
+    base91_encode(value, (char*) out, 3);
+    out[3] = '}';
+}
@@ -0,0 +1,34 @@
+#ifndef APRS_MICE_H
+#define APRS_MICE_H
+#include <stdint.h>
+
+//Mic-E position reports (APRS 1.0.1 chapter 10). The latitude digits, N/S, W/E, the longitude offset and a 3 bit
+//message code ride in the AX.25 destination callsign, so the information field only needs longitude, speed,
+//course and the symbol: 9 bytes, plus 4 for altitude, against 26 or more for the plain format.
+
+//The standard message codes, in the order of their A/B/C bits (Emergency = 000, Off Duty = 111)
+enum MicEMessage {
+    MICE_EMERGENCY,
+    MICE_PRIORITY,
+    MICE_SPECIAL,
+    MICE_COMMITTED,
+    MICE_RETURNING,
+    MICE_IN_SERVICE,
+    MICE_EN_ROUTE,
+    MICE_OFF_DUTY
+};
+
+static const int MICE_INFO_LENGTH = 9; //data type, 3 longitude, 3 speed/course, symbol, symbol table
+static const int MICE_ALTITUDE_LENGTH = 4; //3 base-91 digits and '}'
+
+//Writes the 7 raw address bytes (shifted callsign, SSID 0, extension bit clear) of the destination for a
+//latitude in 1e-7 degrees. The longitude only contributes its hemisphere and offset flag.
+void aprs_mice_destination(uint8_t* address, int32_t latitude, int32_t longitude, MicEMessage message);
+
+//Writes the MICE_INFO_LENGTH bytes that start the information field. Course in degrees, speed in knots (up to 799).
+void aprs_mice_info(uint8_t* out, int32_t longitude, uint16_t course, uint16_t speed, char symbolTable, char symbol);
+
+//Writes the MICE_ALTITUDE_LENGTH byte altitude extension, meters relative to 10 km below sea level
+void aprs_mice_altitude(uint8_t* out, int32_t meters);
+
+#endif // APRS_MICE_H
@@ -0,0 +1,241 @@
+#include "aprs_parse.h"
+
+static const int UNCOMPRESSED_POSITION_LENGTH = 19; //DDMM.mmN/DDDMM.mmW$
+static const int COMPRESSED_POSITION_LENGTH = 13; ///YYYYXXXX$csT
+static const int TIMESTAMP_LENGTH = 7;
+
+static AX25Span span(const uint8_t* data, int length) {
+    AX25Span out = {data, (uint16_t) (length > 0 ? length : 0)};
+    return out;
+}
+
+static bool isDigit(uint8_t c) {
+    return c >= '0' && c <= '9';
+}
+
+//Fixed width decimal field; a space (position ambiguity) counts as 0. -1 if a character is neither.
+static int32_t digits(const uint8_t* text, int count) {
+    int32_t value = 0;
+    for(int i = 0; i < count; i++) {
+        if(text[i] == ' ') {
+            value *= 10;
+        } else if(isDigit(text[i])) {
+            value = value * 10 + text[i] - '0';
+        } else {
+            return -1;
+        }
+    }
+    return value;
+}
+
+//Degrees + minutes with two decimals ("DDMM.mm" / "DDDMM.mm") to 1e-7 degrees
+static int32_t coordinate(const uint8_t* text, int degreeDigits, uint8_t hemisphere, uint8_t negative) {
+    const int32_t degrees = digits(text, degreeDigits);
+    const int32_t minutes = digits(text + degreeDigits, 2);
+    const int32_t hundredths = digits(text + degreeDigits + 3, 2);
+    if(degrees < 0 || minutes < 0 || minutes > 59 || hundredths < 0 || text[degreeDigits + 2] != '.') {
+        return INT32_MIN;
+    }
+    //1e7 degrees / 6000 hundredths of a minute = 5000/3, rounded
+    const int32_t value = degrees * 10000000 + (int32_t) (((minutes * 100 + hundredths) * 10000LL + 3) / 6);
+    return hemisphere == negative ? -value : value;
+}
+
+static int32_t base91(const uint8_t* text) {
+    int32_t value = 0;
+    for(int i = 0; i < 4; i++) {
+        if(text[i] < 33 || text[i] > 33 + 90) {
+            return -1;
+        }
+        value = value * 91 + text[i] - 33;
+    }
+    return value;
+}
+
+bool aprs_parse_position(AX25Span info, APRSPosition* out) {
+    if(info.length < 1) {
+        return false;
+    }
+    const uint8_t type = info.data[0];
+    const uint8_t* p = info.data + 1;
+    int remaining = info.length - 1;
+    out->timestamp = span(p, 0);
+    if(type == '/' || type == '@') {
+        if(remaining < TIMESTAMP_LENGTH) {
+            return false;
+        }
+        out->timestamp = span(p, TIMESTAMP_LENGTH);
+        p += TIMESTAMP_LENGTH;
+        remaining -= TIMESTAMP_LENGTH;
+    } else if(type != '!' && type != '=') {
+        return false;
+    }
+    out->messaging = type == '=' || type == '@';
+    if(remaining >= 1 && (isDigit(p[0]) || p[0] == ' ')) {
+        if(remaining < UNCOMPRESSED_POSITION_LENGTH) {
+            return false;
+        }
+        const int32_t latitude = coordinate(p, 2, p[7], 'S');
+        const int32_t longitude = coordinate(p + 9, 3, p[17], 'W');
+        if(latitude == INT32_MIN || longitude == INT32_MIN || (p[7] != 'N' && p[7] != 'S') || (p[17] != 'E' && p[17] != 'W')) {
+            return false;
+        }
+        out->latitude = latitude;
+        out->longitude = longitude;
+        out->symbolTable = p[8];
+        out->symbol = p[18];
+        out->compressed = false;
+        out->comment = span(p + UNCOMPRESSED_POSITION_LENGTH, remaining - UNCOMPRESSED_POSITION_LENGTH);
+        return true;
+    }
+    if(remaining < COMPRESSED_POSITION_LENGTH) {
+        return false;
+    }
+    const int32_t y = base91(p + 1);
+    const int32_t x = base91(p + 5);
+    if(y < 0 || x < 0) {
+        return false;
+    }
+    //lat = 90 - y / 380926, lon = -180 + x / 190463 degrees
+    out->latitude = 900000000 - (int32_t) (((int64_t) y * 10000000 + 190463) / 380926);
+    out->longitude = -1800000000 + (int32_t) (((int64_t) x * 10000000 + 95231) / 190463);
+    out->symbolTable = p[0];
+    out->symbol = p[9];
+    out->compressed = true;
+    out->comment = span(p + COMPRESSED_POSITION_LENGTH, remaining - COMPRESSED_POSITION_LENGTH);
+    return true;
+}
+
+bool aprs_parse_status(AX25Span info, APRSStatus* out) {
+    if(info.length < 1 || info.data[0] != '>') {
+        return false;
+    }
+    out->text = span(info.data + 1, info.length - 1);
+    return true;
+}
+
+//Optionally signed decimal number up to the next ',' in thousandths. Moves p past the comma.
+static bool telemetryValue(const uint8_t*& p, const uint8_t* end, int32_t* out) {
+    bool negative = false;
+    int32_t whole = 0;
+    int32_t thousandths = 0;
+    int scale = 100;
+    bool any = false;
+    if(p < end && *p == '-') {
+        negative = true;
+        p++;
+    }
+    for(; p < end && isDigit(*p); p++) {
+        whole = whole * 10 + *p - '0';
+        any = true;
+        if(whole > 999999) return false;
+    }
+    if(p < end && *p == '.') {
+        for(p++; p < end && isDigit(*p); p++) {
+            thousandths += (*p - '0') * scale;
+            scale /= 10;
+            any = true;
+        }
+    }
+    if(!any || p >= end || *p != ',') {
+        return false;
+    }
+    p++;
+    *out = (negative ? -1 : 1) * (whole * 1000 + thousandths);
+    return true;
+}
+
+bool aprs_parse_telemetry(AX25Span info, APRSTelemetry* out) {
+    const uint8_t* end = info.data + info.length;
+    if(info.length < 2 || info.data[0] != 'T' || info.data[1] != '#') {
+        return false;
+    }
+    const uint8_t* p = info.data + 2;
+    int32_t sequence = 0;
+    for(; p < end && isDigit(*p); p++) {
+        sequence = sequence * 10 + *p - '0';
+        if(sequence > 65535) return false;
+    }
+    if(p >= end || *p != ',') {
+        return false;
+    }
+    out->sequence = sequence;
+    p++;
+    for(int i = 0; i < APRS_TELEMETRY_CHANNELS; i++) {
+        if(!telemetryValue(p, end, &out->analog[i])) {
+            return false;
+        }
+    }
+    out->digital = 0;
+    for(int i = 0; i < 8; i++, p++) {
+        if(p >= end || (*p != '0' && *p != '1')) {
+            return false;
+        }
+        out->digital = (out->digital << 1) | (*p - '0');
+    }
+    out->comment = span(p, end - p);
+    return true;
+}
+
+bool aprs_parse_message(AX25Span info, APRSMessage* out) {
+    if(info.length < APRS_ADDRESSEE_LENGTH + 2 || info.data[0] != ':' || info.data[APRS_ADDRESSEE_LENGTH + 1] != ':') {
+        return false;
+    }
+    int addressee = APRS_ADDRESSEE_LENGTH;
+    while(addressee > 0 && info.data[addressee] == ' ') {
+        addressee--;
+    }
+    out->addressee = span(info.data + 1, addressee);
+    const uint8_t* text = info.data + APRS_ADDRESSEE_LENGTH + 2;
+    const uint8_t* end = info.data + info.length;
+    const uint8_t* brace = text;
+    while(brace < end && *brace != '{') {
+        brace++;
+    }
+    out->text = span(text, brace - text);
+    out->id = brace < end ? span(brace + 1, end - brace - 1) : span(end, 0);
+    return true;
+}
+
+APRSDataType aprs_dispatch(const AX25Frame& frame, APRSHandler& handler) {
+    const AX25Span info = frame.info();
+    if(info.length > 0) {
+        switch(info.data[0]) {
+        case '!':
+        case '=':
+        case '/':
+        case '@': {
+            APRSPosition position;
+            if(aprs_parse_position(info, &position)) {
+                handler.position(frame, position);
+                return APRS_TYPE_POSITION;
+            }
+            break;
+        }
+        case '>': {
+            APRSStatus status;
+            aprs_parse_status(info, &status);
+            handler.status(frame, status);
+            return APRS_TYPE_STATUS;
+        }
+        case 'T': {
+            APRSTelemetry telemetry;
+            if(aprs_parse_telemetry(info, &telemetry)) {
+                handler.telemetry(frame, telemetry);
+                return APRS_TYPE_TELEMETRY;
+            }
+            break;
+        }
+        case ':': {
+            APRSMessage message;
+            if(aprs_parse_message(info, &message)) {
+                handler.message(frame, message);
+                return APRS_TYPE_MESSAGE;
+            }
+            break;
+        }
+        }
+    }
+    handler.other(frame);
+    return APRS_TYPE_OTHER;
+}
@@ -0,0 +1,69 @@
+#ifndef APRS_PARSE_H
+#define APRS_PARSE_H
+#include <stdint.h>
+#include "ax25.h"
+
+//APRS payload views over the information field of a received frame (see AX25Frame). Like the frame views they
+//point into the caller's buffer, and coordinates are kept as integers so no float code is pulled in.
+
+enum APRSDataType {
+    APRS_TYPE_OTHER,
+    APRS_TYPE_POSITION,
+    APRS_TYPE_STATUS,
+    APRS_TYPE_TELEMETRY,
+    APRS_TYPE_MESSAGE
+};
+
+static const int APRS_TELEMETRY_CHANNELS = 5;
+static const uint8_t APRS_ADDRESSEE_LENGTH = 9;
+
+struct APRSPosition {
+    int32_t latitude; //1e-7 degrees, north positive
+    int32_t longitude; //1e-7 degrees, east positive
+    char symbolTable;
+    char symbol;
+    bool compressed;
+    bool messaging; //the station accepts messages ('=' and '@' reports)
+    AX25Span timestamp; //the 7 timestamp characters, empty for reports without one
+    AX25Span comment; //everything after the position, course/speed extension included
+};
+
+struct APRSStatus {
+    AX25Span text;
+};
+
+struct APRSTelemetry {
+    uint16_t sequence;
+    int32_t analog[APRS_TELEMETRY_CHANNELS]; //thousandths, so the decimal values APRS 1.2 allows survive
+    uint8_t digital; //B1 in the most significant bit
+    AX25Span comment;
+};
+
+struct APRSMessage {
+    AX25Span addressee; //trailing padding removed
+    AX25Span text;
+    AX25Span id; //the message number after '{', empty when there is none
+};
+
+//Payload parsers. They return false when the information field is not of that type or is malformed.
+bool aprs_parse_position(AX25Span info, APRSPosition* out);
+bool aprs_parse_status(AX25Span info, APRSStatus* out);
+bool aprs_parse_telemetry(AX25Span info, APRSTelemetry* out);
+bool aprs_parse_message(AX25Span info, APRSMessage* out);
+
+//Override the payload types of interest; frames that are none of them, or fail to parse, go to other()
+class APRSHandler
+{
+public:
+    virtual ~APRSHandler() {}
+    virtual void position(const AX25Frame& frame, const APRSPosition& position) { other(frame); }
+    virtual void status(const AX25Frame& frame, const APRSStatus& status) { other(frame); }
+    virtual void telemetry(const AX25Frame& frame, const APRSTelemetry& telemetry) { other(frame); }
+    virtual void message(const AX25Frame& frame, const APRSMessage& message) { other(frame); }
+    virtual void other(const AX25Frame& frame) {}
+};
+
+//Picks the parser from the data type identifier (the first information byte) and calls the matching handler
+APRSDataType aprs_dispatch(const AX25Frame& frame, APRSHandler& handler);
+
+#endif // APRS_PARSE_H
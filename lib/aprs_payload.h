@@ -0,0 +1,126 @@
+#ifndef APRS_PAYLOAD_H
+#define APRS_PAYLOAD_H
+#include <stdint.h>
+#include "aprs_compressed.h"
+#include "ax25_stream.h"
+
+//Integer formatters for APRS information fields, no floating point, printf or heap. Each one appends to any
+//Out with a put(char) method: an APRSPayload to build a field ahead of time, or the HDLCEncoder itself, which
+//stuffs every byte straight into the frame. Positions are in 1e-7 degrees like the rest of the library.
+
+static const int APRS_PAYLOAD_MAX = AX25_MAX_INFO_LENGTH;
+
+//An information field built in place: fixed inline storage, nothing allocated. Bytes past APRS_PAYLOAD_MAX are
+//dropped and flagged.
+class APRSPayload
+{
+public:
+    APRSPayload() : size(0), truncated(false) {}
+    inline void put(char c) {
+        if(size < APRS_PAYLOAD_MAX) {
+            buffer[size++] = c;
+        } else {
+            truncated = true;
+        }
+    }
+    void clear() { size = 0; truncated = false; }
+    const uint8_t* data() const { return (const uint8_t*) buffer; }
+    int length() const { return size; }
+    bool overflowed() const { return truncated; }
+private:
+    char buffer[APRS_PAYLOAD_MAX];
+    uint16_t size;
+    bool truncated;
+};
+
+template <class Out>
+static inline void aprs_put_data(Out& out, const void* data, int length) {
+    const char* bytes = (const char*) data;
+    for(int i = 0; i < length; i++) {
+        out.put(bytes[i]);
+    }
+}
+
+template <class Out>
+static inline void aprs_put_string(Out& out, const char* text) {
+    for(; *text; text++) {
+        out.put(*text);
+    }
+}
+
+//value as exactly width decimal digits, zero padded; higher digits are cut off
+template <class Out>
+static inline void aprs_put_digits(Out& out, uint32_t value, uint8_t width) {
+    char digits[10];
+    for(int i = width - 1; i >= 0; i--) {
+        digits[i] = '0' + value % 10;
+        value /= 10;
+    }
+    aprs_put_data(out, digits, width);
+}
+
+//"DDHHMMz", day of month and UTC time
+template <class Out>
+static inline void aprs_put_timestamp(Out& out, uint8_t dayOfMonth, uint8_t hour, uint8_t minute) {
+    aprs_put_digits(out, dayOfMonth, 2);
+    aprs_put_digits(out, hour, 2);
+    aprs_put_digits(out, minute, 2);
+    out.put('z');
+}
+
+//degrees (width digits), minutes and hundredths of a minute rounded to nearest, then the hemisphere. The
+//rounding carries into the degrees, so a minute value never reads 60.00.
+template <class Out>
+static inline void aprs_put_angle(Out& out, int32_t angle, uint8_t width, char positive, char negative) {
+    const uint32_t magnitude = angle < 0 ? -(uint32_t) angle : angle;
+    uint32_t degrees = magnitude / 10000000;
+    uint32_t hundredths = (magnitude % 10000000 * 6 + 5000) / 10000; //of a minute
+    if(hundredths == 6000) {
+        degrees++;
+        hundredths = 0;
+    }
+    aprs_put_digits(out, degrees, width);
+    aprs_put_digits(out, hundredths / 100, 2);
+    out.put('.');
+    aprs_put_digits(out, hundredths % 100, 2);
+    out.put(angle < 0 ? negative : positive);
+}
+
+//"DDMM.mmN"
+template <class Out>
+static inline void aprs_put_latitude(Out& out, int32_t latitude) {
+    aprs_put_angle(out, latitude, 2, 'N', 'S');
+}
+
+//"DDDMM.mmW"
+template <class Out>
+static inline void aprs_put_longitude(Out& out, int32_t longitude) {
+    aprs_put_angle(out, longitude, 3, 'E', 'W');
+}
+
+//"DDMM.mmN/DDDMM.mmWO": latitude, symbol table, longitude, symbol
+template <class Out>
+static inline void aprs_put_position(Out& out, int32_t latitude, int32_t longitude, char symbolTable, char symbol) {
+    aprs_put_latitude(out, latitude);
+    out.put(symbolTable);
+    aprs_put_longitude(out, longitude);
+    out.put(symbol);
+}
+
+//"CCC/SSS", course in degrees and speed in knots
+template <class Out>
+static inline void aprs_put_course_speed(Out& out, uint16_t course, uint16_t speed) {
+    aprs_put_digits(out, course, 3);
+    out.put('/');
+    aprs_put_digits(out, speed, 3);
+}
+
+//"/A=nnnnnn", the comment altitude in feet for a height in meters
+template <class Out>
+static inline void aprs_put_altitude(Out& out, int32_t meters) {
+    char altitude[APRS_ALTITUDE_LENGTH];
+    aprs_format_altitude(altitude, meters);
+    aprs_put_data(out, altitude, APRS_ALTITUDE_LENGTH);
+}
+
+#endif // APRS_PAYLOAD_H
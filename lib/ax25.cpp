@@ -0,0 +1,66 @@
+#include "ax25.h"
+
+uint8_t AX25Address::callsign(char* out) const {
+    uint8_t length = 0;
+    while(length < AX25_CALLSIGN_LENGTH && raw[length] != (' ' << 1)) {
+        out[length] = raw[length] >> 1;
+        length++;
+    }
+    out[length] = 0;
+    return length;
+}
+
+bool AX25Address::matches(const SSID& ssid) const {
+    int i = 0;
+    for(; i < AX25_CALLSIGN_LENGTH && ssid.address[i]; i++) {
+        if(raw[i] != (uint8_t) (ssid.address[i] << 1)) {
+            return false;
+        }
+    }
+    for(; i < AX25_CALLSIGN_LENGTH; i++) {
+        if(raw[i] != (' ' << 1)) {
+            return false;
+        }
+    }
+    return AX25Address::ssid() == ssid.ssid_designator;
+}
+
+SSID AX25Address::toSSID(char* storage) const {
+    AX25Address::callsign(storage);
+    SSID out = {storage, AX25Address::ssid()};
+    return out;
+}
+
+bool AX25Frame::parse(const uint8_t* frame, int frameLength) {
+    data = 0;
+    length = 0;
+    addresses = 0;
+    uint8_t count = 0;
+    //the address field ends at the first address with the extension bit set
+    while(count < AX25_MAX_ADDRESSES && (count + 1) * AX25_ADDRESS_LENGTH <= frameLength) {
+        if(frame[(count++ + 1) * AX25_ADDRESS_LENGTH - 1] & 1) {
+            break;
+        }
+    }
+    const int header = count * AX25_ADDRESS_LENGTH;
+    if(count < 2 || !(frame[header - 1] & 1) || header + 2 > frameLength) {
+        return false; //no end of the address field, or no room for control and PID
+    }
+    if((frame[header] & ~0x10) != AX25_CONTROL_UI) {
+        return false; //not a UI frame (the P/F bit may be set)
+    }
+    data = frame;
+    length = frameLength;
+    addresses = count;
+    return true;
+}
+
+AX25Span AX25Frame::info() const {
+    if(!data) {
+        AX25Span none = {0, 0};
+        return none;
+    }
+    const uint16_t start = addresses * AX25_ADDRESS_LENGTH + 2;
+    AX25Span span = {data + start, (uint16_t) (length - start)};
+    return span;
+}
@@ -0,0 +1,158 @@
+#ifndef AX25_H
+#define AX25_H
+#include <stdint.h>
+#include "aprs_global.h"
+#include "hdlc.h"
+
+static const uint8_t AX25_MAX_ADDRESSES = 10; //destination, source and up to 8 digipeaters
+static const uint8_t AX25_ADDRESS_LENGTH = 7; //6 callsign characters and the SSID byte
+static const uint8_t AX25_CALLSIGN_LENGTH = 6;
+static const uint8_t AX25_CONTROL_UI = 0x03; //APRS-UI frame
+static const uint8_t AX25_PID_NO_LAYER3 = 0xF0;
+static const uint8_t AX25_MAX_HEADER_FLAGS = 4;
+static const int AX25_HEADER_CACHE_BYTES = 92; //stuffed flags + address field + control + PID, worst case
+
+//The part of a UI frame that only changes with the path: opening flags, address field, control and PID,
+//already bit stuffed, plus the encoder state at its end so a frame can carry on with its information field.
+//ax25_header() is constexpr, so a fixed path can be built at compile time and kept in flash.
+struct AX25Header {
+    uint8_t bits[AX25_HEADER_CACHE_BYTES]; //complete bytes of the stuffed bitstream (state.bytes of them)
+    HDLCState state;
+    uint8_t address[AX25_MAX_ADDRESSES * AX25_ADDRESS_LENGTH]; //the unstuffed address field
+    uint8_t addressLength;
+    uint8_t flags; //opening flags in front of the address field
+    constexpr AX25Header() : bits(), state(), address(), addressLength(0), flags(0) {}
+};
+
+//Bit-at-a-time stuffing for the header builder; it runs once per path (or at compile time), never per packet
+struct AX25HeaderWriter {
+    AX25Header header;
+    int size;
+    uint8_t ones;
+    uint16_t crc;
+
+    constexpr AX25HeaderWriter() : header(), size(0), ones(0), crc(CRC16_INIT) {}
+
+    constexpr void bit(int b) {
+        if(b) {
+            header.bits[size / 8] |= 0x80 >> (size % 8);
+        }
+        size++;
+    }
+
+    constexpr void flag() {
+        for(int i = 0; i < 8; i++) {
+            bit((HDLC_FLAG >> i) & 1);
+        }
+        ones = 0;
+    }
+
+    constexpr void byte(uint8_t value) {
+        for(int i = 0; i < 8; i++) {
+            const int b = (value >> i) & 1;
+            crc = crc16_update_bit(crc, b);
+            bit(b);
+            ones = b ? ones + 1 : 0;
+            if(ones == BIT_STUFF_THRESHOLD) {
+                bit(0);
+                ones = 0;
+            }
+        }
+    }
+
+    constexpr void addressByte(uint8_t value) {
+        header.address[header.addressLength++] = value;
+        byte(value);
+    }
+
+    constexpr AX25Header finish() {
+        header.state.bytes = size / 8;
+        header.state.pendingBits = size % 8;
+        header.state.pending = header.state.pendingBits ? header.bits[size / 8] >> (8 - header.state.pendingBits) : 0;
+        header.state.ones = ones;
+        header.state.crc = crc;
+        return header;
+    }
+};
+
+//Encodes the header for a path. Callsigns longer than 6 characters are cut short, extra addresses and
+//opening flags beyond AX25_MAX_HEADER_FLAGS are ignored.
+constexpr AX25Header ax25_header(const SSID* ssids, uint8_t count, uint8_t flags = N_HDLC_FLAGS) {
+    AX25HeaderWriter writer;
+    if(count > AX25_MAX_ADDRESSES) {
+        count = AX25_MAX_ADDRESSES;
+    }
+    if(flags > AX25_MAX_HEADER_FLAGS) {
+        flags = AX25_MAX_HEADER_FLAGS;
+    }
+    for(int i = 0; i < flags; i++) {
+        writer.flag();
+    }
+    writer.header.flags = flags;
+    for(int addr = 0; addr < count; addr++) {
+        // Callsign, space padded
+        int j = 0;
+        for(; j < AX25_CALLSIGN_LENGTH && ssids[addr].address[j]; j++) {
+            writer.addressByte(ssids[addr].address[j] << 1);
+        }
+        for(; j < AX25_CALLSIGN_LENGTH; j++) {
+            writer.addressByte(' ' << 1);
+        }
+        // SSID. Termination signaled with last bit = 1
+        writer.addressByte(('0' + ssids[addr].ssid_designator) << 1 | (addr == count - 1 ? 1 : 0));
+    }
+    writer.byte(AX25_CONTROL_UI);
+    writer.byte(AX25_PID_NO_LAYER3);
+    return writer.finish();
+}
+
+template <int N>
+constexpr AX25Header ax25_header(const SSID (&ssids)[N], uint8_t flags = N_HDLC_FLAGS) {
+    return ax25_header(ssids, N, flags);
+}
+
+//Receive side: views into a frame the caller owns (address field to info, no FCS), e.g. AFSKDemodulator::frame().
+//Nothing is copied, so a view is only valid while that buffer is.
+
+//One 7-byte address: callsign shifted left by one, then the SSID byte (H bit, reserved bits, SSID, last flag)
+class AX25Address
+{
+public:
+    AX25Address(const uint8_t* raw = 0) : raw(raw) {}
+    const uint8_t* bytes() const { return raw; }
+    uint8_t callsign(char* out) const; //copies the callsign without padding into out[AX25_CALLSIGN_LENGTH + 1]
+    uint8_t ssid() const { return (raw[AX25_CALLSIGN_LENGTH] >> 1) & 0x0F; }
+    bool repeated() const { return raw[AX25_CALLSIGN_LENGTH] & 0x80; } //H bit: a digipeater has sent it on
+    bool last() const { return raw[AX25_CALLSIGN_LENGTH] & 1; }
+    bool matches(const SSID& ssid) const; //same callsign and SSID, ignoring the H bit
+    SSID toSSID(char* storage) const; //storage holds the callsign, AX25_CALLSIGN_LENGTH + 1 bytes
+private:
+    const uint8_t* raw;
+};
+
+struct AX25Span {
+    const uint8_t* data;
+    uint16_t length;
+};
+
+class AX25Frame
+{
+public:
+    AX25Frame() : data(0), length(0), addresses(0) {}
+    //Checks the address field and that the frame is UI; false leaves the view empty
+    bool parse(const uint8_t* frame, int frameLength);
+    AX25Address destination() const { return AX25Address(data); }
+    AX25Address source() const { return AX25Address(data + AX25_ADDRESS_LENGTH); }
+    uint8_t digipeaters() const { return addresses - 2; }
+    AX25Address digipeater(uint8_t i) const { return AX25Address(data + (i + 2) * AX25_ADDRESS_LENGTH); }
+    uint8_t control() const { return data[addresses * AX25_ADDRESS_LENGTH]; }
+    uint8_t pid() const { return data[addresses * AX25_ADDRESS_LENGTH + 1]; }
+    AX25Span info() const;
+    AX25Span bytes() const { AX25Span span = {data, length}; return span; }
+private:
+    const uint8_t* data;
+    uint16_t length;
+    uint8_t addresses;
+};
+
+#endif // AX25_H
@@ -0,0 +1,76 @@
+#include "ax25_stream.h"
+#include <string.h>
+
+//The most one step() adds to the encoder: the FCS, two bytes with up to two stuffed zeros each
+static const int MAX_STEP_BITS = 20;
+
+void AX25Stream::begin(const AX25FrameSource& frame) {
+    source = frame;
+    phase = AX25_STREAM_HEADER;
+    position = 0;
+    readLength = 0;
+    readPosition = 0;
+}
+
+int AX25Stream::next(uint8_t* chunk) {
+    if(phase == AX25_STREAM_DONE) {
+        return 0;
+    }
+    if(phase == AX25_STREAM_HEADER) {
+        const int left = source.header->state.bytes - position;
+        if(left > 0) {
+            const int count = left < AX25_STREAM_CHUNK_BYTES ? left : AX25_STREAM_CHUNK_BYTES;
+            memcpy(chunk, source.header->bits + position, count);
+            position += count;
+            return count * 8;
+        }
+        HDLCState state = source.header->state;
+        state.bytes = 0; //the complete header bytes are out already, carry on from its pending bits
+        encoder.resume(chunk, AX25_STREAM_CHUNK_BYTES, state);
+        phase = AX25_STREAM_INFO;
+        position = 0;
+    } else {
+        encoder.redirect(chunk, AX25_STREAM_CHUNK_BYTES);
+    }
+    while(phase != AX25_STREAM_END && encoder.bits() <= AX25_STREAM_CHUNK_BYTES * 8 - MAX_STEP_BITS) {
+        step();
+    }
+    if(phase == AX25_STREAM_END) {
+        phase = AX25_STREAM_DONE;
+        return encoder.finish(); //at most a chunk: the loop stopped with room for a whole step
+    }
+    return encoder.bytesWritten() * 8; //whole words only, the rest stays in the accumulator for the next chunk
+}
+
+void AX25Stream::step() {
+    switch(phase) {
+    case AX25_STREAM_INFO:
+        if(source.reader) {
+            if(readPosition == readLength) {
+                const int room = AX25_MAX_INFO_LENGTH - position;
+                readLength = room > 0 ? source.reader(source.context, readBuffer,
+                                                      room < AX25_STREAM_READ_BYTES ? room : AX25_STREAM_READ_BYTES) : 0;
+                readPosition = 0;
+                if(readLength == 0) {
+                    phase = AX25_STREAM_FCS;
+                    return;
+                }
+            }
+            encoder.loadByte(readBuffer[readPosition++]);
+            position++;
+        } else if(position < source.infoLength) {
+            encoder.loadByte(source.info[position++]);
+        } else {
+            phase = AX25_STREAM_FCS;
+        }
+        return;
+    case AX25_STREAM_FCS:
+        encoder.loadFCS();
+        phase = AX25_STREAM_CLOSE;
+        return;
+    case AX25_STREAM_CLOSE:
+        encoder.loadFlag();
+        phase = AX25_STREAM_END;
+        return;
+    }
+}
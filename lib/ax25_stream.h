@@ -0,0 +1,59 @@
+#ifndef AX25_STREAM_H
+#define AX25_STREAM_H
+#include <stdint.h>
+#include "ax25.h"
+#include "hdlc.h"
+
+static const int AX25_MAX_INFO_LENGTH = 256; //the AX.25 limit on the information field
+static const int AX25_STREAM_CHUNK_BYTES = 8; //stuffed bitstream handed to the modulator per next()
+static const int AX25_STREAM_READ_BYTES = 16; //information bytes fetched from a reader at a time
+
+//Supplies the information field of a streamed frame: copies up to capacity of the next bytes into out and
+//returns how many, 0 at the end. It is called while the frame is on the air, from the sample interrupt in the
+//DIRECT and BLOCK pipelines, so it has to be quick and must not block.
+typedef int (*AX25InfoReader)(void* context, uint8_t* out, int capacity);
+
+//A UI frame encoded while it is sent: the cached header (opening flags, address field, control, PID), the
+//information field from a span or, when reader is set, a reader, then the FCS and a closing flag. The header
+//and the information bytes are read as transmission goes along and have to stay valid until then.
+struct AX25FrameSource {
+    const AX25Header* header;
+    const uint8_t* info;
+    int infoLength;
+    AX25InfoReader reader;
+    void* context;
+};
+
+//Generates the stuffed bitstream of an AX25FrameSource lazily, a chunk at a time, so the memory used does not
+//depend on the frame length and the longest AX.25 frame (AX25_MAX_INFO_LENGTH bytes of information) needs no
+//frame buffer. The header is already stuffed and is copied out as it is; everything after it goes through the
+//HDLCEncoder tables, carrying the accumulator from one chunk to the next.
+class AX25Stream
+{
+public:
+    AX25Stream() : source(), phase(AX25_STREAM_DONE), position(0), readLength(0), readPosition(0) {}
+    void begin(const AX25FrameSource& frame);
+    //Writes the next part of the bitstream into chunk (AX25_STREAM_CHUNK_BYTES), packed most significant bit
+    //first in transmit order like a TxFrame, and returns its length in bits; 0 once the closing flag is out.
+    int next(uint8_t* chunk);
+    bool done() const { return phase == AX25_STREAM_DONE; }
+private:
+    enum Phase {
+        AX25_STREAM_HEADER,
+        AX25_STREAM_INFO,
+        AX25_STREAM_FCS,
+        AX25_STREAM_CLOSE,
+        AX25_STREAM_END, //the closing flag is in the encoder, not yet written out
+        AX25_STREAM_DONE
+    };
+    void step();
+    AX25FrameSource source;
+    HDLCEncoder encoder;
+    uint8_t phase;
+    int position; //header bytes copied out, then information bytes encoded
+    uint8_t readBuffer[AX25_STREAM_READ_BYTES];
+    uint8_t readLength;
+    uint8_t readPosition;
+};
+
+#endif // AX25_STREAM_H
@@ -0,0 +1,7 @@
+#include "crc16.h"
+
+constexpr CRC16Table crc16_table;
+
+static_assert(crc16_table.entries[0x01] == 0x1189, "CRC-16/X.25 table generated incorrectly");
+static_assert(crc16_table.entries[0x80] == 0x8408, "CRC-16/X.25 table generated incorrectly");
+static_assert(crc16_table.entries[0xFF] == 0x0F78, "CRC-16/X.25 table generated incorrectly");
@@ -0,0 +1,43 @@
+#ifndef CRC16_H
+#define CRC16_H
+#include <stdint.h>
+#include <stddef.h>
+
+//CRC-16/X.25 (the AX.25 FCS): reflected polynomial 0x8408, initial value 0xFFFF, complemented on output.
+
+static const uint16_t CRC16_INIT = 0xFFFF;
+static const uint16_t CRC16_POLY = 0x8408;
+
+//Bit-serial reference, one bit at a time (the original per-bit update). Used to build and verify the table.
+constexpr uint16_t crc16_update_bit(uint16_t crc, uint8_t bit) {
+    return ((crc ^ bit) & 0x0001) ? (crc >> 1) ^ CRC16_POLY : (crc >> 1);
+}
+
+//256-entry lookup table, generated at compile time. Being const it lives in flash on the Teensy.
+struct CRC16Table {
+    uint16_t entries[256];
+    constexpr CRC16Table() : entries() {
+        for(int i = 0; i < 256; i++) {
+            uint16_t crc = i;
+            for(int j = 0; j < 8; j++) {
+                crc = crc16_update_bit(crc, 0);
+            }
+            entries[i] = crc;
+        }
+    }
+};
+extern const CRC16Table crc16_table;
+
+//Byte-at-a-time update, equivalent to 8 calls of crc16_update_bit starting from the least significant bit
+static inline uint16_t crc16_update_byte(uint16_t crc, uint8_t byte) {
+    return (crc >> 8) ^ crc16_table.entries[(crc ^ byte) & 0xFF];
+}
+
+static inline uint16_t crc16_update(uint16_t crc, const uint8_t* data, size_t length) {
+    while(length--) {
+        crc = crc16_update_byte(crc, *data++);
+    }
+    return crc;
+}
+
+#endif // CRC16_H
@@ -0,0 +1,60 @@
+#ifndef DDS_H
+#define DDS_H
+#include <stdint.h>
+
+//Direct digital synthesis on a 32-bit phase accumulator: one full turn is 2^32, so the phase wraps for free,
+//the table index is the top DDS_TABLE_BITS of the phase and the bits below them are the interpolation fraction.
+
+static const int DDS_TABLE_BITS = 8;
+static const int DDS_TABLE_LENGTH = 1 << DDS_TABLE_BITS;
+static const int DDS_FRACTION_BITS = 32 - DDS_TABLE_BITS;
+
+//Phase increment per sample for a tone, rounded to the nearest step (error below 2^-32 of the sample rate)
+constexpr uint32_t dds_increment(uint32_t freq, uint32_t sampleRate) {
+    return (uint32_t) ((((uint64_t) freq << 32) + sampleRate / 2) / sampleRate);
+}
+
+//sin(x) for |x| <= pi, usable at compile time: fold into [-pi/2, pi/2] and sum the Taylor series
+constexpr double dds_sin(double x) {
+    const double pi = 3.14159265358979323846;
+    if(x > pi / 2) x = pi - x;
+    if(x < -pi / 2) x = -pi - x;
+    double term = x;
+    double sum = x;
+    for(int n = 1; n < 12; n++) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+//One full sine period of unsigned DAC codes centred on mid-scale, with the amplitude scaled by `scale`
+//(1.0 = full scale). A guard entry repeats the first sample so interpolation never has to wrap the index.
+template <int Resolution>
+struct DDSTable {
+    uint16_t entries[DDS_TABLE_LENGTH + 1];
+    constexpr DDSTable(double scale) : entries() {
+        const double pi = 3.14159265358979323846;
+        const double mid = ((1 << Resolution) - 1) / 2.0;
+        for(int i = 0; i <= DDS_TABLE_LENGTH; i++) {
+            const double angle = 2 * pi * (i % DDS_TABLE_LENGTH) / DDS_TABLE_LENGTH;
+            entries[i] = (uint16_t) (mid + scale * mid * dds_sin(angle > pi ? angle - 2 * pi : angle) + 0.5);
+        }
+    }
+};
+
+//Nearest table sample for a phase
+static inline uint16_t dds_lookup(const uint16_t* table, uint32_t phase) {
+    return table[phase >> DDS_FRACTION_BITS];
+}
+
+//Linear interpolation between the two table samples around a phase, using the top 16 fraction bits
+static inline uint16_t dds_lookup_interpolated(const uint16_t* table, uint32_t phase) {
+    const uint32_t index = phase >> DDS_FRACTION_BITS;
+    const int32_t fraction = (phase >> (DDS_FRACTION_BITS - 16)) & 0xFFFF;
+    const int32_t a = table[index];
+    const int32_t b = table[index + 1];
+    return a + (((b - a) * fraction) >> 16);
+}
+
+#endif // DDS_H
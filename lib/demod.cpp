@@ -0,0 +1,171 @@
+#include "demod.h"
+#include "dds.h"
+#include "profile.h"
+#include <string.h>
+
+//Two 16x16 multiplies accumulated in one instruction: acc + a.lo * b.lo + a.hi * b.hi
+static inline int32_t smlad(uint32_t a, uint32_t b, int32_t acc) {
+#if defined(__ARM_ARCH_7EM__)
+    int32_t out;
+    asm volatile("smlad %0, %1, %2, %3" : "=r" (out) : "r" (a), "r" (b), "r" (acc));
+    return out;
+#else
+    return acc + (int16_t) a * (int16_t) b + (int16_t) (a >> 16) * (int16_t) (b >> 16);
+#endif
+}
+
+static inline int32_t correlate(const int16_t* samples, const int16_t* coefficients, int pairs) {
+    int32_t acc = 0;
+    for(int i = 0; i < pairs; i++) {
+        uint32_t a, b;
+        memcpy(&a, &samples[2 * i], 4); //a single word load, without breaking aliasing rules
+        memcpy(&b, &coefficients[2 * i], 4);
+        acc = smlad(a, b, acc);
+    }
+    return acc;
+}
+
+//I/Q correlator energy, computed from the accumulators scaled down by 4 bits so the squares fit 64 bits
+static inline int64_t energy(int32_t i, int32_t q) {
+    i >>= 4;
+    q >>= 4;
+    return (int64_t) i * i + (int64_t) q * q;
+}
+
+//Correlator coefficient for a DDS phase, 10 bits of amplitude so a full window of 16-bit samples cannot
+//overflow the 32-bit accumulator
+static int16_t coefficient(uint32_t phase) {
+    const double pi = 3.14159265358979323846;
+    return (int16_t) (1023 * dds_sin((int32_t) phase * (pi / 2147483648.0)));
+}
+
+void AFSKDemodulator::begin(const AFSKDemodConfig& config) {
+    int window = config.window ? config.window : (config.sampleRate + AFSK_RX_BIT_RATE / 2) / AFSK_RX_BIT_RATE;
+    if(window > AFSK_RX_MAX_WINDOW) {
+        window = AFSK_RX_MAX_WINDOW;
+    }
+    memset(markI, 0, sizeof(markI));
+    memset(markQ, 0, sizeof(markQ));
+    memset(spaceI, 0, sizeof(spaceI));
+    memset(spaceQ, 0, sizeof(spaceQ));
+    const uint32_t markStep = dds_increment(AFSK_RX_MARK_FREQ, config.sampleRate);
+    const uint32_t spaceStep = dds_increment(AFSK_RX_SPACE_FREQ, config.sampleRate);
+    //taps are aligned with the newest samples at the end of the history
+    const int first = AFSK_RX_MAX_WINDOW - window;
+    for(int k = 0; k < window; k++) {
+        markI[first + k] = coefficient(markStep * k + 0x40000000); //cosine
+        markQ[first + k] = coefficient(markStep * k);
+        spaceI[first + k] = coefficient(spaceStep * k + 0x40000000);
+        spaceQ[first + k] = coefficient(spaceStep * k);
+    }
+    pairs = (window + 1) / 2;
+    markGain = config.markGain;
+    samplePhase = config.samplePhase;
+    pllStep = dds_increment(AFSK_RX_BIT_RATE, config.sampleRate);
+    goodFrames = 0;
+    badFrames = 0;
+    reset();
+}
+
+void AFSKDemodulator::reset() {
+    memset(history, 0, sizeof(history));
+    dc = 0;
+    pll = 0;
+    lastTone = true;
+    lastLevel = 1;
+    pattern = 0;
+    ones = 0;
+    current = 0;
+    currentBits = 0;
+    inFrame = false;
+    complete = false;
+    length = 0;
+    received = 0;
+}
+
+bool AFSKDemodulator::process(int16_t sample) {
+    complete = false;
+    //DC block: subtract a running mean with a time constant of 128 samples
+    dc += (((int32_t) sample << 8) - dc) >> 7;
+    int32_t x = sample - (dc >> 8);
+    if(x > 32767) x = 32767;
+    if(x < -32768) x = -32768;
+    //only the last `pairs` word pairs hold taps, the samples and zero coefficients in front are never touched
+    const int start = AFSK_RX_MAX_WINDOW - 2 * pairs;
+    memmove(history + start, history + start + 1, (2 * pairs - 1) * sizeof(history[0]));
+    history[AFSK_RX_MAX_WINDOW - 1] = x;
+
+    const int64_t mark = energy(correlate(history + start, markI + start, pairs), correlate(history + start, markQ + start, pairs));
+    const int64_t space = energy(correlate(history + start, spaceI + start, pairs), correlate(history + start, spaceQ + start, pairs));
+    const bool tone = (mark >> 8) * markGain > space;
+
+    //DPLL: transitions pull the phase towards zero, the bit is sampled half a bit later where it wraps
+    const int32_t before = pll - samplePhase;
+    pll += pllStep;
+    if(before >= 0 && (int32_t) (pll - samplePhase) < 0) {
+        receiveBit(tone == lastLevel); //NRZI: no change is a 1
+        lastLevel = tone;
+    }
+    if(tone != lastTone) {
+        const int32_t phase = (int32_t) pll;
+        pll = phase - (inFrame ? phase / 4 : phase / 2); //follow quickly until a frame is under way
+        lastTone = tone;
+    }
+    return complete;
+}
+
+void AFSKDemodulator::receiveBit(uint8_t bit) {
+    pattern = (pattern >> 1) | (bit << 7); //bytes arrive LSB first
+    if(pattern == HDLC_FLAG) {
+        complete = endFrame();
+        inFrame = true;
+        length = 0;
+        currentBits = 0;
+        ones = 0;
+        return;
+    }
+    if((pattern & 0xFE) == 0xFE) {
+        inFrame = false; //seven ones: abort, or no carrier
+        ones = 0;
+        return;
+    }
+    if(!bit) {
+        const bool stuffed = ones == BIT_STUFF_THRESHOLD;
+        ones = 0;
+        if(stuffed) {
+            return;
+        }
+    } else {
+        ones++;
+    }
+    if(!inFrame) {
+        return;
+    }
+    current = (current >> 1) | (bit << 7);
+    if(++currentBits == 8) {
+        currentBits = 0;
+        if(length == AFSK_RX_MAX_FRAME) {
+            inFrame = false;
+            return;
+        }
+        buffer[length++] = current;
+    }
+}
+
+//Closing flag: the seven flag bits before it are already shifted in, so a byte aligned frame has exactly 7 spare
+bool AFSKDemodulator::endFrame() {
+    if(!inFrame || currentBits != 7 || length < AFSK_RX_MIN_FRAME) {
+        return false;
+    }
+    const uint16_t fcs = buffer[length - 2] | (buffer[length - 1] << 8);
+    {
+        PROFILE_SCOPE(PROFILE_RX_CRC);
+        if((uint16_t) ~crc16_update(CRC16_INIT, buffer, length - 2) != fcs) {
+            badFrames++;
+            return false;
+        }
+    }
+    received = length - 2;
+    goodFrames++;
+    return true;
+}
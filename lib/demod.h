@@ -0,0 +1,71 @@
+#ifndef DEMOD_H
+#define DEMOD_H
+#include <stdint.h>
+#include "hdlc.h"
+
+static const int AFSK_RX_BIT_RATE = 1200;
+static const int AFSK_RX_MARK_FREQ = 1200;
+static const int AFSK_RX_SPACE_FREQ = 2200;
+static const int AFSK_RX_MAX_WINDOW = 48; //correlator taps, one bit period at up to 57.6 kHz
+static const int AFSK_RX_MAX_FRAME = 330; //address field, control, PID, 256 info bytes and FCS
+static const int AFSK_RX_MIN_FRAME = 17; //two addresses, control and FCS
+
+//Receiver settings. The defaults decode a flat (de-emphasised) 9600 Hz input.
+struct AFSKDemodConfig {
+    uint32_t sampleRate;
+    uint8_t window; //correlator length in samples, 0 for one bit period
+    uint16_t markGain; //weight of the mark energy against space, 256 = 1.0; raise it to undo transmit twist
+    int32_t samplePhase; //where the DPLL samples within the bit, in 2^-32 bits from the centre
+};
+static const AFSKDemodConfig AFSK_DEMOD_DEFAULTS = {9600, 0, 256, 0};
+
+//Fixed-point AFSK1200 receiver, one call per ADC sample:
+//  DC block -> mark/space I/Q correlators over one bit (16-bit dual MACs, SMLAD on Cortex-M4)
+//  -> energy comparison -> DPLL clock recovery -> NRZI decode -> HDLC flag detection and de-stuffing -> FCS check
+//Hardware independent, so it runs unchanged on the host against WAV files.
+class AFSKDemodulator
+{
+public:
+    AFSKDemodulator(const AFSKDemodConfig& config = AFSK_DEMOD_DEFAULTS) { begin(config); }
+    void begin(const AFSKDemodConfig& config);
+    void reset(); //drop the signal and frame state, keeping the configuration
+    //Feeds one signed sample. Returns true when it completed a frame with a good FCS, which then stays in
+    //frame() until the next call.
+    bool process(int16_t sample);
+    const uint8_t* frame() const { return buffer; }
+    int frameLength() const { return received; } //without the FCS
+    uint32_t frames() const { return goodFrames; }
+    uint32_t fcsErrors() const { return badFrames; }
+private:
+    void receiveBit(uint8_t bit);
+    bool endFrame();
+    //correlator coefficients, zero padded to an even length so they can be read as 16-bit pairs
+    int16_t markI[AFSK_RX_MAX_WINDOW];
+    int16_t markQ[AFSK_RX_MAX_WINDOW];
+    int16_t spaceI[AFSK_RX_MAX_WINDOW];
+    int16_t spaceQ[AFSK_RX_MAX_WINDOW];
+    int16_t history[AFSK_RX_MAX_WINDOW]; //the newest sample last
+    uint8_t pairs;
+    uint16_t markGain;
+    int32_t samplePhase;
+    uint32_t pllStep;
+    //signal state
+    int32_t dc;
+    uint32_t pll;
+    bool lastTone;
+    uint8_t lastLevel;
+    //HDLC receiver state
+    uint8_t pattern;
+    uint8_t ones;
+    uint8_t current;
+    uint8_t currentBits;
+    bool inFrame;
+    bool complete;
+    int length;
+    int received;
+    uint32_t goodFrames;
+    uint32_t badFrames;
+    uint8_t buffer[AFSK_RX_MAX_FRAME];
+};
+
+#endif // DEMOD_H
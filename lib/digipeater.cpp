@@ -0,0 +1,155 @@
+#include "digipeater.h"
+#include "afsk.h"
+#include <string.h>
+
+static const uint8_t AX25_REPEATED = 0x80; //H bit of a path entry's SSID byte
+static const uint8_t AX25_LAST_ADDRESS = 0x01;
+static const uint8_t AX25_MAX_DIGIPEATERS = AX25_MAX_ADDRESSES - 2;
+
+void DedupeCache::clear() {
+    memset(entries, 0, sizeof(entries));
+}
+
+bool DedupeCache::contains(uint32_t digest, uint32_t now, uint32_t windowMs) const {
+    for(int i = 0; i < DIGI_DEDUPE_PROBES; i++) {
+        const Entry& entry = entries[(digest + i) & (DIGI_DEDUPE_SLOTS - 1)];
+        if(entry.digest == digest && now - entry.time < windowMs) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DedupeCache::insert(uint32_t digest, uint32_t now, uint32_t windowMs) {
+    Entry* oldest = 0;
+    for(int i = 0; i < DIGI_DEDUPE_PROBES; i++) {
+        Entry& entry = entries[(digest + i) & (DIGI_DEDUPE_SLOTS - 1)];
+        if(entry.digest == 0 || entry.digest == digest || now - entry.time >= windowMs) {
+            oldest = &entry; //free, expired or our own stale copy
+            break;
+        }
+        if(!oldest || now - entry.time > now - oldest->time) {
+            oldest = &entry;
+        }
+    }
+    oldest->digest = digest;
+    oldest->time = now;
+}
+
+Digipeater::Digipeater(APRS* aprs, const SSID& myCall) : aprs(aprs), myCall(myCall), aliases(0), aliasCount(0),
+    maxHops(DIGI_MAX_WIDE_N), window(DIGI_DEDUPE_WINDOW_MS), dropped(0) {
+    const AX25Header call = ax25_header(&myCall, 1, 0);
+    memcpy(myAddress, call.address, AX25_ADDRESS_LENGTH);
+    myAddress[AX25_CALLSIGN_LENGTH] |= AX25_REPEATED;
+}
+
+void Digipeater::setAliases(const SSID* list, uint8_t count) {
+    aliases = list;
+    aliasCount = count;
+}
+
+//FNV-1a over what stays the same between copies of a frame heard via different paths: destination and source
+//callsigns with their SSIDs, then the information field. Never 0, which marks an unused cache slot.
+uint32_t Digipeater::digest(const AX25Frame& frame) {
+    uint32_t hash = 2166136261u;
+    const uint8_t* address = frame.bytes().data;
+    for(int i = 0; i < 2 * AX25_ADDRESS_LENGTH; i++) {
+        const uint8_t byte = (i % AX25_ADDRESS_LENGTH == AX25_CALLSIGN_LENGTH) ? address[i] & 0x1E : address[i];
+        hash = (hash ^ byte) * 16777619u;
+    }
+    const AX25Span info = frame.info();
+    for(int i = 0; i < info.length; i++) {
+        hash = (hash ^ info.data[i]) * 16777619u;
+    }
+    return hash ? hash : 1;
+}
+
+bool Digipeater::isAlias(AX25Address address) const {
+    for(int i = 0; i < aliasCount; i++) {
+        if(address.matches(aliases[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+//n of a WIDEn-N path entry, 0 if it is something else
+static uint8_t wideN(AX25Address address) {
+    const uint8_t* raw = address.bytes();
+    static const char wide[] = "WIDE";
+    for(int i = 0; i < 4; i++) {
+        if(raw[i] != (uint8_t) (wide[i] << 1)) {
+            return 0;
+        }
+    }
+    const uint8_t n = (raw[4] >> 1) - '0';
+    return (n >= 1 && n <= 7 && raw[5] == (' ' << 1)) ? n : 0;
+}
+
+bool Digipeater::handle(const uint8_t* received, int length, uint32_t now) {
+    AX25Frame frame;
+    if(!frame.parse(received, length) || frame.source().matches(myCall)) {
+        return false;
+    }
+    uint8_t hop = 0;
+    while(hop < frame.digipeaters() && frame.digipeater(hop).repeated()) {
+        hop++;
+    }
+    if(hop == frame.digipeaters()) {
+        return false; //no path left
+    }
+    const AX25Address next = frame.digipeater(hop);
+    const uint8_t n = wideN(next);
+    const uint8_t hopsLeft = next.ssid();
+    const bool explicitHop = next.matches(myCall) || isAlias(next);
+    if(!explicitHop && (n == 0 || n > maxHops || hopsLeft == 0 || hopsLeft > n)) {
+        return false;
+    }
+    const uint32_t key = digest(frame);
+    if(recent.contains(key, now, window)) {
+        dropped++;
+        return false;
+    }
+
+    //rebuild the address field: everything up to the hop, then our callsign and what is left of the path
+    uint8_t address[AX25_MAX_ADDRESSES * AX25_ADDRESS_LENGTH];
+    uint8_t used = (hop + 2) * AX25_ADDRESS_LENGTH;
+    memcpy(address, received, used);
+    const bool insertCall = explicitHop || frame.digipeaters() < AX25_MAX_DIGIPEATERS;
+    if(insertCall) {
+        memcpy(address + used, myAddress, AX25_ADDRESS_LENGTH);
+        used += AX25_ADDRESS_LENGTH;
+    }
+    if(!explicitHop) {
+        memcpy(address + used, next.bytes(), AX25_ADDRESS_LENGTH);
+        uint8_t& ssidByte = address[used + AX25_CALLSIGN_LENGTH];
+        ssidByte = (ssidByte & ~0x1E) | ((hopsLeft - 1) << 1);
+        if(hopsLeft == 1) {
+            ssidByte |= AX25_REPEATED;
+        }
+        used += AX25_ADDRESS_LENGTH;
+    }
+    for(uint8_t i = hop + 1; i < frame.digipeaters(); i++) {
+        memcpy(address + used, frame.digipeater(i).bytes(), AX25_ADDRESS_LENGTH);
+        used += AX25_ADDRESS_LENGTH;
+    }
+    for(uint8_t i = AX25_CALLSIGN_LENGTH; i < used; i += AX25_ADDRESS_LENGTH) {
+        address[i] &= ~AX25_LAST_ADDRESS;
+    }
+    address[used - 1] |= AX25_LAST_ADDRESS;
+
+    const AX25Span info = frame.info();
+    if(!aprs->sendFrame(address, used, info.data, info.length, frame.pid())) {
+        return false; //queue full or frame too long; a later copy may still get through
+    }
+    recent.insert(key, now, window);
+    return true;
+}
+
+void Digipeater::poll() {
+    uint8_t frame[AFSK_RX_MAX_FRAME];
+    int length;
+    while((length = afsk_receive(frame, sizeof(frame))) > 0) {
+        Digipeater::handle(frame, length);
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef DIGIPEATER_H
+#define DIGIPEATER_H
+#include <stdint.h>
+#include "aprs.h"
+#include "ax25.h"
+
+static const int DIGI_DEDUPE_SLOTS = 256; //a power of two; 2 KB of RAM
+static const int DIGI_DEDUPE_PROBES = 8; //slots looked at per lookup, the bound on the O(1) cost
+static const uint32_t DIGI_DEDUPE_WINDOW_MS = 30000;
+static const uint8_t DIGI_MAX_WIDE_N = 2; //highest n of WIDEn-N that is serviced
+
+//Recently repeated frame digests with the time they were seen, in a fixed open-addressed table. Expired slots
+//are simply reused, so nothing is ever deleted; when every probed slot is live the oldest one is replaced.
+class DedupeCache
+{
+public:
+    DedupeCache() { clear(); }
+    void clear();
+    bool contains(uint32_t digest, uint32_t now, uint32_t windowMs) const;
+    void insert(uint32_t digest, uint32_t now, uint32_t windowMs);
+private:
+    struct Entry {
+        uint32_t digest; //0 for a slot never used
+        uint32_t time;
+    };
+    Entry entries[DIGI_DEDUPE_SLOTS];
+};
+
+//WIDEn-N / callsign digipeater. A received frame is repeated when the first unused path entry is our callsign,
+//one of the aliases or a WIDEn-N with hops left. Our callsign is inserted (marked repeated) in front of a WIDEn-N
+//hop when the path has room, N is decremented and the hop marked used once N reaches 0, e.g.
+//  WIDE1-1,WIDE2-1  ->  MYCALL*,WIDE1*,WIDE2-1
+//The new frame goes out through APRS::sendFrame. Frames with the same source, destination and information
+//repeated within the dedupe window are dropped.
+class Digipeater
+{
+public:
+    Digipeater(APRS* aprs, const SSID& myCall); //the callsign string must outlive the digipeater
+    void setAliases(const SSID* aliases, uint8_t count); //e.g. {"RELAY", 0}; replaced by our callsign when used
+    void setMaxHops(uint8_t n) { maxHops = n; }
+    void setDedupeWindow(uint32_t ms) { window = ms; }
+    //Processes one received frame (address field to info, no FCS); true if it was queued for transmission
+    bool handle(const uint8_t* frame, int length, uint32_t now);
+    bool handle(const uint8_t* frame, int length) { return handle(frame, length, millis()); }
+    void poll(); //runs every frame waiting in afsk_receive() through handle(), call it from loop()
+    uint32_t duplicates() const { return dropped; }
+private:
+    static uint32_t digest(const AX25Frame& frame);
+    bool isAlias(AX25Address address) const;
+    APRS* aprs;
+    SSID myCall;
+    uint8_t myAddress[AX25_ADDRESS_LENGTH]; //encoded once, H bit set
+    const SSID* aliases;
+    uint8_t aliasCount;
+    uint8_t maxHops;
+    uint32_t window;
+    uint32_t dropped;
+    DedupeCache recent;
+};
+
+#endif // DIGIPEATER_H
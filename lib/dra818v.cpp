@@ -1,4 +1,66 @@
 #include "dra818v.h"
+#include "profile.h"
+
+//Writes hz as MHz with four decimals, e.g. 144390000 -> "144.3900"
+static char* formatMHz(char* out, uint32_t hz) {
+    const uint32_t units = (hz + 50) / 100; //100 Hz steps
+    uint32_t mhz = units / 10000;
+    char digits[4];
+    int n = 0;
+    do {
+        digits[n++] = '0' + mhz % 10;
+        mhz /= 10;
+    } while(mhz && n < 4);
+    while(n) *out++ = digits[--n];
+    *out++ = '.';
+    uint32_t fraction = units % 10000;
+    for(int i = 3; i >= 0; i--) {
+        out[i] = '0' + fraction % 10;
+        fraction /= 10;
+    }
+    return out + 4;
+}
+
+static char* append(char* out, const char* text) {
+    while(*text) *out++ = *text++;
+    return out;
+}
+
+//Exactly DRA818_TONE_LENGTH characters, reading no further than its terminator
+static bool validTone(const char* tone) {
+    if(!tone) {
+        return false;
+    }
+    for(int i = 0; i < DRA818_TONE_LENGTH; i++) {
+        if(!tone[i]) {
+            return false;
+        }
+    }
+    return tone[DRA818_TONE_LENGTH] == 0;
+}
+
+int dra818_group_command(char* out, bool wideBand, uint32_t txHz, uint32_t rxHz, const char* txCTCSS,
+                         uint8_t squelch, const char* rxCTCSS) {
+    if(!validTone(txCTCSS) || !validTone(rxCTCSS)) {
+        *out = 0;
+        return -1; //anything longer would run past DRA818_COMMAND_MAX
+    }
+    char* p = append(out, "AT+DMOSETGROUP=");
+    *p++ = wideBand ? '1' : '0';
+    *p++ = ',';
+    p = formatMHz(p, txHz);
+    *p++ = ',';
+    p = formatMHz(p, rxHz);
+    *p++ = ',';
+    p = append(p, txCTCSS);
+    *p++ = ',';
+    *p++ = '0' + (squelch > DRA818_MAX_SQUELCH ? DRA818_MAX_SQUELCH : squelch);
+    *p++ = ',';
+    p = append(p, rxCTCSS);
+    p = append(p, "\r\n");
+    *p = 0;
+    return p - out;
+}
 
 DRA818V::DRA818V(uint8_t PTT, uint8_t audioOut, uint8_t mic, uint8_t draTX, uint8_t draRX)
 {
@@ -6,6 +68,12 @@ DRA818V::DRA818V(uint8_t PTT, uint8_t audioOut, uint8_t mic, uint8_t draTX, uint
     pttDelay = PTT_DELAY;
     audioOutPin = audioOut;
     micPin = mic;
+    defaultChannel.txHz = (uint32_t) (APRS_NA_FTX * 1e6 + 0.5);
+    defaultChannel.rxHz = (uint32_t) (APRS_NA_FRX * 1e6 + 0.5);
+    defaultChannel.txCTCSS = TX_CTCSS;
+    defaultChannel.rxCTCSS = RX_CTCSS;
+    defaultChannel.wideBand = CHANNEL_SCAN_BW;
+    channelCount = renderChannels(); //0 if TX_CTCSS/RX_CTCSS are malformed
     #if USE_HW_SERIAL== true
         radioSerial = &Serial1;
     #else
@@ -14,142 +82,210 @@ DRA818V::DRA818V(uint8_t PTT, uint8_t audioOut, uint8_t mic, uint8_t draTX, uint
 }
 
 void DRA818V::init() {
-//    #if USE_HW_SERIAL==true
     pinMode(pttPin,OUTPUT);
-    pinMode(micPin,OUTPUT); 
-    char incomingByte;
+    pinMode(micPin,OUTPUT);
     radioSerial->begin(SOFT_SERIAL_BAUD);
     if(!Serial) {
         Serial.begin(SOFT_SERIAL_BAUD);
     }
-    digitalWrite(pttPin,LOW);
-    delay(200);
-    Serial.println("asdf");
-    radioSerial->print("AT+DMOCONNECT\r\n");
-    digitalWrite(pttPin,HIGH);
-    delay(200);
-    if(DEBUG) {
-        String messageRx = "";
-          while (radioSerial->available() > 0) {
-          incomingByte = radioSerial->read();
-          messageRx = messageRx + incomingByte;
+    digitalWrite(pttPin,HIGH); //receive; the module takes commands while it is not transmitting
+    queueHead = 0;
+    queueCount = 0;
+    waiting = false;
+    attempts = 0;
+    failedCommands = 0;
+    lineLength = 0;
+    lineTooLong = false;
+    currentChannel = DRA818_NO_CHANNEL;
+    targetChannel = DRA818_NO_CHANNEL;
+    notifyTuned = false;
+    sendAfter = millis() + DRA818_BOOT_MS;
+    driverState = DRA818_BUSY;
+    queueCommand("AT+DMOCONNECT\r\n", "+DMOCONNECT:");
+    tune(0);
+}
+
+void DRA818V::setPTTDelay(uint16_t delayMs) {
+    pttDelay = delayMs;
+}
+
+void DRA818V::setSquelch(uint8_t sq_level) {
+    squelch = sq_level > DRA818_MAX_SQUELCH ? DRA818_MAX_SQUELCH : sq_level;
+    renderChannels();
+    if(driverState != DRA818_OFF) {
+        configSettings();
+    }
+}
+
+uint8_t DRA818V::setChannels(const DRA818Channel* plan, uint8_t count) {
+    channels = plan;
+    channelCount = count > DRA818_MAX_CHANNELS ? DRA818_MAX_CHANNELS : count;
+    channelCount = renderChannels();
+    currentChannel = DRA818_NO_CHANNEL; //whatever the module is on belongs to the old plan
+    targetChannel = DRA818_NO_CHANNEL;
+    return channelCount;
+}
+
+uint8_t DRA818V::renderChannels() {
+    for(uint8_t i = 0; i < channelCount; i++) {
+        const DRA818Channel& c = channels[i];
+        if(dra818_group_command(channelCommands[i], c.wideBand, c.txHz, c.rxHz, c.txCTCSS, squelch, c.rxCTCSS) < 0) {
+            return i;
         }
-        if(messageRx!="") {
-          Serial.print("UART received: ");
-          Serial.println(messageRx);
+    }
+    return channelCount;
+}
+
+//Resends the current channel with the new settings, unless a tune to it has not gone out yet: that one picks
+//up the re-rendered text, the queue only holds a pointer to it
+void DRA818V::configSettings() {
+    const uint8_t channel = targetChannel != DRA818_NO_CHANNEL ? targetChannel : 0;
+    if(!tuneQueued(channel)) {
+        targetChannel = DRA818_NO_CHANNEL;
+        tune(channel);
+    }
+}
+
+bool DRA818V::tuneQueued(uint8_t channel) const {
+    for(uint8_t i = waiting ? 1 : 0; i < queueCount; i++) {
+        if(queue[(queueHead + i) % DRA818_QUEUE_SLOTS].channel == channel) {
+            return true;
         }
     }
-    digitalWrite(pttPin,LOW);
-    delay(200);
-    configSettings();
-    digitalWrite(pttPin,HIGH);
-    delay(200);
-    if(DEBUG) {
-        String messageRx = "";
-          while (radioSerial->available() > 0) {
-          incomingByte = radioSerial->read();
-          messageRx = messageRx + incomingByte;
+    return false;
+}
+
+bool DRA818V::tune(uint8_t channel) {
+    if(channel >= channelCount) {
+        return false;
+    }
+    noInterrupts(); //loop() and the transmit interrupt both retune, the check and the queueing go together
+    bool queued = channel == targetChannel; //there already, or the command is queued
+    if(!queued && enqueue(channelCommands[channel], "+DMOSETGROUP:", channel)) {
+        targetChannel = channel;
+        queued = true;
+    }
+    interrupts();
+    return queued;
+}
+
+bool DRA818V::tuned(uint8_t channel, uint32_t now) const {
+    if(driverState == DRA818_OFF) {
+        return true;
+    }
+    return currentChannel == channel && targetChannel == channel && now - tunedAt >= DRA818_SETTLE_MS;
+}
+
+bool DRA818V::queueCommand(const char* command, const char* reply, uint8_t channel) {
+    noInterrupts(); //tune() is called from the transmit interrupt
+    const bool queued = enqueue(command, reply, channel);
+    interrupts();
+    return queued;
+}
+
+bool DRA818V::enqueue(const char* command, const char* reply, uint8_t channel) {
+    if(queueCount == DRA818_QUEUE_SLOTS) {
+        return false;
+    }
+    Command& slot = queue[(queueHead + queueCount) % DRA818_QUEUE_SLOTS];
+    slot.text = command;
+    slot.reply = reply;
+    slot.channel = channel;
+    queueCount++;
+    if(driverState != DRA818_OFF) {
+        driverState = DRA818_BUSY;
+    }
+    return true;
+}
+
+DRA818State DRA818V::poll(uint32_t now) {
+    if(driverState == DRA818_OFF) {
+        return driverState;
+    }
+    readReplies(now);
+    if(waiting && now - sentAt >= DRA818_REPLY_TIMEOUT_MS) {
+        commandDone(false, now);
+    }
+    if(!waiting && queueCount > 0 && (int32_t) (now - sendAfter) >= 0) {
+        PROFILE_SCOPE(PROFILE_DRA818);
+        radioSerial->write(queue[queueHead].text);
+        waiting = true;
+        sentAt = now;
+    }
+    if(notifyTuned && (currentChannel == DRA818_NO_CHANNEL || now - tunedAt >= DRA818_SETTLE_MS)) {
+        notifyTuned = false;
+        if(tunedCallback) {
+            tunedCallback();
         }
-        if(messageRx!="") {
-          Serial.print("UART received: ");
-          Serial.println(messageRx);
+        failedChannel = DRA818_NO_CHANNEL;
+    }
+    return driverState;
+}
+
+//Collects reply bytes into lines; only a complete line is looked at, however the bytes were split between polls
+void DRA818V::readReplies(uint32_t now) {
+    while(radioSerial->available() > 0) {
+        const int c = radioSerial->read();
+        if(c < 0) {
+            break;
+        }
+        if(c == '\n') {
+            if(!lineTooLong) {
+                line[lineLength] = 0;
+                replyLine(now);
+            }
+            lineLength = 0;
+            lineTooLong = false;
+        } else if(c != '\r') {
+            if(lineLength < DRA818_LINE_MAX - 1) {
+                line[lineLength++] = c;
+            } else {
+                lineTooLong = true;
+            }
         }
     }
-//    #else
-//    pinMode(pttPin,OUTPUT);
-//    pinMode(micPin,OUTPUT); 
-//    char incomingByte;
-//    radioSerial.begin(SOFT_SERIAL_BAUD);
-//    if(!Serial) {
-//        Serial.begin(SOFT_SERIAL_BAUD);
-//    }
-//    digitalWrite(pttPin,LOW);
-//    delay(200);
-//    Serial.println("asdf");
-//    radioSerial.print("AT+DMOCONNECT\r\n");
-//    digitalWrite(pttPin,HIGH);
-//    delay(200);
-//    if(DEBUG) {
-//        String messageRx = "";
-//          while (radioSerial.available() > 0) {
-//          incomingByte = radioSerial.read();
-//          messageRx = messageRx + incomingByte;
-//        }
-//        if(messageRx!="") {
-//          Serial.print("UART received: ");
-//          Serial.println(messageRx);
-//        }
-//    }
-//    digitalWrite(pttPin,LOW);
-//    delay(200);
-//    configSettings();
-//    digitalWrite(pttPin,HIGH);
-//    delay(200);
-//    if(DEBUG) {
-//        String messageRx = "";
-//          while (radioSerial.available() > 0) {
-//          incomingByte = radioSerial.read();
-//          messageRx = messageRx + incomingByte;
-//        }
-//        if(messageRx!="") {
-//          Serial.print("UART received: ");
-//          Serial.println(messageRx);
-//        }
-//    }
-//    #endif
 }
 
-void DRA818V::setPTTDelay(uint16_t delayMs) {
-    pttDelay = delayMs;
+//"+DMOSETGROUP:0" acknowledges the command in flight, any other digit refuses it. Other lines are ignored.
+void DRA818V::replyLine(uint32_t now) {
+    if(!waiting) {
+        return;
+    }
+    const char* reply = queue[queueHead].reply;
+    const size_t length = strlen(reply);
+    if(strncmp(line, reply, length) != 0 || line[length] == 0) {
+        return;
+    }
+    commandDone(line[length] == '0', now);
+}
+
+void DRA818V::commandDone(bool ok, uint32_t now) {
+    waiting = false;
+    if(!ok && attempts < DRA818_RETRIES) {
+        attempts++; //the same command goes out again on this poll
+        return;
+    }
+    if(!ok) {
+        failedCommands++;
+    }
+    attempts = 0;
+    const uint8_t channel = queue[queueHead].channel;
+    if(channel != DRA818_NO_CHANNEL) {
+        currentChannel = ok ? channel : DRA818_NO_CHANNEL;
+        if(!ok && targetChannel == channel) {
+            targetChannel = DRA818_NO_CHANNEL; //the next tune() queues it again
+            failedChannel = channel;
+        }
+        tunedAt = now;
+        notifyTuned = true;
+    }
+    noInterrupts();
+    queueHead = (queueHead + 1) % DRA818_QUEUE_SLOTS;
+    queueCount--;
+    if(queueCount == 0) {
+        driverState = failedCommands ? DRA818_FAILED : DRA818_READY;
+    }
+    interrupts();
+    sendAfter = now;
 }
 
-void DRA818V::configSettings() {
-//  #if USE_HW_SERIAL == true
-        digitalWrite(pttPin,HIGH);
-        delay(500);
-        digitalWrite(pttPin,LOW);
-        radioSerial->print("AT+DMOSETGROUP=");
-        radioSerial->print(CHANNEL_SCAN_BW,1);
-        radioSerial->print(",");
-        radioSerial->print(APRS_NA_FTX,4);
-        radioSerial->print(",");
-        radioSerial->print(APRS_NA_FRX,4);
-        radioSerial->print(",");
-        radioSerial->print(TX_CTCSS);
-        radioSerial->print(",");
-        radioSerial->print(squelch);
-        radioSerial->print(",");
-        radioSerial->print(RX_CTCSS);
-        radioSerial->print("\r\n");
-        delay(500);
-        digitalWrite(pttPin,HIGH);
-        delay(500);
-//        digitalWrite(pttPin,LOW);
-//        radioSerial->print("AT+SETFILTER=1,0,0\r\n");
-//        digitalWrite(pttPin,HIGH);
-//    #else
-//        digitalWrite(pttPin,HIGH);
-//        delay(500);
-//        digitalWrite(pttPin,LOW);
-//        radioSerial.print("AT+DMOSETGROUP=");
-//        radioSerial.print(CHANNEL_SCAN_BW,1);
-//        radioSerial.print(",");
-//        radioSerial.print(APRS_NA_FTX,4);
-//        radioSerial.print(",");
-//        radioSerial.print(APRS_NA_FRX,4);
-//        radioSerial.print(",");
-//        radioSerial.print(TX_CTCSS);
-//        radioSerial.print(",");
-//        radioSerial.print(squelch);
-//        radioSerial.print(",");
-//        radioSerial.print(RX_CTCSS);
-//        radioSerial.print("\r\n");
-//        delay(500);
-//        digitalWrite(pttPin,HIGH);
-//        delay(500);
-//        digitalWrite(pttPin,LOW);
-//        radioSerial.print("AT+SETFILTER=1,0,0\r\n");
-//        digitalWrite(pttPin,HIGH);   
-//        #endif 
-}
-
@@ -15,27 +15,126 @@ static const int SOFT_SERIAL_BAUD = 9600;
 static const int SERIAL_BAUD = 9600;
 static const bool CHANNEL_SCAN_BW = true; //true: 25kHz, false: 12.5kHz
 
+static const uint8_t DRA818_QUEUE_SLOTS = 4; //commands waiting to be sent
+static const uint8_t DRA818_COMMAND_MAX = 52; //AT+DMOSETGROUP=1,144.3900,144.3900,0000,8,0000\r\n and its terminator
+static const uint8_t DRA818_TONE_LENGTH = 4; //a CTCSS/CDCSS field, "0000" to "0038" or e.g. "023N"
+static const uint8_t DRA818_LINE_MAX = 24; //longest reply line kept, longer ones are ignored
+static const uint16_t DRA818_BOOT_MS = 200; //from init() to the first command
+static const uint16_t DRA818_REPLY_TIMEOUT_MS = 500; //per attempt
+static const uint8_t DRA818_RETRIES = 2; //attempts after the first before a command counts as failed
+static const uint8_t DRA818_DEFAULT_SQUELCH = 1; //0 (open) to 8
+static const uint8_t DRA818_MAX_SQUELCH = 8;
+static const uint8_t DRA818_MAX_CHANNELS = 4; //entries in a channel plan
+static const uint8_t DRA818_NO_CHANNEL = 0xFF;
+static const uint16_t DRA818_SETTLE_MS = 20; //synthesizer lock after the +DMOSETGROUP reply, before keying up
+
+enum DRA818State {
+    DRA818_OFF, //init() not called yet
+    DRA818_BUSY, //commands queued or waiting for their reply
+    DRA818_READY, //every command acknowledged
+    DRA818_FAILED //queue drained, but a command was refused or went unanswered after its retries
+};
+
+//One entry of a channel plan: frequencies in Hz, CTCSS codes as "0000", wideBand for 25 kHz channels
+struct DRA818Channel {
+    uint32_t txHz;
+    uint32_t rxHz;
+    const char* txCTCSS;
+    const char* rxCTCSS;
+    bool wideBand;
+};
+
+//Renders AT+DMOSETGROUP (bandwidth, TX and RX frequency in Hz, CTCSS codes as "0000", squelch) into out,
+//which needs DRA818_COMMAND_MAX bytes. Returns the length without the terminator, or -1 with out left empty
+//when a CTCSS code is missing or not DRA818_TONE_LENGTH characters.
+int dra818_group_command(char* out, bool wideBand, uint32_t txHz, uint32_t rxHz, const char* txCTCSS,
+                         uint8_t squelch, const char* rxCTCSS);
+
+//Drives the module without blocking: init() and setSquelch() only queue AT commands, and poll() from loop()
+//sends them one at a time, parses the "+DMO...:0" replies as the bytes come in and retries a command that is
+//refused or not answered within DRA818_REPLY_TIMEOUT_MS. Boot overlaps with anything else loop() does.
+//Frequencies come from a channel plan whose DMOSETGROUP commands are rendered once, by setChannels(), so a
+//retune is one queued pointer; the default plan is the single channel APRS_NA_FTX/APRS_NA_FRX.
 class DRA818V
 {
 
 public:
     DRA818V(uint8_t PTT, uint8_t audioOut, uint8_t mic, uint8_t draTX = 0, uint8_t draRX = 0);
-    void init();
-    void setSquelch(uint8_t sq_level);
+    void init(); //queues DMOCONNECT and tunes channel 0, done once poll() returns DRA818_READY
+    void setSquelch(uint8_t sq_level); //0 to 8, the current channel is retuned with it
+    //Replaces the channel plan (at most DRA818_MAX_CHANNELS, kept by pointer) and renders its commands.
+    //The module is retuned on the next tune(); returns the number of channels taken, which stops short at
+    //the first entry whose command can't be rendered.
+    uint8_t setChannels(const DRA818Channel* plan, uint8_t count);
+    //Queues the switch to a channel of the plan unless it is already there or on its way. Safe to call from
+    //the transmit interrupt. False for a channel outside the plan or when the command queue is full.
+    bool tune(uint8_t channel);
+    //True inside the tuned callback when the switch to channel was just given up on after its retries; the
+    //transmitter drops that channel's waiting frames instead of asking again. The next tune() tries afresh.
+    bool tuneFailed(uint8_t channel) const { return failedChannel == channel; }
+    //True once the module has acknowledged channel, has settled for DRA818_SETTLE_MS and no other retune is
+    //pending. An uninitialised driver (init() never called) counts as tuned to any channel.
+    bool tuned(uint8_t channel, uint32_t now) const;
+    bool tuned(uint8_t channel) const { return tuned(channel, millis()); }
+    uint8_t channel() const { return currentChannel; } //DRA818_NO_CHANNEL until a tune is acknowledged
+    //Called from poll() after every retune has settled or failed; the transmit path restarts its queue here
+    void setTunedCallback(void (*callback)()) { tunedCallback = callback; }
     void setPTTDelay(uint16_t delayMs);
+    //Queues a raw command such as "AT+DMOSETVOLUME=5\r\n" with the start of its reply ("+DMOSETVOLUME:").
+    //Both strings are kept by pointer and have to stay valid until the reply. False if the queue is full.
+    bool queueCommand(const char* command, const char* reply) { return queueCommand(command, reply, DRA818_NO_CHANNEL); }
+    DRA818State poll(uint32_t now);
+    DRA818State poll() { return poll(millis()); }
+    DRA818State state() const { return driverState; }
+    bool ready() const { return driverState == DRA818_READY; }
+    uint8_t failures() const { return failedCommands; } //commands given up on since init(), see DRA818_FAILED
     #if USE_HW_SERIAL == true
         HardwareSerial *radioSerial;
     #else
         SoftwareSerial *radioSerial;
     #endif
 private:
+    struct Command {
+        const char* text;
+        const char* reply;
+        uint8_t channel; //the plan entry a DMOSETGROUP tunes to, DRA818_NO_CHANNEL for anything else
+    };
+    bool queueCommand(const char* command, const char* reply, uint8_t channel);
+    bool enqueue(const char* command, const char* reply, uint8_t channel); //with interrupts off
+    uint8_t renderChannels(); //returns how many entries of the plan rendered, in order
     void configSettings();
+    void readReplies(uint32_t now);
+    void replyLine(uint32_t now);
+    void commandDone(bool ok, uint32_t now);
+    bool tuneQueued(uint8_t channel) const;
     uint8_t pttPin = 0;
     uint8_t micPin = 0;
     uint8_t audioOutPin = 0;
     uint8_t pwmPin = 0;
     uint16_t pttDelay = 0;
-    uint8_t squelch;
+    uint8_t squelch = DRA818_DEFAULT_SQUELCH;
+    DRA818State driverState = DRA818_OFF;
+    Command queue[DRA818_QUEUE_SLOTS];
+    uint8_t queueHead = 0;
+    volatile uint8_t queueCount = 0;
+    bool waiting = false; //the head command has been sent and its reply is due
+    uint8_t attempts = 0;
+    uint8_t failedCommands = 0;
+    uint32_t sentAt = 0;
+    uint32_t sendAfter = 0; //no command goes out before this millis()
+    char line[DRA818_LINE_MAX];
+    uint8_t lineLength = 0;
+    bool lineTooLong = false;
+    DRA818Channel defaultChannel;
+    const DRA818Channel* channels = &defaultChannel;
+    uint8_t channelCount = 1;
+    char channelCommands[DRA818_MAX_CHANNELS][DRA818_COMMAND_MAX];
+    volatile uint8_t currentChannel = DRA818_NO_CHANNEL;
+    volatile uint8_t targetChannel = DRA818_NO_CHANNEL; //the channel of the last tune queued
+    volatile uint8_t failedChannel = DRA818_NO_CHANNEL; //set for the tuned callback after a retune was given up on
+    uint32_t tunedAt = 0;
+    bool notifyTuned = false;
+    void (*tunedCallback)() = 0;
 };
 
-#endif // DRA818V_H
+#endif // DRA818V_H
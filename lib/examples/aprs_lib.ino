@@ -2,6 +2,7 @@
 #include "aprs.h"
 #include "aprs_global.h"
 #include "dra818v.h"
+#include "scheduler.h"
 //#if USE_HW_SERIAL ==false
 ////SoftwareSerial radioSerial(A8,A9);
 //#endif
@@ -10,8 +11,17 @@ static const uint8_t n_ssids = 3;
 SSID myssids[n_ssids] = {
   {(char*) "APRS", 0},
   {(char*) "KM6HBK",11},
-  {(char*) "WIDE2-1",11}
+  {(char*) "WIDE2",1} //WIDE2-1: the SSID goes in ssid_designator, callsigns are at most 6 characters
 };
+//The header can also be built at compile time and kept in flash, e.g.
+//  static constexpr SSID path[] = {{"APRS", 0}, {"KM6HBK", 11}, {"WIDE2", 1}};
+//  static constexpr AX25Header header = ax25_header(path);
+//  APRS aprs(&radio, &header);
+//To alternate beacons between channels, give the radio a plan and pick the channel per packet:
+//  static const DRA818Channel plan[] = {{144390000, 144390000, "0000", "0000", true}, {145825000, 145825000, "0000", "0000", true}};
+//  radio.setChannels(plan, 2);   then aprs.setChannel(1) before a send; the retune happens before that key-up
+//To also digipeat what the radio hears (WIDEn-N and our callsign), receive and poll from loop():
+//  Digipeater digi(&aprs, myssids[1]);   afsk_rx_begin() in setup(),   digi.poll() in loop()
 uint8_t dayOfMonth = 0; 
 uint8_t hour = 0;
 uint8_t minute = 0;
@@ -26,15 +36,26 @@ String msg3 = "Rage, rage against the dying of the light.";
 long randomNum = 0;
 DRA818V radio(PTT_PIN,AUDIO_PIN,MIC_PIN,DRATX,DRARX);
 APRS aprs(&radio, myssids,n_ssids);
+//Beacons every 5 s here; for sharing a channel use SmartBeaconing and a GPS time slot instead, e.g.
+//  scheduler.setSmartBeaconing(SMARTBEACON_DEFAULTS);  scheduler.setSlot(60, 20);
+//and feed it scheduler.setTime(dayOfMonth, hour, minute, second) and setMotion(speed, heading) from the GPS
+BeaconScheduler scheduler;
 void setup() {  
   Serial.begin(9600);
 //  pinMode(A0,OUTPUT);
 //  digitalWrite(A0,LOW);
   delay(750);
-  radio.init();
+  radio.init(); //only queues the setup commands, radio.poll() sends them
+  scheduler.setFixedInterval(5000);
 }
 
 void loop() {
+  if(radio.poll() == DRA818_FAILED) {
+    radio.init(); //the module did not take its settings, start over
+  }
+  if(!radio.ready() || !scheduler.poll()) {
+    return; //nothing due; loop() keeps running for other work
+  }
   Serial.println("Start");
   aprs.sendPacketGPS(dayOfMonth,hour,minute,lat,lon,altitude,heading,speed,"ABCDEFGHIJKLMNOPQRSTUVWXYZ");
 //  uint8_t myData[4] = {(uint8_t)(randomNum>>24),(uint8_t)(randomNum>>16),(uint8_t) (randomNum>>8),(uint8_t) (randomNum & 0xFF)};
@@ -48,5 +69,4 @@ void loop() {
 //  };
 //  comment = comment + "aljjalsdjlaksdjf;lkj;jasdfj;ajkdfasdfj;j";
 //  aprs.sendPacket(myData,comment,sizeof(myData) + comment.length());
-  delay(5000);
 }
@@ -0,0 +1,79 @@
+#include "fx25.h"
+#include "hdlc.h"
+#include <string.h>
+
+constexpr GF256Tables gf256;
+static constexpr RSGenerator<16> generator16;
+static constexpr RSGenerator<32> generator32;
+static constexpr RSGenerator<64> generator64;
+
+static_assert(gf256.exp[8] == 0x1D && gf256.log[0x1D] == 8, "GF(256) tables generated incorrectly");
+static_assert(gf256.exp[255] == 1 && gf256.exp[gf256.log[0x02] + gf256.log[0x80]] == 0x1D, "0x02 * 0x80 wraps to the polynomial");
+static_assert(generator16.logs[15] == 136 && generator16.logs[0] == 121, "RS(255,239) generator is wrong");
+
+//Ordered by check bytes, then by size, so the first one that fits is the smallest
+static const FX25Code fx25_codes[] = {
+    {0x8F056EB4369660EEull, 32, 16},
+    {0xC7DC0508F3D9B09Eull, 64, 16},
+    {0x26FF60A600CC8FDEull, 128, 16},
+    {0xB74DB7DF8A532F3Eull, 239, 16},
+    {0xDBF869BD2DBB1776ull, 32, 32},
+    {0x1EB7B9CDBC09C00Eull, 64, 32},
+    {0xFF94DC634F1CFF4Eull, 128, 32},
+    {0x6E260B1AC5835FAEull, 223, 32},
+    {0x4A4ABEC4A724B796ull, 64, 64},
+    {0xAB69DB6A543188D6ull, 128, 64},
+    {0x3ADB0C13DEAE2836ull, 191, 64},
+};
+
+void RSEncoder::begin(FX25Check check) {
+    checkBytes = check;
+    generator = check == FX25_CHECK_64 ? generator64.logs : check == FX25_CHECK_32 ? generator32.logs : generator16.logs;
+    memset(parity, 0, sizeof(parity));
+}
+
+const FX25Code* fx25_code(int dataBytes, FX25Check check) {
+    for(unsigned int i = 0; i < sizeof(fx25_codes) / sizeof(fx25_codes[0]); i++) {
+        if(fx25_codes[i].checkBytes == check && fx25_codes[i].dataBytes >= dataBytes) {
+            return &fx25_codes[i];
+        }
+    }
+    return 0;
+}
+
+//FX.25 bytes go out least significant bit first, the queued bitstream is packed most significant bit first
+static inline uint8_t reverseBits(uint8_t byte) {
+    static const uint8_t nibbles[16] = {0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF};
+    return (nibbles[byte & 0xF] << 4) | nibbles[byte >> 4];
+}
+
+//The bitstream moves up to make room for the tag. Its last partial byte is topped up with the flag pattern and
+//whole flags fill the rest of the data block, so the codeblock is a byte-aligned string of flags after the frame.
+int fx25_wrap(uint8_t* bits, int sizeBits, int capacityBytes, FX25Check check) {
+    const int frameBytes = (sizeBits + 7) / 8;
+    const FX25Code* code = fx25_code(frameBytes, check);
+    if(!code || FX25_TAG_BYTES + code->dataBytes + code->checkBytes > capacityBytes) {
+        return -1;
+    }
+    uint8_t* data = bits + FX25_TAG_BYTES;
+    memmove(data, bits, frameBytes);
+    for(int i = 0; i < FX25_TAG_BYTES; i++) {
+        bits[i] = reverseBits(code->tag >> (8 * i));
+    }
+    const int used = sizeBits % 8;
+    if(used) {
+        data[frameBytes - 1] = (data[frameBytes - 1] & (uint8_t) (0xFF << (8 - used))) | (HDLC_FLAG & (0xFF >> used));
+    }
+    memset(data + frameBytes, HDLC_FLAG, code->dataBytes - frameBytes);
+
+    RSEncoder rs;
+    rs.begin(check);
+    for(int i = 0; i < code->dataBytes; i++) {
+        rs.update(reverseBits(data[i]));
+    }
+    uint8_t* checkOut = data + code->dataBytes;
+    for(int i = 0; i < code->checkBytes; i++) {
+        checkOut[i] = reverseBits(rs.check()[i]);
+    }
+    return (FX25_TAG_BYTES + code->dataBytes + code->checkBytes) * 8;
+}
@@ -0,0 +1,110 @@
+#ifndef FX25_H
+#define FX25_H
+#include <stdint.h>
+
+//FX.25: an AX.25 frame sent inside a Reed-Solomon codeblock. The stuffed bitstream, opening to closing flag, is
+//packed into bytes, padded with flags to one of a few block sizes and followed by RS check bytes, with a 64-bit
+//correlation tag in front that tells receivers which code follows. Nothing after the tag is stuffed, so plain
+//AX.25 receivers still find the frame between its flags and ignore the rest.
+
+static const uint16_t GF256_POLY = 0x11D; //x^8 + x^4 + x^3 + x^2 + 1
+static const int FX25_TAG_BYTES = 8;
+static const int FX25_MAX_BLOCK = 255; //RS(255, k) codes, the shorter ones are shortened
+static const int FX25_MAX_CHECK_BYTES = 64;
+
+//Check bytes to protect frames with; corrects up to half as many bad bytes per frame
+enum FX25Check {
+    FX25_OFF = 0,
+    FX25_CHECK_16 = 16,
+    FX25_CHECK_32 = 32,
+    FX25_CHECK_64 = 64
+};
+
+//GF(256) log and antilog tables. exp is doubled so the sum of two logs indexes it without reducing modulo 255.
+//Generated at compile time and const, so they sit in flash on the Teensy (768 bytes).
+struct GF256Tables {
+    uint8_t exp[512];
+    uint8_t log[256];
+    constexpr GF256Tables() : exp(), log() {
+        uint16_t x = 1;
+        for(int i = 0; i < 255; i++) {
+            exp[i] = exp[i + 255] = x;
+            log[x] = i;
+            x <<= 1;
+            if(x & 0x100) {
+                x ^= GF256_POLY;
+            }
+        }
+        exp[510] = exp[0];
+        exp[511] = exp[1];
+        log[0] = 255; //no log; the encoder tests the feedback byte for zero first
+    }
+};
+extern const GF256Tables gf256;
+
+//RS generator polynomial with roots alpha^1 .. alpha^checkBytes (first consecutive root 1, as FX.25 uses), its
+//coefficients stored as logs, highest degree first after the implied leading 1
+template<int N>
+struct RSGenerator {
+    uint8_t logs[N];
+    constexpr RSGenerator() : logs() {
+        GF256Tables gf; //gf256 itself can't be read while the compiler builds this
+        uint8_t poly[N + 1] = {1}; //poly[i] multiplies x^i
+        for(int root = 1; root <= N; root++) {
+            //multiply by (x + alpha^root)
+            for(int i = root; i > 0; i--) {
+                poly[i] = poly[i - 1] ^ (poly[i] ? gf.exp[gf.log[poly[i]] + root] : 0);
+            }
+            poly[0] = gf.exp[gf.log[poly[0]] + root];
+        }
+        for(int i = 0; i < N; i++) {
+            logs[i] = gf.log[poly[N - 1 - i]];
+        }
+    }
+};
+
+//Systematic RS(255, 255 - checkBytes) encoder over GF(256), a byte at a time: a shift register of the check
+//bytes, one table lookup for the feedback and one multiply per check byte. Shortened codes just feed fewer bytes.
+class RSEncoder
+{
+public:
+    RSEncoder() : checkBytes(0), generator(0), parity() {}
+    void begin(FX25Check check);
+    inline void update(uint8_t byte) {
+        const uint8_t feedback = byte ^ parity[0];
+        for(int i = 0; i < checkBytes - 1; i++) {
+            parity[i] = parity[i + 1];
+        }
+        parity[checkBytes - 1] = 0;
+        if(feedback) {
+            const uint8_t logFeedback = gf256.log[feedback];
+            for(int i = 0; i < checkBytes; i++) {
+                parity[i] ^= gf256.exp[logFeedback + generator[i]];
+            }
+        }
+    }
+    //The check bytes, in transmit order
+    const uint8_t* check() const { return parity; }
+private:
+    uint8_t checkBytes;
+    const uint8_t* generator;
+    uint8_t parity[FX25_MAX_CHECK_BYTES];
+};
+
+//One of the FX.25 codes: its correlation tag (sent least significant bit first), data and check bytes
+struct FX25Code {
+    uint64_t tag;
+    uint8_t dataBytes;
+    uint8_t checkBytes;
+};
+
+//The smallest code with check bytes that holds dataBytes, or 0 when none does
+const FX25Code* fx25_code(int dataBytes, FX25Check check);
+
+//Turns a queued HDLC bitstream (packed most significant bit first in transmit order, like a TxFrame) into an
+//FX.25 frame in place: tag, the bitstream padded with flags to the block size, check bytes. capacityBytes is the
+//size of bits. Returns the new length in bits, or -1, leaving bits as they were, when no code or buffer is big
+//enough.
+int fx25_wrap(uint8_t* bits, int sizeBits, int capacityBytes, FX25Check check);
+
+#endif // FX25_H
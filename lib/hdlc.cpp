@@ -0,0 +1,71 @@
+#include "hdlc.h"
+
+constexpr BitStuffTable bitstuff_table;
+
+static_assert(bitstuff_table.entries[0][0x00] == (8u << 16), "bit-stuffing table generated incorrectly");
+static_assert(bitstuff_table.entries[0][0x1F] == (0x1F0u | (9u << 16)), "five ones must be followed by a stuffed zero");
+static_assert(bitstuff_table.entries[4][0xFF] == (0x2FBu | (10u << 16) | (2u << 20)), "two stuffed zeros for a long run");
+
+void HDLCEncoder::begin(volatile uint8_t* buf, int capacityBytes) {
+    buffer = buf;
+    capacity = capacityBytes;
+    accumulator = 0;
+    accBits = 0;
+    ones = 0;
+    bytesOut = 0;
+    crc = CRC16_INIT;
+}
+
+void HDLCEncoder::resume(volatile uint8_t* buf, int capacityBytes, const HDLCState& state) {
+    buffer = buf;
+    capacity = capacityBytes;
+    accumulator = state.pending;
+    accBits = state.pendingBits;
+    ones = state.ones;
+    bytesOut = state.bytes;
+    crc = state.crc;
+}
+
+void HDLCEncoder::redirect(volatile uint8_t* buf, int capacityBytes) {
+    buffer = buf;
+    capacity = capacityBytes;
+    bytesOut = 0;
+}
+
+//Flags are sent raw: no stuffing and not part of the FCS. The trailing zero ends any run of ones.
+void HDLCEncoder::loadFlag() {
+    append(HDLC_FLAG, 8);
+    ones = 0;
+}
+
+//The FCS goes out complemented, low byte first
+void HDLCEncoder::loadFCS() {
+    const uint16_t fcs = ~crc;
+    loadByte(fcs & 0xFF);
+    loadByte(fcs >> 8);
+}
+
+void HDLCEncoder::flushWord(uint32_t word) {
+    for(int shift = 24; shift >= 0; shift -= 8) {
+        if(bytesOut < capacity) {
+            buffer[bytesOut] = word >> shift;
+        }
+        bytesOut++;
+    }
+}
+
+int HDLCEncoder::finish() {
+    const int total = bits();
+    if(accBits > 0) {
+        uint32_t rest = (uint32_t) accumulator << (32 - accBits); //left align what is left, at most 31 bits
+        for(int i = 0; i < accBits; i += 8) {
+            if(bytesOut < capacity) {
+                buffer[bytesOut] = rest >> 24;
+            }
+            bytesOut++;
+            rest <<= 8;
+        }
+        accBits = 0;
+    }
+    return total;
+}
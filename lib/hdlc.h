@@ -0,0 +1,108 @@
+#ifndef HDLC_H
+#define HDLC_H
+#include <stdint.h>
+#include "crc16.h"
+#include "profile.h"
+
+static const uint8_t HDLC_FLAG = 0x7E;
+static const uint8_t BIT_STUFF_THRESHOLD = 5;
+
+//Bit-stuffing table indexed by [run of consecutive ones so far][input byte]. Each entry packs
+//  bits 0-9:   the stuffed output, first transmitted bit (the input LSB) in the highest used position
+//  bits 16-19: the number of output bits (8 to 10)
+//  bits 20-22: the run of consecutive ones left after the byte
+//Generated at compile time and const, so it sits in flash on the Teensy (5 KB).
+struct BitStuffTable {
+    uint32_t entries[BIT_STUFF_THRESHOLD][256];
+    constexpr BitStuffTable() : entries() {
+        for(int ones = 0; ones < BIT_STUFF_THRESHOLD; ones++) {
+            for(int byte = 0; byte < 256; byte++) {
+                uint32_t out = 0;
+                uint32_t length = 0;
+                int run = ones;
+                for(int i = 0; i < 8; i++) {
+                    const uint32_t bit = (byte >> i) & 1;
+                    out = (out << 1) | bit;
+                    length++;
+                    if(!bit) {
+                        run = 0;
+                    } else if(++run == BIT_STUFF_THRESHOLD) {
+                        out <<= 1; //stuffed zero
+                        length++;
+                        run = 0;
+                    }
+                }
+                entries[ones][byte] = out | (length << 16) | ((uint32_t) run << 20);
+            }
+        }
+    }
+};
+extern const BitStuffTable bitstuff_table;
+
+//Encoder state at a byte-aligned point of the stream: the bytes before it are complete in the buffer and the
+//pending bits (fewer than 8, right aligned) have yet to be written. Lets a cached prefix be resumed.
+struct HDLCState {
+    uint16_t bytes;
+    uint8_t pending;
+    uint8_t pendingBits;
+    uint8_t ones;
+    uint16_t crc;
+};
+
+//Builds an HDLC bitstream (flags, stuffed bytes, FCS) into a byte buffer, packed most significant bit first
+//in transmit order, which is the layout the modulator reads. Each byte is stuffed with one table lookup and
+//appended to a 64-bit accumulator that is written out 32 bits at a time.
+class HDLCEncoder
+{
+public:
+    HDLCEncoder() : buffer(0), capacity(0), accumulator(0), accBits(0), ones(0), bytesOut(0), crc(CRC16_INIT) {}
+    void begin(volatile uint8_t* buf, int capacityBytes);
+    //Continues a stream whose first state.bytes bytes are already in buf, e.g. copied from a cached header
+    void resume(volatile uint8_t* buf, int capacityBytes, const HDLCState& state);
+    //Carries on with the same stream into another buffer: the bits still in the accumulator go out first there.
+    //This is how a frame is encoded a chunk at a time (AX25Stream).
+    void redirect(volatile uint8_t* buf, int capacityBytes);
+    void loadFlag();
+    void loadFCS();
+    int finish(); //flushes the partial last byte (zero padded) and returns the stream length in bits
+
+    //Stuffed data byte, least significant bit first, included in the FCS
+    inline void loadByte(uint8_t byte) {
+        {
+            PROFILE_SCOPE(PROFILE_TX_CRC); //per byte, so at a few cycles the probe itself dominates the mean
+            crc = crc16_update_byte(crc, byte);
+        }
+        const uint32_t entry = bitstuff_table.entries[ones][byte];
+        append(entry & 0x3FF, (entry >> 16) & 0xF);
+        ones = entry >> 20;
+    }
+
+    //Lets the aprs_put_* formatters (aprs_payload.h) write an information field straight into the frame
+    inline void put(char c) { loadByte(c); }
+
+    int bits() const { return bytesOut * 8 + accBits; }
+    int bytesWritten() const { return bytesOut; }
+    uint16_t getCRC() const { return crc; }
+    bool overflowed() const { return bits() > capacity * 8; }
+
+private:
+    inline void append(uint32_t value, uint8_t length) {
+        accumulator = (accumulator << length) | value;
+        accBits += length;
+        if(accBits >= 32) {
+            accBits -= 32;
+            flushWord((uint32_t) (accumulator >> accBits));
+        }
+    }
+    void flushWord(uint32_t word);
+
+    volatile uint8_t* buffer;
+    int capacity;
+    uint64_t accumulator;
+    uint8_t accBits;
+    uint8_t ones; //consecutive ones since the last zero, drives the stuffing
+    int bytesOut;
+    uint16_t crc;
+};
+
+#endif // HDLC_H
@@ -0,0 +1,196 @@
+#ifndef MODEM_H
+#define MODEM_H
+#include <stdint.h>
+#include "dds.h"
+
+#ifndef AFSK_DDS_INTERPOLATE
+#define AFSK_DDS_INTERPOLATE false //linearly interpolate between tone table entries, one multiply per sample
+#endif
+
+//Modulators turn a stuffed HDLC bitstream (packed most significant bit first, see HDLCEncoder) into DAC
+//samples. Every rate and frequency is a template parameter, so each configuration gets its own fully
+//constant-folded sample loop. They all share one interface:
+//  reset()              start a new transmission (NRZI and phase state back to idle)
+//  load(bits, size)     continue with the next size bits, keeping the line state, e.g. the next frame
+//  next(&sample)        the next sample; false once the loaded bits are used up
+
+//Audio FSK with continuous phase, NRZI coded (a 0 toggles the tone, a 1 keeps it). The mark tone is scaled to
+//MarkScalePercent of full scale to pre-compensate the radio's pre-emphasis.
+template <uint32_t BitRate, uint32_t SampleRate, uint32_t MarkFreq, uint32_t SpaceFreq, int Resolution, int MarkScalePercent>
+class AFSKModulator
+{
+public:
+    static const uint32_t BIT_RATE = BitRate;
+    static const uint32_t SAMPLE_RATE = SampleRate;
+    static const uint32_t SAMPLES_PER_BIT = SampleRate / BitRate;
+    static const uint32_t MARK_INCREMENT = dds_increment(MarkFreq, SampleRate);
+    static const uint32_t SPACE_INCREMENT = dds_increment(SpaceFreq, SampleRate);
+    static_assert(SampleRate % BitRate == 0, "the sample rate must be a whole multiple of the bit rate");
+
+    void reset() {
+        phase = 0;
+        mark = true;
+        increment = MARK_INCREMENT;
+        table = markTable.entries;
+        bitIndex = 0;
+        load(0, 0);
+    }
+
+    void load(const volatile uint8_t* buffer, int size) {
+        bits = buffer;
+        bitCount = size;
+        bitPos = 0;
+    }
+
+    inline bool next(uint16_t* sample) {
+        if(bitIndex == 0) {
+            if(bitPos >= bitCount) {
+                return false;
+            }
+            if(!(bits[bitPos >> 3] & (0x80 >> (bitPos & 7)))) {
+                mark = !mark; //transmitting a 0: change tone
+            }
+            bitPos++;
+            bitIndex = SAMPLES_PER_BIT;
+            increment = mark ? MARK_INCREMENT : SPACE_INCREMENT;
+            table = mark ? markTable.entries : spaceTable.entries;
+        }
+        phase += increment; //wraps around at a full turn by itself
+        bitIndex--;
+#if AFSK_DDS_INTERPOLATE
+        *sample = dds_lookup_interpolated(table, phase);
+#else
+        *sample = dds_lookup(table, phase);
+#endif
+        return true;
+    }
+
+private:
+    static constexpr DDSTable<Resolution> markTable = DDSTable<Resolution>(MarkScalePercent / 100.0);
+    static constexpr DDSTable<Resolution> spaceTable = DDSTable<Resolution>(1.0);
+    const volatile uint8_t* bits;
+    int bitCount;
+    int bitPos;
+    uint32_t phase;
+    uint32_t increment;
+    const uint16_t* table;
+    uint16_t bitIndex;
+    bool mark;
+};
+
+template <uint32_t B, uint32_t S, uint32_t M, uint32_t SP, int R, int P>
+constexpr DDSTable<R> AFSKModulator<B, S, M, SP, R, P>::markTable;
+template <uint32_t B, uint32_t S, uint32_t M, uint32_t SP, int R, int P>
+constexpr DDSTable<R> AFSKModulator<B, S, M, SP, R, P>::spaceTable;
+
+//cos(x) for |x| <= 3pi/2 at compile time
+constexpr double modem_cos(double x) {
+    const double pi = 3.14159265358979323846;
+    return (x + pi / 2 > pi) ? dds_sin(x + pi / 2 - 2 * pi) : dds_sin(x + pi / 2);
+}
+
+//Raised cosine pulse (roll-off 0.5) at t bit periods from its centre
+constexpr double modem_raised_cosine(double t) {
+    const double pi = 3.14159265358979323846;
+    const double beta = 0.5;
+    if(t < 0) t = -t;
+    if(t < 1e-9) return 1.0;
+    if(t > 1 / (2 * beta) - 1e-9 && t < 1 / (2 * beta) + 1e-9) {
+        return (pi / 4) * dds_sin(pi / (2 * beta)) / (pi / (2 * beta)); //limit at the singular point
+    }
+    const double sinc = (t <= 1 ? dds_sin(pi * t) : -dds_sin(pi * (t - 1))) / (pi * t);
+    const double rolloff = (t <= 1.5 ? modem_cos(pi * beta * t) : -modem_cos(pi * beta * t - pi));
+    return sinc * rolloff / (1 - (2 * beta * t) * (2 * beta * t));
+}
+
+//Pulse-shaping table for baseband FSK: for every pattern of the last G3RUH_SHAPE_BITS line bits, the samples
+//of one bit period, the sum of a raised cosine pulse per bit, scaled to the DAC range.
+static const int G3RUH_SHAPE_BITS = 4;
+template <uint32_t SamplesPerBit, int Resolution>
+struct FSKShapeTable {
+    uint16_t entries[1 << G3RUH_SHAPE_BITS][SamplesPerBit];
+    constexpr FSKShapeTable() : entries() {
+        double peak = 0;
+        double levels[1 << G3RUH_SHAPE_BITS][SamplesPerBit] = {};
+        for(int pattern = 0; pattern < (1 << G3RUH_SHAPE_BITS); pattern++) {
+            for(uint32_t s = 0; s < SamplesPerBit; s++) {
+                //output time sits between the second and third newest bits, so pulses reach 2 bits either side
+                const double t = 1.5 + (s + 0.5) / SamplesPerBit;
+                double sum = 0;
+                for(int i = 0; i < G3RUH_SHAPE_BITS; i++) {
+                    const double level = ((pattern >> (G3RUH_SHAPE_BITS - 1 - i)) & 1) ? 1.0 : -1.0;
+                    sum += level * modem_raised_cosine(t - i);
+                }
+                levels[pattern][s] = sum;
+                if(sum > peak) peak = sum;
+                if(-sum > peak) peak = -sum;
+            }
+        }
+        const double mid = ((1 << Resolution) - 1) / 2.0;
+        for(int pattern = 0; pattern < (1 << G3RUH_SHAPE_BITS); pattern++) {
+            for(uint32_t s = 0; s < SamplesPerBit; s++) {
+                entries[pattern][s] = (uint16_t) (mid + mid * levels[pattern][s] / peak + 0.5);
+            }
+        }
+    }
+};
+
+//G3RUH baseband FSK: NRZI, then the self-synchronising scrambler 1 + x^12 + x^17, then pulse shaped levels.
+//The output lags the bitstream by two bit periods because of the shaping window.
+template <uint32_t BitRate, uint32_t SampleRate, int Resolution>
+class G3RUHModulator
+{
+public:
+    static const uint32_t BIT_RATE = BitRate;
+    static const uint32_t SAMPLE_RATE = SampleRate;
+    static const uint32_t SAMPLES_PER_BIT = SampleRate / BitRate;
+    static_assert(SampleRate % BitRate == 0, "the sample rate must be a whole multiple of the bit rate");
+
+    void reset() {
+        level = 1;
+        scrambler = 0;
+        history = 0x5; //alternating idle pattern, mid-scale on average
+        bitIndex = 0;
+        load(0, 0);
+    }
+
+    void load(const volatile uint8_t* buffer, int size) {
+        bits = buffer;
+        bitCount = size;
+        bitPos = 0;
+    }
+
+    inline bool next(uint16_t* sample) {
+        if(bitIndex == 0) {
+            if(bitPos >= bitCount) {
+                return false;
+            }
+            if(!(bits[bitPos >> 3] & (0x80 >> (bitPos & 7)))) {
+                level ^= 1; //NRZI
+            }
+            bitPos++;
+            const uint32_t out = (level ^ (scrambler >> 11) ^ (scrambler >> 16)) & 1;
+            scrambler = (scrambler << 1) | out;
+            history = ((history << 1) | out) & ((1 << G3RUH_SHAPE_BITS) - 1);
+            bitIndex = SAMPLES_PER_BIT;
+        }
+        *sample = shapeTable.entries[history][SAMPLES_PER_BIT - bitIndex];
+        bitIndex--;
+        return true;
+    }
+
+private:
+    static constexpr FSKShapeTable<SampleRate / BitRate, Resolution> shapeTable = FSKShapeTable<SampleRate / BitRate, Resolution>();
+    const volatile uint8_t* bits;
+    int bitCount;
+    int bitPos;
+    uint32_t scrambler;
+    uint8_t level;
+    uint8_t history;
+    uint16_t bitIndex;
+};
+
+template <uint32_t B, uint32_t S, int R>
+constexpr FSKShapeTable<S / B, R> G3RUHModulator<B, S, R>::shapeTable;
+
+#endif // MODEM_H
@@ -0,0 +1,95 @@
+#include "profile.h"
+#include <string.h>
+
+static const char* const PROBE_NAMES[PROFILE_PROBES] = {"radioISR", "ISR jitter", "frame build", "TX CRC", "RX CRC", "DRA818 write"};
+
+static ProfileStats stats[PROFILE_PROBES];
+static uint32_t lastEntry;
+static bool haveEntry = false;
+
+void profile_begin() {
+#ifndef APRS_HOST
+    ARM_DEMCR |= ARM_DEMCR_TRCENA;
+    ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+#endif
+    for(int i = 0; i < PROFILE_PROBES; i++) {
+        profile_reset((ProfileProbe) i);
+    }
+    profile_isr_restart();
+}
+
+void profile_reset(ProfileProbe probe) {
+    noInterrupts();
+    memset(&stats[probe], 0, sizeof(ProfileStats));
+    stats[probe].min = UINT32_MAX;
+    interrupts();
+}
+
+void profile_record(ProfileProbe probe, uint32_t ticks) {
+    ProfileStats& s = stats[probe];
+    s.count++;
+    s.total += ticks;
+    if(ticks < s.min) s.min = ticks;
+    if(ticks > s.max) s.max = ticks;
+    s.histogram[ticks ? 32 - __builtin_clz(ticks) : 0]++;
+}
+
+void profile_isr_entry(uint32_t periodTicks) {
+    const uint32_t now = profile_ticks();
+    if(haveEntry) {
+        const uint32_t delta = now - lastEntry;
+        profile_record(PROFILE_ISR_JITTER, delta > periodTicks ? delta - periodTicks : periodTicks - delta);
+    }
+    lastEntry = now;
+    haveEntry = true;
+}
+
+void profile_isr_restart() {
+    haveEntry = false;
+}
+
+void profile_snapshot(ProfileProbe probe, ProfileStats* out) {
+    noInterrupts();
+    memcpy(out, &stats[probe], sizeof(ProfileStats));
+    interrupts();
+}
+
+//Ticks as microseconds with two decimals, integer math only
+static void printMicros(Stream& out, uint64_t ticks) {
+    const uint64_t hundredths = (ticks * 100 + PROFILE_TICKS_PER_US / 2) / PROFILE_TICKS_PER_US;
+    out.print((unsigned long) (hundredths / 100));
+    out.print('.');
+    out.print((char) ('0' + hundredths / 10 % 10));
+    out.print((char) ('0' + hundredths % 10));
+}
+
+void profile_dump(Stream& out) {
+    ProfileStats s;
+    for(int i = 0; i < PROFILE_PROBES; i++) {
+        profile_snapshot((ProfileProbe) i, &s);
+        if(!s.count) {
+            continue;
+        }
+        out.print(PROBE_NAMES[i]);
+        out.print(": n=");
+        out.print((unsigned long) s.count);
+        out.print(" min=");
+        printMicros(out, s.min);
+        out.print(" mean=");
+        printMicros(out, s.total / s.count);
+        out.print(" max=");
+        printMicros(out, s.max);
+        out.println(" us");
+        out.print("  log2 ticks:");
+        for(int b = 0; b < PROFILE_BUCKETS; b++) {
+            if(s.histogram[b]) {
+                out.print(' ');
+                out.print(b ? (unsigned long) 1 << (b - 1) : 0ul);
+                out.print('+');
+                out.print(':');
+                out.print((unsigned long) s.histogram[b]);
+            }
+        }
+        out.println();
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+#include <stdint.h>
+#include "Arduino.h"
+
+//Hot path profiling. Build with APRS_PROFILE 1 to compile the probes in; at 0 (default) PROFILE_SCOPE and
+//PROFILE_ISR_ENTRY expand to nothing and the library's timing is untouched.
+#ifndef APRS_PROFILE
+#define APRS_PROFILE 0
+#endif
+
+enum ProfileProbe {
+    PROFILE_RADIO_ISR, //one sample timer interrupt
+    PROFILE_ISR_JITTER, //|time between interrupt entries - sample period|
+    PROFILE_FRAME_BUILD, //a sendPacketGPS call, header to queued frame
+    PROFILE_TX_CRC, //one byte of FCS accumulation in HDLCEncoder::loadByte, as a frame is encoded
+    PROFILE_RX_CRC, //the demodulator's FCS check of a received frame
+    PROFILE_DRA818, //writing a command to the DRA818V serial port
+    PROFILE_PROBES
+};
+
+static const int PROFILE_BUCKETS = 33; //0, then [2^(b-1), 2^b) ticks for b = 1..32
+
+//Min/max/mean and a log2 histogram of one probe, in ticks
+struct ProfileStats {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t histogram[PROFILE_BUCKETS];
+};
+
+//Ticks are CPU cycles from the DWT cycle counter on the Teensy (no overhead beyond a load) and nanoseconds
+//from std::chrono::steady_clock on the host.
+#ifdef APRS_HOST
+#include <chrono>
+static const uint32_t PROFILE_TICKS_PER_US = 1000;
+static inline uint32_t profile_ticks() {
+    return (uint32_t) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#else
+static const uint32_t PROFILE_TICKS_PER_US = F_CPU / 1000000;
+static inline uint32_t profile_ticks() {
+    return ARM_DWT_CYCCNT;
+}
+#endif
+
+void profile_begin(); //starts the cycle counter and clears every probe
+void profile_reset(ProfileProbe probe);
+void profile_record(ProfileProbe probe, uint32_t ticks);
+//Call first thing in a periodic interrupt: records the entry jitter against periodTicks. The first entry after
+//profile_isr_restart() only sets the reference.
+void profile_isr_entry(uint32_t periodTicks);
+void profile_isr_restart();
+void profile_snapshot(ProfileProbe probe, ProfileStats* out); //consistent copy, taken with interrupts off
+//Prints every probe that has samples. The stats are copied out one probe at a time with interrupts briefly
+//disabled and printed from the copy, so calling this from loop() while transmitting doesn't hold off radioISR.
+void profile_dump(Stream& out);
+
+class ProfileScope
+{
+public:
+    ProfileScope(ProfileProbe probe) : probe(probe), start(profile_ticks()) {}
+    ~ProfileScope() { profile_record(probe, profile_ticks() - start); }
+private:
+    ProfileProbe probe;
+    uint32_t start;
+};
+
+#if APRS_PROFILE
+#define PROFILE_SCOPE(probe) ProfileScope profileScope(probe)
+#define PROFILE_ISR_ENTRY(periodTicks) profile_isr_entry(periodTicks)
+#define PROFILE_ISR_RESTART() profile_isr_restart()
+#else
+#define PROFILE_SCOPE(probe)
+#define PROFILE_ISR_ENTRY(periodTicks)
+#define PROFILE_ISR_RESTART()
+#endif
+
+#endif // PROFILE_H
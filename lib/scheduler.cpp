@@ -0,0 +1,90 @@
+#include "scheduler.h"
+
+static const uint32_t DAY_MS = 86400000;
+
+BeaconScheduler::BeaconScheduler(const SmartBeaconConfig& config) : smart(config), minInterval(BEACON_MIN_INTERVAL_MS),
+    slotPeriod(0), slotOffset(0), slotWindow(0), timeValid(false), timeOfDay(0), timeStamp(0), speed(0), heading(0),
+    sentAny(false), lastBeacon(0), lastHeading(0), lastReason(BEACON_NONE) {
+}
+
+void BeaconScheduler::setFixedInterval(uint32_t ms) {
+    smart.slowRate = smart.fastRate = ms;
+    smart.slowSpeed = smart.fastSpeed = 0xFFFF; //never moving fast enough to peg a corner
+}
+
+void BeaconScheduler::setSlot(uint16_t periodSeconds, uint16_t offsetSeconds, uint8_t windowSeconds) {
+    slotPeriod = periodSeconds * 1000UL;
+    slotOffset = periodSeconds ? offsetSeconds % periodSeconds * 1000UL : 0;
+    slotWindow = windowSeconds * 1000UL;
+}
+
+void BeaconScheduler::setTime(uint8_t dayOfMonth, uint8_t hour, uint8_t min, uint8_t sec, uint32_t now) {
+    (void) dayOfMonth; //slots repeat every day
+    timeOfDay = ((hour * 60UL + min) * 60 + sec) * 1000;
+    timeStamp = now;
+    timeValid = true;
+}
+
+void BeaconScheduler::setMotion(uint16_t speedKnots, uint16_t newHeading) {
+    speed = speedKnots;
+    heading = newHeading % 360;
+}
+
+uint32_t BeaconScheduler::interval() const {
+    if(speed <= smart.slowSpeed) {
+        return smart.slowRate;
+    }
+    if(speed >= smart.fastSpeed) {
+        return smart.fastRate;
+    }
+    return (uint32_t) ((uint64_t) smart.fastRate * smart.fastSpeed / speed);
+}
+
+//Whether now falls within the window at the start of our slot
+bool BeaconScheduler::inSlot(uint32_t now) const {
+    const uint32_t time = (timeOfDay + (now - timeStamp)) % DAY_MS;
+    return (time + slotPeriod - slotOffset) % slotPeriod < slotWindow;
+}
+
+BeaconReason BeaconScheduler::due(uint32_t now) const {
+    if(!sentAny) {
+        return BEACON_FIRST;
+    }
+    const uint32_t elapsed = now - lastBeacon;
+    if(elapsed < minInterval) {
+        return BEACON_NONE;
+    }
+    if(speed > smart.slowSpeed && elapsed >= smart.minTurnTime) {
+        uint16_t turn = heading > lastHeading ? heading - lastHeading : lastHeading - heading;
+        if(turn > 180) {
+            turn = 360 - turn;
+        }
+        if(turn >= smart.minTurnAngle + smart.turnSlope / speed) {
+            return BEACON_CORNER;
+        }
+    }
+    //with slots, an interval within half a period of running out is rounded up to this slot
+    const uint32_t slack = slotPeriod && timeValid ? slotPeriod / 2 : 0;
+    return elapsed + slack >= interval() ? BEACON_RATE : BEACON_NONE;
+}
+
+bool BeaconScheduler::poll(uint32_t now) {
+    if(timeValid && now - timeStamp >= BEACON_TIME_STALE_MS) {
+        timeValid = false; //free running until the GPS reports again
+    }
+    if(slotPeriod && timeValid) {
+        //one beacon per slot, even with a minimum interval shorter than the window
+        if(!inSlot(now) || (sentAny && now - lastBeacon < slotWindow)) {
+            return false;
+        }
+    }
+    const BeaconReason reason = due(now);
+    if(reason == BEACON_NONE) {
+        return false;
+    }
+    sentAny = true;
+    lastBeacon = now;
+    lastHeading = heading;
+    lastReason = reason;
+    return true;
+}
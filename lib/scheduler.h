@@ -0,0 +1,72 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+#include <stdint.h>
+#include "Arduino.h"
+
+//SmartBeaconing parameters. Speeds in knots, times in milliseconds, angles in degrees.
+struct SmartBeaconConfig {
+    uint16_t slowSpeed; //at or below: slowRate, and no corner pegging
+    uint32_t slowRate;
+    uint16_t fastSpeed; //at or above: fastRate; in between the interval is fastRate * fastSpeed / speed
+    uint32_t fastRate;
+    uint16_t minTurnAngle; //heading change that pegs a corner at high speed...
+    uint16_t turnSlope; //...plus turnSlope / speed at lower speeds
+    uint32_t minTurnTime; //no corner beacons closer together than this
+};
+static const SmartBeaconConfig SMARTBEACON_DEFAULTS = {3, 1800000, 50, 180000, 30, 255, 15000};
+
+static const uint32_t BEACON_MIN_INTERVAL_MS = 5000; //hard floor between any two beacons
+static const uint8_t BEACON_SLOT_WINDOW = 2; //seconds after the slot start a beacon may still begin
+static const uint32_t BEACON_TIME_STALE_MS = 600000; //GPS time older than this no longer places slots
+
+enum BeaconReason {
+    BEACON_NONE,
+    BEACON_FIRST,
+    BEACON_RATE, //the SmartBeaconing interval ran out
+    BEACON_CORNER //heading changed enough since the last beacon
+};
+
+//Decides when to beacon without blocking: call poll() from loop() and send a report when it returns true.
+//The interval follows SmartBeaconing (speed dependent rate, corner pegging on turns) with a minimum interval
+//guard. With a TDMA slot set and recent GPS time, beacons only start in our slot, so stations sharing a
+//frequency with different offsets never overlap; a due beacon waits for the next slot and an interval is
+//rounded to whole slot periods.
+class BeaconScheduler
+{
+public:
+    BeaconScheduler(const SmartBeaconConfig& config = SMARTBEACON_DEFAULTS);
+    void setSmartBeaconing(const SmartBeaconConfig& config) { smart = config; }
+    void setFixedInterval(uint32_t ms); //SmartBeaconing with equal rates and no corner pegging
+    void setMinInterval(uint32_t ms) { minInterval = ms; }
+    //Slot of windowSeconds starting offsetSeconds into every periodSeconds of UTC time of day. The period
+    //should divide 86400 so slots stay aligned across midnight. A period of 0 disables slotting.
+    void setSlot(uint16_t periodSeconds, uint16_t offsetSeconds, uint8_t windowSeconds = BEACON_SLOT_WINDOW);
+    //GPS time as passed to sendPacketGPS plus seconds, stamped with the millis() it was valid at
+    void setTime(uint8_t dayOfMonth, uint8_t hour, uint8_t min, uint8_t sec, uint32_t now);
+    void setTime(uint8_t dayOfMonth, uint8_t hour, uint8_t min, uint8_t sec) { setTime(dayOfMonth, hour, min, sec, millis()); }
+    void setMotion(uint16_t speedKnots, uint16_t heading);
+    //True when a beacon should go out now; it is then counted as sent
+    bool poll(uint32_t now);
+    bool poll() { return poll(millis()); }
+    BeaconReason reason() const { return lastReason; } //why the last poll() returned true
+    uint32_t interval() const; //current SmartBeaconing interval
+private:
+    bool inSlot(uint32_t now) const;
+    BeaconReason due(uint32_t now) const;
+    SmartBeaconConfig smart;
+    uint32_t minInterval;
+    uint32_t slotPeriod; //ms, 0 without slots
+    uint32_t slotOffset;
+    uint32_t slotWindow;
+    bool timeValid;
+    uint32_t timeOfDay; //ms since UTC midnight at timeStamp
+    uint32_t timeStamp;
+    uint16_t speed;
+    uint16_t heading;
+    bool sentAny;
+    uint32_t lastBeacon;
+    uint16_t lastHeading;
+    BeaconReason lastReason;
+};
+
+#endif // SCHEDULER_H
@@ -0,0 +1,151 @@
+#ifndef SINK_H
+#define SINK_H
+#include "Arduino.h"
+#include <stdint.h>
+#ifdef APRS_HOST
+#include <stdio.h>
+#endif
+
+//Output sinks take the modulator's unsigned Resolution-bit samples to the transmitter. They only have static
+//members and are picked at compile time (AFSK_SINK in afsk.h), so radioISR calls an inlined write and there is
+//no virtual dispatch in the sample interrupt. They all share one interface:
+//  begin()         set the output up before a key-up
+//  write(sample)   one sample, at SAMPLE_RATE
+//  idle()          park the output at mid-scale once the transmission is over
+
+//The Teensy 3.x 12 bit DAC (A14), the default
+template <uint8_t Pin, int Resolution>
+struct DACSink {
+    static void begin() {
+        analogWriteResolution(Resolution);
+    }
+    static inline void write(uint16_t sample) {
+        analogWrite(Pin, sample);
+    }
+    static void idle() {
+        analogWrite(Pin, 1 << (Resolution - 1));
+    }
+};
+
+//Whether pin has an FTM channel behind it, and so works with analogWrite. Boards not listed aren't checked.
+constexpr bool sink_pwm_pin(uint8_t pin) {
+#if defined(__MK20DX128__) || defined(__MK20DX256__) || defined(APRS_HOST) //Teensy 3.0-3.2, which the host mimics
+    return pin == 3 || pin == 4 || pin == 5 || pin == 6 || pin == 9 || pin == 10 || (pin >= 20 && pin <= 23) ||
+           pin == 25 || pin == 32;
+#elif defined(__MKL26Z64__) //Teensy LC
+    return pin == 3 || pin == 4 || pin == 6 || pin == 9 || pin == 10 || pin == 16 || pin == 17 || pin == 20 ||
+           pin == 22 || pin == 23;
+#else
+    return (void) pin, true;
+#endif
+}
+
+//PWM on a timer pin for boards without a DAC. Samples are cut down to PWMResolution bits and the carrier runs at
+//CarrierFreq, far above the tones, so a two stage RC low-pass in front of the mic input recovers the audio.
+template <uint8_t Pin, int Resolution, int PWMResolution, uint32_t CarrierFreq>
+struct PWMSink {
+    static_assert(PWMResolution <= Resolution, "the PWM cannot be finer than the samples");
+    static_assert(sink_pwm_pin(Pin), "PWM_PIN can't do PWM on this board");
+
+    static void begin() {
+        analogWriteResolution(PWMResolution);
+        analogWriteFrequency(Pin, CarrierFreq);
+    }
+    static inline void write(uint16_t sample) {
+        analogWrite(Pin, sample >> (Resolution - PWMResolution));
+    }
+    static void idle() {
+        analogWrite(Pin, 1 << (PWMResolution - 1));
+    }
+};
+
+#if defined(KINETISK)
+//Greatest common divisor, for reducing the I2S master clock fraction at compile time
+constexpr uint32_t sink_gcd(uint32_t a, uint32_t b) {
+    return b == 0 ? a : sink_gcd(b, a % b);
+}
+
+//I2S0 transmitter feeding an external codec (e.g. the SGTL5000 audio shield, which the sketch configures over
+//I2C). MCLK is 256 x SampleRate from the PLL, with 2 x 32 bit slots per frame; the sample goes to both channels.
+//The sample timer and MCLK come from the same crystal, so each timer tick finds room for one frame in the FIFO.
+//Uses pins 9 (BCLK), 11 (MCLK), 22 (TXD0) and 23 (LRCLK): AUDIO_PIN and the DRA818 serial pins have to move.
+template <int Resolution, uint32_t SampleRate>
+struct I2SSink {
+    static const int FIFO_WORDS = 8;
+    static const uint32_t MCLK_FRACT = (uint64_t) 256 * SampleRate / sink_gcd(256 * SampleRate, F_PLL);
+    static const uint32_t MCLK_DIVIDE = F_PLL / sink_gcd(256 * SampleRate, F_PLL);
+    static_assert(MCLK_FRACT <= 256 && MCLK_DIVIDE <= 4096, "no exact I2S master clock for this sample rate");
+
+    static void begin() {
+        if(I2S0_TCSR & I2S_TCSR_TE) {
+            return;
+        }
+        SIM_SCGC6 |= SIM_SCGC6_I2S;
+        I2S0_MCR = I2S_MCR_MICS(3) | I2S_MCR_MOE; //MCLK from the PLL, driven out on pin 11
+        while(I2S0_MCR & I2S_MCR_DUF);
+        I2S0_MDR = I2S_MDR_FRACT(MCLK_FRACT - 1) | I2S_MDR_DIVIDE(MCLK_DIVIDE - 1);
+        I2S0_TMR = 0;
+        I2S0_TCR1 = I2S_TCR1_TFW(FIFO_WORDS - 2); //request once there is room for a whole frame
+        I2S0_TCR2 = I2S_TCR2_SYNC(0) | I2S_TCR2_BCP | I2S_TCR2_MSEL(1) | I2S_TCR2_BCD | I2S_TCR2_DIV(1);
+        I2S0_TCR3 = I2S_TCR3_TCE;
+        I2S0_TCR4 = I2S_TCR4_FRSZ(1) | I2S_TCR4_SYWD(31) | I2S_TCR4_MF | I2S_TCR4_FSE | I2S_TCR4_FSP | I2S_TCR4_FSD;
+        I2S0_TCR5 = I2S_TCR5_WNW(31) | I2S_TCR5_W0W(31) | I2S_TCR5_FBT(31);
+        CORE_PIN9_CONFIG = PORT_PCR_MUX(6);
+        CORE_PIN11_CONFIG = PORT_PCR_MUX(6);
+        CORE_PIN22_CONFIG = PORT_PCR_MUX(6);
+        CORE_PIN23_CONFIG = PORT_PCR_MUX(6);
+        I2S0_TCSR = I2S_TCSR_TE | I2S_TCSR_BCE | I2S_TCSR_FR;
+    }
+    static inline void write(uint16_t sample) {
+        if(!(I2S0_TCSR & I2S_TCSR_FRF)) {
+            return; //FIFO still full, drop rather than stall the interrupt
+        }
+        const uint32_t word = (uint32_t) ((int32_t) sample - (1 << (Resolution - 1))) << (32 - Resolution);
+        I2S0_TDR0 = word;
+        I2S0_TDR0 = word;
+    }
+    static void idle() {
+        while(I2S0_TCSR & I2S_TCSR_FRF) {
+            I2S0_TDR0 = 0; //fill the FIFO with silence until it is full
+        }
+    }
+};
+#endif
+
+#ifdef APRS_HOST
+//Host only: signed 16-bit little-endian PCM written straight to a stdio stream (stdout unless the tool sets
+//another one), so samples can be piped into a decoder or sox as they are produced. Flushed after every
+//transmission.
+template <int Resolution>
+struct PCMStreamSink {
+    static FILE* stream;
+
+    static void begin() {}
+    static inline void write(uint16_t sample) {
+        const int16_t pcm = (int16_t) (((int32_t) sample - (1 << (Resolution - 1))) << (16 - Resolution));
+        const uint8_t bytes[2] = {(uint8_t) pcm, (uint8_t) (pcm >> 8)};
+        fwrite(bytes, 1, 2, stream);
+    }
+    static void idle() {
+        fflush(stream);
+    }
+};
+
+template <int Resolution>
+FILE* PCMStreamSink<Resolution>::stream = stdout;
+#endif
+
+//Plays the bits loaded into a modulator straight into a sink, for rendering that is not paced by the sample
+//timer. Returns the number of samples written.
+template <class Sink, class Modulator>
+static inline uint32_t sink_play(Modulator& modem) {
+    uint32_t count = 0;
+    uint16_t sample;
+    while(modem.next(&sample)) {
+        Sink::write(sample);
+        count++;
+    }
+    return count;
+}
+
+#endif // SINK_H
@@ -0,0 +1,165 @@
+#include "telemetry.h"
+#include "aprs_compressed.h"
+#include "txqueue.h"
+#include <string.h>
+
+static const char* const DEFINITION_KEYWORDS[4] = {"PARM.", "UNIT.", "EQNS.", "BITS."};
+static const uint8_t ALL_DEFINITIONS = 0x0F;
+
+//Decimal with at least width digits; returns the characters written
+static int formatDecimal(char* out, int32_t value, int width) {
+    int length = 0;
+    uint32_t magnitude = value < 0 ? 0u - (uint32_t) value : (uint32_t) value;
+    if(value < 0) {
+        out[length++] = '-';
+    }
+    char digits[10];
+    int count = 0;
+    do {
+        digits[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while(magnitude);
+    while(count < width--) {
+        out[length++] = '0';
+    }
+    while(count) {
+        out[length++] = digits[--count];
+    }
+    return length;
+}
+
+int aprs_telemetry_report(char* out, uint16_t sequence, const int32_t* analog, uint8_t channels, uint8_t digital) {
+    int length = 0;
+    out[length++] = 'T';
+    out[length++] = '#';
+    length += formatDecimal(out + length, sequence % 1000, 3);
+    for(int i = 0; i < APRS_TELEMETRY_CHANNELS; i++) {
+        out[length++] = ',';
+        length += formatDecimal(out + length, i < channels ? analog[i] : 0, 3);
+    }
+    out[length++] = ',';
+    for(int i = 7; i >= 0; i--) {
+        out[length++] = '0' + ((digital >> i) & 1);
+    }
+    out[length] = 0;
+    return length;
+}
+
+int aprs_telemetry_base91(char* out, uint16_t sequence, const int32_t* analog, uint8_t channels, bool withDigital, uint8_t digital) {
+    if(channels > APRS_TELEMETRY_CHANNELS) {
+        channels = APRS_TELEMETRY_CHANNELS;
+    }
+    int length = 0;
+    out[length++] = '|';
+    base91_encode(sequence % TELEMETRY_BASE91_LIMIT, out + length, 2);
+    length += 2;
+    //the digital value is only read after all five analog channels, so missing ones are sent as 0 in front of it
+    const int fields = withDigital ? APRS_TELEMETRY_CHANNELS : channels;
+    for(int i = 0; i < fields; i++) {
+        const int32_t raw = i < channels ? analog[i] : 0;
+        const int32_t value = raw < 0 ? 0 : raw >= TELEMETRY_BASE91_LIMIT ? TELEMETRY_BASE91_LIMIT - 1 : raw;
+        base91_encode(value, out + length, 2);
+        length += 2;
+    }
+    if(withDigital) {
+        //this format carries B1 in the least significant bit
+        uint8_t reversed = 0;
+        for(int i = 0; i < 8; i++) {
+            reversed |= ((digital >> i) & 1) << (7 - i);
+        }
+        base91_encode(reversed, out + length, 2);
+        length += 2;
+    }
+    out[length++] = '|';
+    out[length] = 0;
+    return length;
+}
+
+Telemetry::Telemetry(APRS* aprs, const SSID& station) : aprs(aprs), pending(0),
+    definitionInterval(TELEMETRY_DEFINITION_INTERVAL), sinceDefinitions(0), next(0), channels(0), digital(0) {
+    memset(definitions, 0, sizeof(definitions));
+    memset(analog, 0, sizeof(analog));
+    memset(addressee, ' ', sizeof(addressee));
+    addressee[0] = ':';
+    int length = 1;
+    for(int i = 0; station.address[i] && i < AX25_CALLSIGN_LENGTH; i++) {
+        addressee[length++] = station.address[i];
+    }
+    if(station.ssid_designator) {
+        addressee[length++] = '-';
+        length += formatDecimal(addressee + length, station.ssid_designator, 1);
+    }
+    addressee[APRS_ADDRESSEE_LENGTH + 1] = ':';
+}
+
+void Telemetry::setDefinitions(const char* parm, const char* unit, const char* eqns, const char* bits) {
+    definitions[0] = parm;
+    definitions[1] = unit;
+    definitions[2] = eqns;
+    definitions[3] = bits;
+    pending = ALL_DEFINITIONS;
+    sinceDefinitions = 0;
+}
+
+void Telemetry::setChannels(const int32_t* values, uint8_t count, uint8_t bits) {
+    channels = count < APRS_TELEMETRY_CHANNELS ? count : APRS_TELEMETRY_CHANNELS;
+    memcpy(analog, values, channels * sizeof(int32_t));
+    digital = bits;
+}
+
+bool Telemetry::send() {
+    aprs_telemetry_report(buffer, next, analog, channels, digital);
+    if(!aprs->sendPacketNoGPS(buffer)) {
+        return false;
+    }
+    advance(0);
+    return true;
+}
+
+const char* Telemetry::comment(const char* text) {
+    const int length = aprs_telemetry_base91(buffer, next, analog, channels, true, digital);
+    strncpy(buffer + length, text, TELEMETRY_COMMENT_MAX - length);
+    buffer[TELEMETRY_COMMENT_MAX] = 0;
+    advance(1);
+    return buffer;
+}
+
+//Counts a report, marks the definitions due every definitionInterval reports and queues them with reserve slots
+//left free
+void Telemetry::advance(uint8_t reserve) {
+    next = (next + 1) % 1000; //T# sequence numbers are three digits
+    if(definitionInterval && ++sinceDefinitions > definitionInterval) {
+        sinceDefinitions = 1; //this report is the first of the new interval
+        pending = ALL_DEFINITIONS;
+    }
+    sendDefinitions(reserve);
+}
+
+//Keeps the last free slot for the next position report
+void Telemetry::poll() {
+    sendDefinitions(1);
+}
+
+void Telemetry::sendDefinitions(uint8_t reserve) {
+    char message[APRS_ADDRESSEE_LENGTH + 2 + TELEMETRY_MESSAGE_MAX + 1]; //the keyword counts towards the text limit
+    for(int i = 0; i < 4 && pending; i++) {
+        if(!(pending & (1 << i))) {
+            continue;
+        }
+        if(!definitions[i]) {
+            pending &= ~(1 << i);
+            continue;
+        }
+        if(txQueue.queued() + reserve >= TX_QUEUE_SLOTS) {
+            return;
+        }
+        memcpy(message, addressee, sizeof(addressee));
+        memcpy(message + sizeof(addressee), DEFINITION_KEYWORDS[i], 5);
+        strncpy(message + sizeof(addressee) + 5, definitions[i], TELEMETRY_MESSAGE_MAX - 5);
+        message[sizeof(addressee) + TELEMETRY_MESSAGE_MAX] = 0; //strncpy leaves a definition that was cut short open
+        if(!aprs->sendPacketNoGPS(message)) {
+            return;
+        }
+        pending &= ~(1 << i);
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+#include <stdint.h>
+#include "aprs.h"
+#include "aprs_parse.h"
+
+static const int TELEMETRY_REPORT_MAX = 2 + 4 + APRS_TELEMETRY_CHANNELS * 12 + 8; //T#sss, then 5 int32 values and the bits
+static const int TELEMETRY_BASE91_MAX = 1 + 2 + APRS_TELEMETRY_CHANNELS * 2 + 2 + 1; //|ss1122334455dd|
+static const int TELEMETRY_COMMENT_MAX = 80;
+static const int TELEMETRY_MESSAGE_MAX = 67; //text limit of an APRS message
+static const uint16_t TELEMETRY_DEFINITION_INTERVAL = 20; //reports between definition frames
+static const uint16_t TELEMETRY_BASE91_LIMIT = 91 * 91; //values and sequence numbers are 0 to 8280
+
+//Formatters; analog values are plain integers (usually 0-255), digital has B1 in the most significant bit.
+//"T#sss,aaa,aaa,aaa,aaa,aaa,bbbbbbbb", always 5 analog fields, missing channels sent as 0. Returns the length.
+int aprs_telemetry_report(char* out, uint16_t sequence, const int32_t* analog, uint8_t channels, uint8_t digital);
+//"|ss1122...|" comment extension: 1-5 channels, each clamped to 0-8280, and the digital byte if withDigital,
+//which always follows five analog values (channels beyond count are sent as 0)
+int aprs_telemetry_base91(char* out, uint16_t sequence, const int32_t* analog, uint8_t channels, bool withDigital, uint8_t digital);
+
+//Telemetry for one station. Channel values are set as integers and reported either as T# frames (send()) or as
+//a base-91 extension in the comment of a position report (comment()); both advance the sequence number. The
+//PARM/UNIT/EQNS/BITS definition messages, addressed to the station itself, go out with the first report and then
+//every definition interval reports. With comment() they leave a transmit slot free for the position report that
+//carries it; whatever did not fit waits for poll() or the next report.
+class Telemetry
+{
+public:
+    Telemetry(APRS* aprs, const SSID& station);
+    //Texts after "PARM." etc., e.g. "Vbat,Temp"; 0 to leave one out. The strings must outlive the object.
+    void setDefinitions(const char* parm, const char* unit, const char* eqns, const char* bits = 0);
+    void setDefinitionInterval(uint16_t reports) { definitionInterval = reports; } //0: only with the first report
+    void setChannels(const int32_t* analog, uint8_t count, uint8_t digital);
+    void setDigital(uint8_t bits) { digital = bits; }
+    bool send(); //queues a T# frame; false if the queue was full
+    //Returns "|ss...|" followed by text, to pass as the comment of a sendPacket* call. Valid until the next call.
+    const char* comment(const char* text = "");
+    void poll(); //sends pending definitions as the queue drains, call it from loop()
+    uint16_t sequence() const { return next; } //of the next report
+private:
+    void advance(uint8_t reserve);
+    void sendDefinitions(uint8_t reserve);
+    APRS* aprs;
+    char addressee[APRS_ADDRESSEE_LENGTH + 2]; //":CALL-SS  :" padded, without a terminator
+    const char* definitions[4];
+    uint8_t pending; //bit per definition still to send
+    uint16_t definitionInterval;
+    uint16_t sinceDefinitions;
+    uint16_t next;
+    uint8_t channels;
+    int32_t analog[APRS_TELEMETRY_CHANNELS];
+    uint8_t digital;
+    char buffer[TELEMETRY_COMMENT_MAX + 1];
+};
+
+#endif // TELEMETRY_H
@@ -0,0 +1,54 @@
+#include "txqueue.h"
+#include "Arduino.h"
+
+TxQueue txQueue;
+
+TxFrame* TxQueue::reserve() {
+    if(count == TX_QUEUE_SLOTS) {
+        return 0;
+    }
+    return &slots[tail];
+}
+
+void TxQueue::commit(int size, uint8_t channel) {
+    slots[tail].size = size;
+    slots[tail].channel = channel;
+    slots[tail].streamed = false;
+    tail = (tail + 1) % TX_QUEUE_SLOTS;
+    noInterrupts();
+    count++;
+    interrupts();
+}
+
+void TxQueue::commitStream(const AX25FrameSource& source, uint8_t channel) {
+    slots[tail].source = source;
+    slots[tail].streamed = true;
+    slots[tail].size = 0;
+    slots[tail].channel = channel;
+    tail = (tail + 1) % TX_QUEUE_SLOTS;
+    noInterrupts();
+    count++;
+    interrupts();
+}
+
+TxFrame* TxQueue::front() {
+    if(count == 0) {
+        return 0;
+    }
+    return &slots[head];
+}
+
+void TxQueue::pop() {
+    if(count == 0) {
+        return;
+    }
+    head = (head + 1) % TX_QUEUE_SLOTS;
+    count--;
+}
+
+void TxQueue::clear() {
+    noInterrupts();
+    head = tail;
+    count = 0;
+    interrupts();
+}
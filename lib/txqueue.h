@@ -0,0 +1,42 @@
+#ifndef TXQUEUE_H
+#define TXQUEUE_H
+#include <stdint.h>
+#include "ax25_stream.h"
+
+static const int BUFFER_SIZE_MAX = 264; //bytes of encoded bitstream per frame, enough for the longest FX.25 frame
+static const uint8_t TX_QUEUE_SLOTS = 4; //frames that can wait for the transmitter
+
+//An encoded frame: the stuffed HDLC bitstream, packed in transmit order, and its length in bits. A streamed
+//frame leaves bits unused and is encoded from its source while it is played (AX25Stream).
+struct TxFrame {
+    uint8_t bits[BUFFER_SIZE_MAX];
+    int size;
+    uint8_t channel; //DRA818V channel plan entry it is sent on
+    bool streamed;
+    AX25FrameSource source;
+};
+
+//Fixed pool of frame slots used as a ring: the sketch reserves a slot, encodes into it and commits it,
+//the modulator interrupt plays committed frames in order and releases them. One producer and one consumer,
+//so the indexes need no locking.
+class TxQueue
+{
+public:
+    TxQueue() : head(0), tail(0), count(0) {}
+    TxFrame* reserve(); //the slot the next frame is encoded into, or 0 while every slot is queued
+    void commit(int size, uint8_t channel = 0); //queue the reserved slot
+    void commitStream(const AX25FrameSource& source, uint8_t channel = 0); //queue it as a streamed frame
+    TxFrame* front(); //oldest queued frame, or 0 if there is none
+    void pop(); //release the front frame
+    void clear();
+    uint8_t queued() const { return count; }
+private:
+    TxFrame slots[TX_QUEUE_SLOTS];
+    volatile uint8_t head;
+    volatile uint8_t tail;
+    volatile uint8_t count;
+};
+
+extern TxQueue txQueue;
+
+#endif // TXQUEUE_H